@@ -3,6 +3,8 @@
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/Input/SButton.h"
 #include "Widgets/Views/SListView.h"
+#include "Widgets/Views/STreeView.h"
+#include "Widgets/Input/SSearchBox.h"
 #include "Engine/Texture2D.h"
 #include "TextureUtils.h"
 #include "Editor.h"
@@ -16,11 +18,23 @@
 #include "NotificationManager.h"
 #include "Widgets/Notifications/SNotificationList.h"
 #include "Misc/ScopedSlowTask.h"
-#include "ReferencedAssetsUtils.h"
-#include "Engine/LevelStreaming.h"
+#include "WorldReferenceGenerator.h"
+#include "TextureToolStats.h"
 #include "EngineUtils.h"
-#include "AssetThumbnail.h"
+#include "TextureThumbnailCache.h"
+#include "TextureSelectionTracker.h"
+#include "TextureChannelAnalyzer.h"
+#include "TextureDensityAnalyzer.h"
+#include "TextureAnalysisCache.h"
+#include "TexturePackingPlanner.h"
+#include "TextureAtlasBuilder.h"
+#include "TextureBatchEstimator.h"
+#include "TextureKeywordMiner.h"
+#include "Engine/DataTable.h"
+#include "EditorDirectories.h"
+#include "Widgets/Images/SImage.h"
 #include "MultiBoxBuilder.h"
+#include "Widgets/Input/SComboButton.h"
 #include "Widgets/Views/STableViewBase.h"
 #include "Widgets/Views/STableRow.h"
 #include "EditorStyle.h"
@@ -33,9 +47,16 @@
 #include "Widgets/Layout/SBox.h"
 #define LOCTEXT_NAMESPACE "TextureToolUI"
 
+DECLARE_CYCLE_STAT(TEXT("Update Texture List"), STAT_TextureTool_UpdateTextureList, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Find Actors"), STAT_TextureTool_FindActors, STATGROUP_TextureTool);
+
+const int32 ThumbnailSize = 72;
+/** Rows kept warm in the thumbnail cache above and below the visible window */
+const int32 ThumbnailPrefetchMargin = 16;
+
 void STextureToolUI::Construct(const FArguments& InArgs)
 {
-	AssetThumbnailPool = MakeShareable(new FAssetThumbnailPool(24));
+	ThumbnailCache = MakeShareable(new FTextureThumbnailCache(ThumbnailSize, 24));
 	CreateDetailView();
 	Mode = EToolMode::TextureFinder;
 	ChildSlot.Padding(FMargin(8))
@@ -56,12 +77,23 @@ void STextureToolUI::Construct(const FArguments& InArgs)
 	];
 	FinderWidget = CreateFinderWidget()->AsShared();
 	MergerWidget = CreateMergerWidget()->AsShared();
+	AuditWidget = CreateAuditWidget()->AsShared();
 	InlineContentHolder->SetContent(FinderWidget->AsShared());
 }
 
 void STextureToolUI::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
 {
-	AssetThumbnailPool->Tick(InDeltaTime);
+	if (TextureListView.IsValid() && TextureListItems.Num() > 0)
+	{
+		// Size the cache to what is on screen and prefetch a margin around it so scrolling never waits
+		const int32 NumVisible = FMath::Max(TextureListView->GetNumGeneratedChildren(), 1);
+		const int32 First = FMath::Max(FMath::FloorToInt(TextureListView->GetScrollOffset()) - ThumbnailPrefetchMargin, 0);
+		const int32 Last = FMath::Min(First + NumVisible + 2 * ThumbnailPrefetchMargin, TextureListItems.Num());
+		ThumbnailCache->SetCapacity(NumVisible + 2 * ThumbnailPrefetchMargin);
+		for (int32 Index = First; Index < Last; ++Index)
+			ThumbnailCache->Prefetch(TextureListItems[Index]->Texture);
+	}
+	ThumbnailCache->Tick();
 }
 
 static bool IsAContentBrowserAsset(UObject* Object, FString& OutFailureReason)
@@ -99,25 +131,21 @@ static bool IsAContentBrowserAsset(UObject* Object, FString& OutFailureReason)
 
 void STextureToolUI::UpdateTextureListItems()
 {
-	TArray<UObject*> SelectedActors;
-	GEditor->GetSelectedActors()->GetSelectedObjects(AActor::StaticClass(), /*out*/ SelectedActors);
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_UpdateTextureList);
+	// Tracker keeps the selected actors' textures up to date, each texture is reported once
+	TArray<UTexture2D*> FoundTextures = FTextureSelectionTracker::Get().GetTextures();
 	TArray<UObject*> Textures;
-	for (auto Object : SelectedActors)
+	for (auto Texture : FoundTextures)
 	{
-		auto Actor = Cast<AActor>(Object);
-		auto FoundTextures = FTextureToolUtils::FindTextures(Actor);
-		for (auto Texture : FoundTextures)
+		FString FailureReason;
+		if (!IsAContentBrowserAsset(Texture, FailureReason))
 		{
-			FString FailureReason;
-			if (!IsAContentBrowserAsset(Texture, FailureReason))
-			{
-				UE_LOG(LogTemp, Warning, TEXT("Find runtime texture %s, Size = (%d, %d)."), *FailureReason, Texture->GetSizeX(), Texture->GetSizeY());
-			}
-			else
-			{
-				Textures.AddUnique(Texture);
-				UE_LOG(LogTemp, Warning, TEXT("Find texture asset %s, Size = (%d, %d)"), *Texture->GetPathName(), Texture->GetSizeX(), Texture->GetSizeY());
-			}
+			UE_LOG(LogTemp, Warning, TEXT("Find runtime texture %s, Size = (%d, %d)."), *FailureReason, Texture->GetSizeX(), Texture->GetSizeY());
+		}
+		else
+		{
+			Textures.Add(Texture);
+			UE_LOG(LogTemp, Warning, TEXT("Find texture asset %s, Size = (%d, %d)"), *Texture->GetPathName(), Texture->GetSizeX(), Texture->GetSizeY());
 		}
 	}
 	TextureListItems.Reset();
@@ -125,6 +153,10 @@ void STextureToolUI::UpdateTextureListItems()
 	{
 		TSharedPtr<FTextureListItem> Item = MakeShared<FTextureListItem>();
 		Item->Texture = Texture;
+		// Channels analyzed by an earlier audit or session show up without analyzing again
+		FTextureChannelReport Report;
+		if (FTextureAnalysisCache::Get().Find(Texture->Source.GetId(), ETextureAnalysis::Channels, FTextureChannelAnalyzer::CacheVersion, Report))
+			Item->ChannelReport = MakeShared<FTextureChannelReport>(Report);
 		TextureListItems.Add(Item);
 	}
 	if (TextureListView.IsValid())
@@ -149,6 +181,14 @@ TSharedPtr<SWidget> STextureToolUI::CreateToolBarWidget()
 				SettingsDetailsView->SetObject(UTextureMergeSettings::Get());
 				Mode = EToolMode::TextureMerger;
 			}), FCanExecuteAction(), FIsActionChecked::CreateLambda([=]() -> bool { return Mode == EToolMode::TextureMerger; })), NAME_None, LOCTEXT("Mode.TextureMerging", "Merge"), LOCTEXT("Mode.TextureMerging.Tooltip", "Texture merging mode allows merge texture channels"), WeightPaintIcon, EUserInterfaceActionType::ToggleButton);
+
+		FSlateIcon TexturePaintIcon(FEditorStyle::GetStyleSetName(), "LevelEditor.MeshPaintMode.TexturePaint");
+		ModeSwitchButtons.AddToolBarButton(FUIAction(FExecuteAction::CreateLambda([=]()
+			{
+				InlineContentHolder->SetContent(AuditWidget->AsShared());
+				AuditDetailsView->SetObject(UTextureAuditSettings::Get());
+				Mode = EToolMode::TextureAudit;
+			}), FCanExecuteAction(), FIsActionChecked::CreateLambda([=]() -> bool { return Mode == EToolMode::TextureAudit; })), NAME_None, LOCTEXT("Mode.TextureAudit", "Audit"), LOCTEXT("Mode.TextureAudit.Tooltip", "Texture audit mode scans a content directory for wasteful textures"), TexturePaintIcon, EUserInterfaceActionType::ToggleButton);
 	}
 
 	return ModeSwitchButtons.MakeWidget();
@@ -179,6 +219,12 @@ TSharedPtr<SWidget> STextureToolUI::CreateFinderWidget()
 				+ SHeaderRow::Column("TextureSourceSize").VAlignCell(VAlign_Center)
 				.DefaultLabel(LOCTEXT("TextureSourceSize", "SourceSize"))
 				.FillWidth(200)
+				+ SHeaderRow::Column("TextureChannels").VAlignCell(VAlign_Center)
+				.DefaultLabel(LOCTEXT("TextureChannels", "Channels"))
+				.FillWidth(250)
+				+ SHeaderRow::Column("TextureDensity").VAlignCell(VAlign_Center)
+				.DefaultLabel(LOCTEXT("TextureDensity", "Suggested"))
+				.FillWidth(200)
 			)
 		]
 	]
@@ -186,6 +232,15 @@ TSharedPtr<SWidget> STextureToolUI::CreateFinderWidget()
 	[
 		SNew(SHorizontalBox)
 		+ SHorizontalBox::Slot().FillWidth(1.f)
+		+ SHorizontalBox::Slot().FillWidth(0.15f).Padding(0.f, 0.f, 10.f, 0.f)
+		[
+			SNew(SButton)
+			.IsEnabled(this, &STextureToolUI::CanBuildAtlas)
+			.Text(LOCTEXT("BuildAtlas", "Build Atlas"))
+			.HAlign(HAlign_Center)
+			.ToolTipText(LOCTEXT("BuildAtlasTip", "Pack the selected textures, or every listed texture, into one atlas with a UV rect table. Only color textures up to 256 px are taken"))
+			.OnClicked(this, &STextureToolUI::OnBuildAtlasClicked)
+		]
 		+ SHorizontalBox::Slot().FillWidth(0.15f)
 		[
 			SNew(SBox)
@@ -215,6 +270,13 @@ TSharedPtr<SWidget> STextureToolUI::CreateMergerWidget()
 	[
 		SNew(SHorizontalBox)
 		+ SHorizontalBox::Slot().FillWidth(1.f)
+		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(0, 0, 10.f, 0)
+		[
+			SNew(SButton).HAlign(HAlign_Center)
+			.Text(LOCTEXT("SavePreset", "Save Preset"))
+			.ToolTipText(LOCTEXT("SavePresetTip", "Save the channels as a preset asset, presets listed in Presets are batched together"))
+			.OnClicked(this, &STextureToolUI::OnSavePresetClicked)
+		]
 		+ SHorizontalBox::Slot().FillWidth(0.2f)
 		[
 			SNew(SButton).HAlign(HAlign_Center)
@@ -224,6 +286,17 @@ TSharedPtr<SWidget> STextureToolUI::CreateMergerWidget()
 			.OnClicked(this, &STextureToolUI::OnAutoSuffixClicked)
 			
 		]	
+		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(10.f, 0, 0, 0)
+		[
+			SNew(SComboButton)
+			.IsEnabled(this, &STextureToolUI::CanBatch)
+			.ToolTipText(LOCTEXT("MineKeywordsTip", "Keywords giving the most complete groups under the input directory"))
+			.OnGetMenuContent(this, &STextureToolUI::OnGetMineKeywordsMenu)
+			.ButtonContent()
+			[
+				SNew(STextBlock).Text(LOCTEXT("MineKeywords", "Mine Keywords"))
+			]
+		]
 		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(10.f, 0)
 		[
 			SNew(SButton).HAlign(HAlign_Center)
@@ -243,6 +316,90 @@ TSharedPtr<SWidget> STextureToolUI::CreateMergerWidget()
 	];
 }
 
+TSharedPtr<SWidget> STextureToolUI::CreateAuditWidget()
+{
+	return SNew(SVerticalBox)
+	+ SVerticalBox::Slot().AutoHeight()
+	[
+		AuditDetailsView->AsShared()
+	]
+	+ SVerticalBox::Slot().FillHeight(1.f).Padding(0.f, 5.f, 0.f, 0.f)
+	[
+		SNew(SBorder).BorderImage(FEditorStyle::GetBrush("ToolPanel.GroupBorder"))
+		[
+			SAssignNew(AuditListView, SAuditListView)
+			.ListItemsSource(&AuditListItems)
+			.OnGenerateRow(this, &STextureToolUI::OnGenerateWidgetForAuditListView)
+			.OnContextMenuOpening(this, &STextureToolUI::CreateAuditContextMenu)
+			.HeaderRow
+			(
+				SNew(SHeaderRow)
+				+ SHeaderRow::Column("AuditTexture").VAlignCell(VAlign_Center)
+				.DefaultLabel(LOCTEXT("AuditTexture", "Texture"))
+				.FillWidth(400)
+				+ SHeaderRow::Column("AuditIssue").VAlignCell(VAlign_Center)
+				.DefaultLabel(LOCTEXT("AuditIssue", "Issue"))
+				.FillWidth(250)
+				+ SHeaderRow::Column("AuditSuggestion").VAlignCell(VAlign_Center)
+				.DefaultLabel(LOCTEXT("AuditSuggestion", "Suggestion"))
+				.FillWidth(250)
+			)
+		]
+	]
+	+ SVerticalBox::Slot().AutoHeight().Padding(0.f, 10.f, 0.f, 0.f)
+	[
+		SNew(SHorizontalBox)
+		+ SHorizontalBox::Slot().FillWidth(1.f)
+		+ SHorizontalBox::Slot().FillWidth(0.2f)
+		[
+			SNew(SButton).HAlign(HAlign_Center)
+			.IsEnabled(this, &STextureToolUI::CanScanAudit)
+			.Text(LOCTEXT("FindDuplicates", "Find Duplicates"))
+			.ToolTipText(LOCTEXT("FindDuplicatesTip", "Find textures with byte identical source data"))
+			.OnClicked(this, &STextureToolUI::OnFindDuplicatesClicked)
+		]
+		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(10.f, 0.f, 0.f, 0.f)
+		[
+			SNew(SButton).HAlign(HAlign_Center)
+			.IsEnabled(this, &STextureToolUI::CanScanAudit)
+			.Text(LOCTEXT("FindChannelWaste", "Find Channel Waste"))
+			.ToolTipText(LOCTEXT("FindChannelWasteTip", "Find textures with constant, duplicated or unused channels"))
+			.OnClicked(this, &STextureToolUI::OnFindChannelWasteClicked)
+		]
+		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(10.f, 0.f, 0.f, 0.f)
+		[
+			SNew(SButton).HAlign(HAlign_Center)
+			.IsEnabled(this, &STextureToolUI::CanScanAudit)
+			.Text(LOCTEXT("FindCompressionWaste", "Find Compression Waste"))
+			.ToolTipText(LOCTEXT("FindCompressionWasteTip", "Classify textures by content and propose compression, sRGB, LOD group and streaming settings"))
+			.OnClicked(this, &STextureToolUI::OnFindCompressionWasteClicked)
+		]
+		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(10.f, 0.f, 0.f, 0.f)
+		[
+			SNew(SButton).HAlign(HAlign_Center)
+			.Text(LOCTEXT("PlanPacking", "Plan Packing"))
+			.ToolTipText(LOCTEXT("PlanPackingTip", "Propose single channel textures of the current level to pack together, from how its materials sample them"))
+			.OnClicked(this, &STextureToolUI::OnPlanPackingClicked)
+		]
+		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(10.f, 0.f, 0.f, 0.f)
+		[
+			SNew(SButton).HAlign(HAlign_Center)
+			.IsEnabled(this, &STextureToolUI::CanConsolidate)
+			.Text(LOCTEXT("ConsolidateDuplicates", "Consolidate"))
+			.ToolTipText(LOCTEXT("ConsolidateDuplicatesTip", "Replace duplicates of the selected groups, or of every group after a confirmation if nothing is selected, by the first texture of their group"))
+			.OnClicked(this, &STextureToolUI::OnConsolidateClicked)
+		]
+		+ SHorizontalBox::Slot().FillWidth(0.2f).Padding(10.f, 0.f, 0.f, 0.f)
+		[
+			SNew(SButton).HAlign(HAlign_Center)
+			.IsEnabled(this, &STextureToolUI::CanApplyCompression)
+			.Text(LOCTEXT("ApplyCompression", "Apply Compression"))
+			.ToolTipText(LOCTEXT("ApplyCompressionTip", "Apply proposed settings to the selected textures, or after confirmation to every proposal if nothing is selected, and rebuild them together"))
+			.OnClicked(this, &STextureToolUI::OnApplyCompressionClicked)
+		]
+	];
+}
+
 TSharedPtr<SWidget> STextureToolUI::CreateTextureContextMenu()
 {
 	FMenuBuilder MenuBuilder(true, NULL);
@@ -275,6 +432,28 @@ TSharedPtr<SWidget> STextureToolUI::CreateTextureContextMenu()
 		const FText ToolTipText = LOCTEXT("ResetSizeButtonTooltip", "Reset selected textures' size to max");
 		MenuBuilder.AddMenuEntry(Label, ToolTipText, FSlateIcon(), Action);
 	}
+
+	{
+		FUIAction Action = FUIAction(FExecuteAction::CreateSP(this, &STextureToolUI::OnApplySuggestedSizeClicked), FCanExecuteAction::CreateSP(this, &STextureToolUI::CanApplySuggestedSize));
+		const FText Label = LOCTEXT("ApplySuggestedSizeButtonLabel", "Apply Suggested Size");
+		const FText ToolTipText = LOCTEXT("ApplySuggestedSizeButtonTooltip", "Set Maximum Texture Size of selected textures to the size suggested by the texel density analysis");
+		MenuBuilder.AddMenuEntry(Label, ToolTipText, FSlateIcon(), Action);
+	}
+	MenuBuilder.EndSection();
+	MenuBuilder.BeginSection("AnalyzeAction", LOCTEXT("AnalyzeAction", "Analyze"));
+	{
+		FUIAction Action = FUIAction(FExecuteAction::CreateSP(this, &STextureToolUI::OnAnalyzeChannelsClicked));
+		const FText Label = LOCTEXT("AnalyzeChannelsButtonLabel", "Analyze Channels");
+		const FText ToolTipText = LOCTEXT("AnalyzeChannelsButtonTooltip", "Find constant, duplicated and unused channels of selected textures");
+		MenuBuilder.AddMenuEntry(Label, ToolTipText, FSlateIcon(), Action);
+	}
+
+	{
+		FUIAction Action = FUIAction(FExecuteAction::CreateSP(this, &STextureToolUI::OnAnalyzeDensityClicked));
+		const FText Label = LOCTEXT("AnalyzeDensityButtonLabel", "Analyze Texel Density");
+		const FText ToolTipText = LOCTEXT("AnalyzeDensityButtonTooltip", "Compare texture sizes with the texel density static meshes of the current level can show");
+		MenuBuilder.AddMenuEntry(Label, ToolTipText, FSlateIcon(), Action);
+	}
 	MenuBuilder.EndSection();
 	return MenuBuilder.MakeWidget();
 }
@@ -290,6 +469,28 @@ public:
 	virtual bool ShouldDisplayHeader(const UObject* InRootObject) const override { return false; }
 };
 
+TSharedPtr<SWidget> STextureToolUI::CreateAuditContextMenu()
+{
+	FMenuBuilder MenuBuilder(true, NULL);
+	MenuBuilder.BeginSection("FindAction", LOCTEXT("FindAction", "Find"));
+	{
+		FUIAction Action = FUIAction(FExecuteAction::CreateSP(this, &STextureToolUI::OnBrowseToAuditClicked));
+		const FText Label = LOCTEXT("BrowseToButtonLabel", "Browse To");
+		const FText ToolTipText = LOCTEXT("BrowseToButtonTooltip", "Browse to selected textures");
+		MenuBuilder.AddMenuEntry(Label, ToolTipText, FSlateIcon(), Action);
+	}
+	MenuBuilder.EndSection();
+	MenuBuilder.BeginSection("ModifyAction", LOCTEXT("ModifyAction", "Modify"));
+	{
+		FUIAction Action = FUIAction(FExecuteAction::CreateSP(this, &STextureToolUI::OnLoadIntoMergerClicked), FCanExecuteAction::CreateSP(this, &STextureToolUI::CanLoadIntoMerger));
+		const FText Label = LOCTEXT("LoadIntoMergerButtonLabel", "Load Into Merger");
+		const FText ToolTipText = LOCTEXT("LoadIntoMergerButtonTooltip", "Fill the merge settings with the selected packing group");
+		MenuBuilder.AddMenuEntry(Label, ToolTipText, FSlateIcon(), Action);
+	}
+	MenuBuilder.EndSection();
+	return MenuBuilder.MakeWidget();
+}
+
 void STextureToolUI::CreateDetailView()
 {
 	FPropertyEditorModule& EditModule = FModuleManager::Get().GetModuleChecked<FPropertyEditorModule>("PropertyEditor");
@@ -310,9 +511,11 @@ void STextureToolUI::CreateDetailView()
 	SettingsDetailsView = EditModule.CreateDetailView(DetailsViewArgs);
 	SettingsDetailsView->SetRootObjectCustomizationInstance(MakeShareable(new FTextureToolSettingsRootObjectCustomization));
 	SettingsDetailsView->SetObject(UTextureMergeSettings::Get());
-}
 
-const int32 ThumbnailSize = 72;
+	AuditDetailsView = EditModule.CreateDetailView(DetailsViewArgs);
+	AuditDetailsView->SetRootObjectCustomizationInstance(MakeShareable(new FTextureToolSettingsRootObjectCustomization));
+	AuditDetailsView->SetObject(UTextureAuditSettings::Get());
+}
 
 TSharedRef<ITableRow> STextureToolUI::OnGenerateWidgetForTextureListView(TSharedPtr<FTextureListItem> InItem, const TSharedRef<STableViewBase>& OwnerTable)
 {
@@ -322,10 +525,10 @@ TSharedRef<ITableRow> STextureToolUI::OnGenerateWidgetForTextureListView(TShared
 		SLATE_BEGIN_ARGS(STextureItemWidget) {}
 		SLATE_END_ARGS()
 
-		void Construct(const FArguments& InArgs, const TSharedRef<STableViewBase>& InOwnerTable, TSharedPtr<FTextureListItem> InListItem, TSharedPtr<FAssetThumbnailPool> Pool)
+		void Construct(const FArguments& InArgs, const TSharedRef<STableViewBase>& InOwnerTable, TSharedPtr<FTextureListItem> InListItem, TSharedPtr<FTextureThumbnailCache> Cache)
 		{
 			Item = InListItem;
-			AssetThumbnailPool = Pool;
+			ThumbnailCache = Cache;
 			SMultiColumnTableRow<TSharedPtr<FTextureListItem>>::Construct(FSuperRowType::FArguments(), InOwnerTable);
 		}
 
@@ -334,17 +537,17 @@ TSharedRef<ITableRow> STextureToolUI::OnGenerateWidgetForTextureListView(TShared
 		{
 			if (ColumnName == "TextureName")
 			{
-				TSharedRef<FAssetThumbnail> AssetThumbnail = MakeShared<FAssetThumbnail>(Item->Texture.Get(), ThumbnailSize, ThumbnailSize, AssetThumbnailPool);
-				FAssetThumbnailConfig ThumbnailConfig;
-				ThumbnailConfig.bAllowFadeIn = false;
 				return SNew(SHorizontalBox) 
 					+ SHorizontalBox::Slot().AutoWidth().VAlign(EVerticalAlignment::VAlign_Center)
 					[
 						SNew(SBox)
 						.WidthOverride(ThumbnailSize)
 						.HeightOverride(ThumbnailSize)
+						.HAlign(HAlign_Center)
+						.VAlign(VAlign_Center)
 						[
-							AssetThumbnail->MakeThumbnailWidget(ThumbnailConfig)
+							SNew(SImage)
+							.Image(this, &STextureItemWidget::GetThumbnailBrush)
 						]
 					]
 					+ SHorizontalBox::Slot().AutoWidth().Padding(10.f, 0.f).VAlign(EVerticalAlignment::VAlign_Center)
@@ -370,16 +573,78 @@ TSharedRef<ITableRow> STextureToolUI::OnGenerateWidgetForTextureListView(TShared
 					SNew(STextBlock)
 					.Text(Text);
 			}
+			else if (ColumnName == "TextureChannels")
+			{
+				return SNew(STextBlock)
+					.Text_Lambda([=]()
+						{
+							if (!Item->ChannelReport.IsValid())
+								return FText::GetEmpty();
+							if (!Item->ChannelReport->HasIssue())
+								return LOCTEXT("ChannelsOk", "OK");
+							return FText::Format(LOCTEXT("ChannelsIssue", "{0}\n{1}"), Item->ChannelReport->GetIssueText(), Item->ChannelReport->GetSuggestionText());
+						});
+			}
+			else if (ColumnName == "TextureDensity")
+			{
+				return SNew(STextBlock)
+					.Text_Lambda([=]()
+						{
+							if (!Item->DensityReport.IsValid())
+								return FText::GetEmpty();
+							if (Item->DensityReport->NumUses == 0)
+								return LOCTEXT("DensityUnused", "Not on static meshes");
+							if (!Item->DensityReport->IsOversized())
+								return LOCTEXT("DensityOk", "OK");
+							return FText::Format(LOCTEXT("DensityOversized", "{0} (needs {1})"), Item->DensityReport->SuggestedSize, FMath::CeilToInt(Item->DensityReport->RequiredSize));
+						});
+			}
 			else
 			{
 				return SNew(STextBlock).Text(LOCTEXT("UnknownColumn", "Unknown Column"));
 			}
 		}
+		const FSlateBrush* GetThumbnailBrush() const
+		{
+			return ThumbnailCache->GetBrush(Item->Texture);
+		}
 		TSharedPtr<FTextureListItem> Item;
-		TSharedPtr<FAssetThumbnailPool> AssetThumbnailPool;
+		TSharedPtr<FTextureThumbnailCache> ThumbnailCache;
+	};
+
+	return SNew(STextureItemWidget, OwnerTable, InItem, ThumbnailCache);
+}
+
+TSharedRef<ITableRow> STextureToolUI::OnGenerateWidgetForAuditListView(TSharedPtr<FAuditListItem> InItem, const TSharedRef<STableViewBase>& OwnerTable)
+{
+	class SAuditItemWidget : public SMultiColumnTableRow<TSharedPtr<FAuditListItem>>
+	{
+	public:
+		SLATE_BEGIN_ARGS(SAuditItemWidget) {}
+		SLATE_END_ARGS()
+
+		void Construct(const FArguments& InArgs, const TSharedRef<STableViewBase>& InOwnerTable, TSharedPtr<FAuditListItem> InListItem)
+		{
+			Item = InListItem;
+			SMultiColumnTableRow<TSharedPtr<FAuditListItem>>::Construct(FSuperRowType::FArguments(), InOwnerTable);
+		}
+
+	private:
+		TSharedRef<SWidget> GenerateWidgetForColumn(const FName& ColumnName)
+		{
+			if (ColumnName == "AuditTexture")
+				return SNew(STextBlock).Text(FText::FromName(Item->Asset.ObjectPath));
+			else if (ColumnName == "AuditIssue")
+				return SNew(STextBlock).Text(Item->Issue);
+			else if (ColumnName == "AuditSuggestion")
+				return SNew(STextBlock).Text(Item->Suggestion);
+			else
+				return SNew(STextBlock).Text(LOCTEXT("UnknownColumn", "Unknown Column"));
+		}
+		TSharedPtr<FAuditListItem> Item;
 	};
 
-	return SNew(STextureItemWidget, OwnerTable, InItem, AssetThumbnailPool);
+	return SNew(SAuditItemWidget, OwnerTable, InItem);
 }
 
 bool STextureToolUI::HasSelectedTexture() const
@@ -410,6 +675,33 @@ bool STextureToolUI::CanAutoKeyword() const
 	return Setting->CanAutoKeyword();
 }
 
+bool STextureToolUI::CanBuildAtlas() const
+{
+	return TextureListItems.Num() > 1;
+}
+
+bool STextureToolUI::CanScanAudit() const
+{
+	return UTextureAuditSettings::Get()->CanScan();
+}
+
+bool STextureToolUI::CanConsolidate() const
+{
+	return DuplicateGroups.ContainsByPredicate([](const FTextureDuplicateGroup& Group) { return Group.Textures.Num() > 1; });
+}
+
+bool STextureToolUI::CanApplyCompression() const
+{
+	return CompressionProposals.Num() > 0;
+}
+
+bool STextureToolUI::CanLoadIntoMerger() const
+{
+	FAuditItemArray Selected;
+	AuditListView->GetSelectedItems(Selected);
+	return Selected.Num() > 0 && Selected[0]->Kind == EAuditKind::Packing;
+}
+
 void STextureToolUI::OnDownScaleClicked()
 {
 	if (TextureListView->GetNumItemsSelected() > 0)
@@ -459,6 +751,28 @@ void STextureToolUI::OnResetSizeClicked()
 	}
 }
 
+bool STextureToolUI::CanApplySuggestedSize() const
+{
+	FTextureItemArray Array;
+	TextureListView->GetSelectedItems(Array);
+	return Array.ContainsByPredicate([](const TSharedPtr<FTextureListItem>& Item) { return Item->DensityReport.IsValid() && Item->DensityReport->IsOversized(); });
+}
+
+void STextureToolUI::OnApplySuggestedSizeClicked()
+{
+	FTextureItemArray Array;
+	TextureListView->GetSelectedItems(Array);
+	for (auto& Item : Array)
+	{
+		// Only shrink, a texture may already be sized below what the level asks for on purpose
+		if (!Item->DensityReport.IsValid() || !Item->DensityReport->IsOversized() || !FTextureToolUtils::CanDownScaleTexture(Item->Texture.Get()))
+			continue;
+		FTextureToolUtils::SetMaxTextureSize(Item->Texture.Get(), Item->DensityReport->SuggestedSize);
+		Item->DensityReport->CurrentSize = FMath::Max(Item->Texture->GetSizeX(), Item->Texture->GetSizeY());
+	}
+	TextureListView->RequestListRefresh();
+}
+
 void STextureToolUI::OnBrowseToClicked()
 {
 	if (TextureListView->GetNumItemsSelected() > 0)
@@ -475,91 +789,43 @@ void STextureToolUI::OnBrowseToClicked()
 }
 
 
-/** Generates a reference graph of the world and can then find actors referencing specified objects */
-struct WorldReferenceGenerator : public FFindReferencedAssets
+void STextureToolUI::OnAnalyzeChannelsClicked()
 {
-	void BuildReferencingData()
+	FTextureItemArray Array;
+	TextureListView->GetSelectedItems(Array);
+	TArray<UTexture2D*> Textures;
+	for (auto& Item : Array)
+		Textures.Add(Item->Texture.Get());
+
+	TArray<FTextureChannelReport> Reports;
+	TArray<bool> Valid;
+	FTextureChannelAnalyzer::Analyze(Textures, Reports, Valid);
+	for (int32 i = 0; i < Array.Num(); ++i)
 	{
-		MarkAllObjects();
-
-		const int32 MaxRecursionDepth = 0;
-		const bool bIncludeClasses = true;
-		const bool bIncludeDefaults = false;
-		const bool bReverseReferenceGraph = true;
-
-
-		UWorld* World = GWorld;
-
-		// Generate the reference graph for the world
-		FReferencedAssets* WorldReferencer = new(Referencers)FReferencedAssets(World);
-		FFindAssetsArchive(World, WorldReferencer->AssetList, &ReferenceGraph, MaxRecursionDepth, bIncludeClasses, bIncludeDefaults, bReverseReferenceGraph);
-
-		// Also include all the streaming levels in the results
-		for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
-		{
-			if (StreamingLevel)
-			{
-				if (ULevel* Level = StreamingLevel->GetLoadedLevel())
-				{
-					// Generate the reference graph for each streamed in level
-					FReferencedAssets* LevelReferencer = new(Referencers) FReferencedAssets(Level);
-					FFindAssetsArchive(Level, LevelReferencer->AssetList, &ReferenceGraph, MaxRecursionDepth, bIncludeClasses, bIncludeDefaults, bReverseReferenceGraph);
-				}
-			}
-		}
-
-		TArray<UObject*> ReferencedObjects;
-		// Special case for blueprints
-		for (AActor* Actor : FActorRange(World))
-		{
-			ReferencedObjects.Reset();
-			Actor->GetReferencedContentObjects(ReferencedObjects);
-			for (UObject* Reference : ReferencedObjects)
-			{
-				TSet<UObject*>& Objects = ReferenceGraph.FindOrAdd(Reference);
-				Objects.Add(Actor);
-			}
-		}
+		if (Valid[i])
+			Array[i]->ChannelReport = MakeShared<FTextureChannelReport>(Reports[i]);
 	}
+	TextureListView->RequestListRefresh();
+}
 
-	void MarkAllObjects()
+void STextureToolUI::OnAnalyzeDensityClicked()
+{
+	TMap<UTexture2D*, FTextureDensityReport> Reports;
+	FTextureDensityAnalyzer::Get().Analyze(GEditor->GetEditorWorldContext().World(), UTextureAuditSettings::Get()->TargetTexelDensity, Reports);
+
+	FTextureItemArray Array;
+	TextureListView->GetSelectedItems(Array);
+	if (Array.Num() == 0)
+		Array = TextureListItems;
+	for (auto& Item : Array)
 	{
-		// Mark all objects so we don't get into an endless recursion
-		for (FObjectIterator It; It; ++It)
-		{
-			It->Mark(OBJECTMARK_TagExp);
-		}
+		const FTextureDensityReport* Report = Reports.Find(Item->Texture.Get());
+		Item->DensityReport = MakeShared<FTextureDensityReport>(Report ? *Report : FTextureDensityReport());
 	}
+	TextureListView->RequestListRefresh();
+}
 
-	void Generate(const UObject* AssetToFind, TSet<const UObject*>& OutObjects)
-	{
-		// Don't examine visited objects
-		if (!AssetToFind->HasAnyMarks(OBJECTMARK_TagExp))
-		{
-			return;
-		}
-
-		AssetToFind->UnMark(OBJECTMARK_TagExp);
-
-		// Return once we find a parent object that is an actor
-		if (AssetToFind->IsA(AActor::StaticClass()))
-		{
-			OutObjects.Add(AssetToFind);
-			return;
-		}
-
-		// Traverse the reference graph looking for actor objects
-		TSet<UObject*>* ReferencingObjects = ReferenceGraph.Find(AssetToFind);
-		if (ReferencingObjects)
-		{
-			for (TSet<UObject*>::TConstIterator SetIt(*ReferencingObjects); SetIt; ++SetIt)
-			{
-				Generate(*SetIt, OutObjects);
-			}
-		}
-	}
-};
-
+/** Generates a reference graph of the world and can then find actors referencing specified objects */
 void STextureToolUI::OnFindActorClicked()
 {
 	if (TextureListView->GetNumItemsSelected() > 0)
@@ -582,6 +848,7 @@ void STextureToolUI::OnFindActorClicked()
 
 		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
 
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_FindActors);
 		TSet<const UObject*> OutObjects;
 		WorldReferenceGenerator ObjRefGenerator;
 
@@ -625,6 +892,76 @@ FReply STextureToolUI::OnFindTextureClicked()
 	return FReply::Handled();
 }
 
+FReply STextureToolUI::OnBuildAtlasClicked()
+{
+	FTextureItemArray Items;
+	TextureListView->GetSelectedItems(Items);
+	if (Items.Num() == 0)
+		Items = TextureListItems;
+	TArray<UTexture2D*> Textures;
+	for (auto& Item : Items)
+	{
+		UTexture2D* Texture = Item->Texture.LoadSynchronous();
+		if (FTextureAtlasBuilder::CanAtlas(Texture))
+			Textures.AddUnique(Texture);
+	}
+	if (Textures.Num() < 2)
+	{
+		FNotificationInfo Info(LOCTEXT("NoAtlasTextures", "An atlas needs at least two color textures up to 256 px."));
+		Info.ExpireDuration = 3.0f;
+		FSlateNotificationManager::Get().AddNotification(Info);
+		return FReply::Handled();
+	}
+
+	// Materials of the selected actors, the ones the textures were found in
+	TArray<UMaterialInterface*> Materials;
+	for (FSelectionIterator It(GEditor->GetSelectedActorIterator()); It; ++It)
+	{
+		if (AActor* Actor = Cast<AActor>(*It))
+		{
+			for (UMaterialInterface* Material : FTextureToolUtils::FindMaterials(Actor))
+				Materials.AddUnique(Material);
+		}
+	}
+
+	FString AssetPath;
+	const FString DefaultFilesystemDirectory = FEditorDirectories::Get().GetLastDirectory(ELastDirectory::NEW_ASSET);
+	if (DefaultFilesystemDirectory.IsEmpty() || !FPackageName::TryConvertFilenameToLongPackageName(DefaultFilesystemDirectory, AssetPath))
+		AssetPath = TEXT("/Game");
+	FSaveAssetDialogConfig SaveAssetDialogConfig;
+	SaveAssetDialogConfig.DialogTitleOverride = LOCTEXT("SaveAtlasDialogTitle", "Save Atlas As");
+	SaveAssetDialogConfig.DefaultPath = AssetPath;
+	SaveAssetDialogConfig.DefaultAssetName = TEXT("T_Atlas");
+	SaveAssetDialogConfig.ExistingAssetPolicy = ESaveAssetDialogExistingAssetPolicy::Disallow;
+	FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
+	const FString SaveObjectPath = ContentBrowserModule.Get().CreateModalSaveAssetDialog(SaveAssetDialogConfig);
+	if (SaveObjectPath.IsEmpty())
+		return FReply::Handled();
+	const FString SavePackageName = FPackageName::ObjectPathToPackageName(SaveObjectPath);
+	FEditorDirectories::Get().SetLastDirectory(ELastDirectory::NEW_ASSET, FPaths::GetPath(SavePackageName));
+
+	UDataTable* Table = nullptr;
+	FTextureAtlasReport Report;
+	FText FailReason;
+	UTexture2D* Atlas = FTextureAtlasBuilder::Build(Textures, Materials, FPaths::GetPath(SavePackageName), FPaths::GetBaseFilename(SavePackageName), Table, Report, FailReason);
+	if (!Atlas)
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, FailReason);
+		return FReply::Handled();
+	}
+
+	TArray<UObject*> Results;
+	Results.Add(Atlas);
+	Results.Add(Table);
+	ContentBrowserModule.Get().SyncBrowserToAssets(Results);
+	FNotificationInfo Info(FText::Format(LOCTEXT("AtlasBuilt", "{0} textures packed into {1}x{2} ({3} used), {4} -> {5}. {6} samplers fewer, {7} materials can share one draw call."),
+		Report.NumTextures, Report.AtlasSize.X, Report.AtlasSize.Y, FText::AsPercent(Report.Efficiency), FText::AsMemory(Report.BytesBefore), FText::AsMemory(Report.BytesAfter),
+		Report.SamplersSaved, Report.NumAtlasOnlyMaterials));
+	Info.ExpireDuration = 8.0f;
+	FSlateNotificationManager::Get().AddNotification(Info);
+	return FReply::Handled();
+}
+
 FReply STextureToolUI::OnMergeClicked()
 {
 	auto Setting = UTextureMergeSettings::Get();
@@ -632,6 +969,13 @@ FReply STextureToolUI::OnMergeClicked()
 	return FReply::Handled();
 }
 
+FReply STextureToolUI::OnSavePresetClicked()
+{
+	auto Setting = UTextureMergeSettings::Get();
+	Setting->SaveAsPreset();
+	return FReply::Handled();
+}
+
 FReply STextureToolUI::OnAutoSuffixClicked()
 {
 	auto Setting = UTextureMergeSettings::Get();
@@ -639,29 +983,318 @@ FReply STextureToolUI::OnAutoSuffixClicked()
 	return FReply::Handled();
 }
 
+TSharedRef<SWidget> STextureToolUI::OnGetMineKeywordsMenu()
+{
+	auto Setting = UTextureMergeSettings::Get();
+	TArray<FTextureKeywordProposal> Proposals;
+	TArray<FTextureKeywordStats> Stats;
+	FTextureKeywordMiner::Mine(Setting->InputDirectory.Path, Setting->bRecursive, Proposals, Stats);
+	for (int32 Index = 0; Index < FMath::Min(Stats.Num(), 20); ++Index)
+		UE_LOG(LogTemp, Log, TEXT("Keyword %-16s suffix %6d, infix %6d, shared stems %6d"), *Stats[Index].Keyword, Stats[Index].NumSuffix, Stats[Index].NumInfix, Stats[Index].NumSharedStems);
+
+	FMenuBuilder MenuBuilder(true, nullptr);
+	MenuBuilder.BeginSection("Keywords", LOCTEXT("KeywordProposals", "Keyword Sets"));
+	for (const FTextureKeywordProposal& Proposal : Proposals)
+	{
+		MenuBuilder.AddMenuEntry(Proposal.GetText(), LOCTEXT("ApplyKeywordsTip", "Use these keywords for R, G, B and A, other channels are left out"), FSlateIcon(),
+			FUIAction(FExecuteAction::CreateLambda([Proposal]() { Proposal.ApplyTo(UTextureMergeSettings::Get()); })));
+	}
+	if (Proposals.Num() == 0)
+		MenuBuilder.AddWidget(SNew(STextBlock).Text(LOCTEXT("NoKeywordSets", "No keyword shared by two textures of the same stem.")), FText::GetEmpty());
+	MenuBuilder.EndSection();
+	return MenuBuilder.MakeWidget();
+}
+
+FReply STextureToolUI::OnFindDuplicatesClicked()
+{
+	auto Setting = UTextureAuditSettings::Get();
+	TArray<FTextureDuplicateGroup> Groups;
+	if (!FTextureDuplicateFinder::Get().Scan(Setting->Directory.Path, Setting->bRecursive, Groups))
+		return FReply::Handled();
+
+	DuplicateGroups = MoveTemp(Groups);
+	AuditListItems.RemoveAll([](const TSharedPtr<FAuditListItem>& Item) { return Item->Kind == EAuditKind::Duplicate; });
+	for (int32 GroupIndex = 0; GroupIndex < DuplicateGroups.Num(); ++GroupIndex)
+	{
+		const FTextureDuplicateGroup& Group = DuplicateGroups[GroupIndex];
+		for (int32 i = 0; i < Group.Textures.Num(); ++i)
+		{
+			TSharedPtr<FAuditListItem> Item = MakeShared<FAuditListItem>();
+			Item->Kind = EAuditKind::Duplicate;
+			Item->Asset = Group.Textures[i];
+			Item->Group = GroupIndex;
+			Item->Issue = FText::Format(LOCTEXT("DuplicateIssue", "Duplicate group {0}, {1} identical textures"), GroupIndex, Group.Textures.Num());
+			Item->Suggestion = i == 0 ? LOCTEXT("DuplicateKeep", "Keep") : FText::Format(LOCTEXT("DuplicateReplace", "Consolidate into {0}"), FText::FromName(Group.Textures[0].AssetName));
+			AuditListItems.Add(Item);
+		}
+	}
+	AuditListView->RequestListRefresh();
+
+	if (DuplicateGroups.Num() == 0)
+	{
+		FNotificationInfo Info(LOCTEXT("NoDuplicatesFound", "No duplicated textures found."));
+		Info.ExpireDuration = 3.0f;
+		FSlateNotificationManager::Get().AddNotification(Info);
+	}
+	return FReply::Handled();
+}
+
+FReply STextureToolUI::OnConsolidateClicked()
+{
+	TSet<int32> Groups;
+	FAuditItemArray Selected;
+	AuditListView->GetSelectedItems(Selected);
+	for (auto& Item : Selected)
+	{
+		if (Item->Kind == EAuditKind::Duplicate)
+			Groups.Add(Item->Group);
+	}
+	if (Groups.Num() == 0)
+	{
+		int32 NumTextures = 0;
+		for (int32 GroupIndex = 0; GroupIndex < DuplicateGroups.Num(); ++GroupIndex)
+		{
+			Groups.Add(GroupIndex);
+			NumTextures += FMath::Max(DuplicateGroups[GroupIndex].Textures.Num() - 1, 0);
+		}
+		const FText Message = FText::Format(LOCTEXT("ConsolidateAllConfirm", "Nothing is selected, consolidate {0} textures of every duplicate group ({1} groups)?"), NumTextures, Groups.Num());
+		if (FMessageDialog::Open(EAppMsgType::YesNo, Message) != EAppReturnType::Yes)
+			return FReply::Handled();
+	}
+
+	for (int32 GroupIndex : Groups)
+	{
+		FTextureDuplicateGroup& Group = DuplicateGroups[GroupIndex];
+		if (Group.Textures.Num() < 2)
+			continue;
+		if (!FTextureDuplicateFinder::Consolidate(Group))
+			UE_LOG(LogTemp, Error, TEXT("Fail to consolidate duplicates of %s"), *Group.Textures[0].ObjectPath.ToString());
+		Group.Textures.Reset();
+	}
+
+	// Consolidated groups are gone, keep the others listed
+	AuditListItems.RemoveAll([&](const TSharedPtr<FAuditListItem>& Item) { return Item->Kind == EAuditKind::Duplicate && Groups.Contains(Item->Group); });
+	AuditListView->RequestListRefresh();
+	return FReply::Handled();
+}
+
+FReply STextureToolUI::OnFindChannelWasteClicked()
+{
+	auto Setting = UTextureAuditSettings::Get();
+	TArray<TPair<FAssetData, FTextureChannelReport>> Reports;
+	if (!FTextureChannelAnalyzer::Scan(Setting->Directory.Path, Setting->bRecursive, Reports))
+		return FReply::Handled();
+
+	AuditListItems.RemoveAll([](const TSharedPtr<FAuditListItem>& Item) { return Item->Kind == EAuditKind::Channels; });
+	for (auto& Report : Reports)
+	{
+		if (!Report.Value.HasIssue())
+			continue;
+		TSharedPtr<FAuditListItem> Item = MakeShared<FAuditListItem>();
+		Item->Kind = EAuditKind::Channels;
+		Item->Asset = Report.Key;
+		Item->Issue = Report.Value.GetIssueText();
+		Item->Suggestion = Report.Value.GetSuggestionText();
+		AuditListItems.Add(Item);
+	}
+	AuditListView->RequestListRefresh();
+	return FReply::Handled();
+}
+
+FReply STextureToolUI::OnPlanPackingClicked()
+{
+	UWorld* World = GEditor->GetEditorWorldContext().World();
+	PackingProposals.Reset();
+	FTexturePackingPlanner::Plan(World, PackingProposals);
+
+	const TCHAR* ChannelNames[] = { TEXT("R"), TEXT("G"), TEXT("B"), TEXT("A") };
+	AuditListItems.RemoveAll([](const TSharedPtr<FAuditListItem>& Item) { return Item->Kind == EAuditKind::Packing; });
+	for (int32 GroupIndex = 0; GroupIndex < PackingProposals.Num(); ++GroupIndex)
+	{
+		const FTexturePackingProposal& Proposal = PackingProposals[GroupIndex];
+		for (int32 i = 0; i < Proposal.Textures.Num(); ++i)
+		{
+			TSharedPtr<FAuditListItem> Item = MakeShared<FAuditListItem>();
+			Item->Kind = EAuditKind::Packing;
+			Item->Asset = FAssetData(Proposal.Textures[i].Get());
+			Item->Group = GroupIndex;
+			Item->Issue = FText::Format(LOCTEXT("PackingIssue", "Packing group {0}, sampled together at {1} sites"), GroupIndex, Proposal.NumSamplingSites);
+			if (Proposal.BytesSaved >= 0)
+				Item->Suggestion = FText::Format(LOCTEXT("PackingSuggestion", "Pack into {0}, saves {1} samplers and {2}"), FText::FromString(ChannelNames[i]), Proposal.SamplersSaved, FText::AsMemory(Proposal.BytesSaved));
+			else
+				Item->Suggestion = FText::Format(LOCTEXT("PackingSuggestionCost", "Pack into {0}, saves {1} samplers but costs {2} more"), FText::FromString(ChannelNames[i]), Proposal.SamplersSaved, FText::AsMemory(-Proposal.BytesSaved));
+			AuditListItems.Add(Item);
+		}
+	}
+	AuditListView->RequestListRefresh();
+
+	if (PackingProposals.Num() == 0)
+	{
+		FNotificationInfo Info(LOCTEXT("NoPackingFound", "No textures to pack found in the current level."));
+		Info.ExpireDuration = 3.0f;
+		FSlateNotificationManager::Get().AddNotification(Info);
+	}
+	return FReply::Handled();
+}
+
+FReply STextureToolUI::OnFindCompressionWasteClicked()
+{
+	auto Setting = UTextureAuditSettings::Get();
+	TArray<FTextureCompressionProposal> Proposals;
+	if (!FTextureCompressionOptimizer::Scan(Setting->Directory.Path, Setting->bRecursive, Proposals))
+		return FReply::Handled();
+
+	CompressionProposals = MoveTemp(Proposals);
+	AuditListItems.RemoveAll([](const TSharedPtr<FAuditListItem>& Item) { return Item->Kind == EAuditKind::Compression; });
+	for (int32 Index = 0; Index < CompressionProposals.Num(); ++Index)
+	{
+		const FTextureCompressionProposal& Proposal = CompressionProposals[Index];
+		TSharedPtr<FAuditListItem> Item = MakeShared<FAuditListItem>();
+		Item->Kind = EAuditKind::Compression;
+		Item->Asset = Proposal.Asset;
+		Item->Group = Index;
+		Item->Issue = FText::Format(LOCTEXT("CompressionIssue", "{0} with unsuited settings"), Proposal.GetContentText());
+		Item->Suggestion = Proposal.GetChangeText();
+		AuditListItems.Add(Item);
+	}
+	AuditListView->RequestListRefresh();
+
+	if (CompressionProposals.Num() == 0)
+	{
+		FNotificationInfo Info(LOCTEXT("NoCompressionWasteFound", "No texture with unsuited compression settings found."));
+		Info.ExpireDuration = 3.0f;
+		FSlateNotificationManager::Get().AddNotification(Info);
+	}
+	return FReply::Handled();
+}
+
+FReply STextureToolUI::OnApplyCompressionClicked()
+{
+	TSet<int32> Indices;
+	FAuditItemArray Selected;
+	AuditListView->GetSelectedItems(Selected);
+	for (auto& Item : Selected)
+	{
+		if (Item->Kind == EAuditKind::Compression)
+			Indices.Add(Item->Group);
+	}
+	if (Indices.Num() == 0)
+	{
+		for (int32 Index = 0; Index < CompressionProposals.Num(); ++Index)
+			Indices.Add(Index);
+		const FText Message = FText::Format(LOCTEXT("ApplyCompressionAllConfirm", "Nothing is selected, apply the proposed settings to all {0} textures?"), Indices.Num());
+		if (FMessageDialog::Open(EAppMsgType::YesNo, Message) != EAppReturnType::Yes)
+			return FReply::Handled();
+	}
+
+	TArray<FTextureCompressionProposal> ToApply;
+	for (int32 Index : Indices)
+		ToApply.Add(CompressionProposals[Index]);
+	TArray<FText> Conflicts;
+	const int32 NumApplied = FTextureCompressionOptimizer::Apply(ToApply, Conflicts);
+	if (Conflicts.Num() > 0)
+	{
+		TArray<FString> Lines;
+		for (const FText& Conflict : Conflicts)
+			Lines.Add(Conflict.ToString());
+		FMessageDialog::Open(EAppMsgType::Ok, FText::Format(LOCTEXT("SamplerConflicts", "Some material parameters could not follow the new settings and need their sampler type fixed by hand:\n\n{0}"),
+			FText::FromString(FString::Join(Lines, TEXT("\n")))));
+	}
+
+	// Applied proposals stay in CompressionProposals so the indices of the others hold
+	AuditListItems.RemoveAll([&](const TSharedPtr<FAuditListItem>& Item) { return Item->Kind == EAuditKind::Compression && Indices.Contains(Item->Group); });
+	if (!AuditListItems.ContainsByPredicate([](const TSharedPtr<FAuditListItem>& Item) { return Item->Kind == EAuditKind::Compression; }))
+		CompressionProposals.Reset();
+	AuditListView->RequestListRefresh();
+
+	FNotificationInfo Info(FText::Format(LOCTEXT("CompressionApplied", "Compression settings applied to {0} textures."), NumApplied));
+	Info.ExpireDuration = 3.0f;
+	FSlateNotificationManager::Get().AddNotification(Info);
+	return FReply::Handled();
+}
+
+void STextureToolUI::OnLoadIntoMergerClicked()
+{
+	FAuditItemArray Selected;
+	AuditListView->GetSelectedItems(Selected);
+	if (Selected.Num() == 0 || Selected[0]->Kind != EAuditKind::Packing || !PackingProposals.IsValidIndex(Selected[0]->Group))
+		return;
+
+	UTextureMergeSettings* Setting = UTextureMergeSettings::Get();
+	PackingProposals[Selected[0]->Group].ApplyTo(Setting);
+	InlineContentHolder->SetContent(MergerWidget->AsShared());
+	SettingsDetailsView->SetObject(Setting, true);
+	Mode = EToolMode::TextureMerger;
+}
+
+void STextureToolUI::OnBrowseToAuditClicked()
+{
+	FAuditItemArray Array;
+	AuditListView->GetSelectedItems(Array);
+	TArray<FAssetData> Assets;
+	for (auto& Item : Array)
+		Assets.Add(Item->Asset);
+	if (Assets.Num() > 0)
+	{
+		FContentBrowserModule& ContentBrowserModule = FModuleManager::Get().LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
+		ContentBrowserModule.Get().SyncBrowserToAssets(Assets, false, true);
+	}
+}
+
 void STextureToolUI::OpenTextureEditor(TSharedPtr<FTextureListItem> Item)
 {
 	FAssetEditorManager::Get().OpenEditorForAsset(Item->Texture.Get());
 }
 
+/** A matched group, or once the group is expanded one of its sources */
+struct FBatchMergeItem
+{
+	FString Name;
+	/** Channel and object path of a source row */
+	FText ChannelText;
+	FString ObjectPath;
+	/** Built when the group is first expanded, may stay empty if no channel is used */
+	TArray<TSharedPtr<FBatchMergeItem>> Children;
+	/** Only child of a collapsed group, so the tree shows an expander without building its sources */
+	TSharedPtr<FBatchMergeItem> Placeholder;
+	bool bChildrenBuilt = false;
+	bool bPlaceholder = false;
+	bool bRemoved = false;
+	/** Position of a group in the shown groups, INDEX_NONE when filtered out or removed */
+	int32 FilteredIndex = INDEX_NONE;
+};
+
 class SBatchMergeDialog : public SCompoundWidget
 {
 public:
-	using ItemType = TSharedPtr<FString>;
+	using ItemType = TSharedPtr<FBatchMergeItem>;
 	using ItemArray = TArray<ItemType>;
-	using ListView = SListView<ItemType>;
+	using TreeView = STreeView<ItemType>;
 public:
 	SLATE_BEGIN_ARGS(SBatchMergeDialog) {}
 	SLATE_END_ARGS()
 	void Construct(const FArguments& InArgs, TArray<FString> InNames)
 	{
-		Names = MoveTemp(InNames);
-		for (auto& Name : Names)
-			Items.Add(MakeShared<FString>(Name));
-		ListWidget = SNew(ListView)
-			.ListItemsSource(&Items)
-			.SelectionMode(ESelectionMode::None)
-			.OnGenerateRow(this, &SBatchMergeDialog::OnGenerateWidgetForListView);
+		Items.Reserve(InNames.Num());
+		for (auto& Name : InNames)
+		{
+			ItemType Item = MakeShared<FBatchMergeItem>();
+			Item->Name = MoveTemp(Name);
+			Item->FilteredIndex = Items.Num();
+			Items.Add(Item);
+		}
+		FilteredItems = Items;
+		TArray<FString> Names;
+		GetNames(Names);
+		FTextureBatchEstimator::Estimate(UTextureMergeSettings::Get(), Names, Estimate);
+		// Rows are only built for visible items, the tree must not sit in a scroll box
+		TreeWidget = SNew(TreeView)
+			.TreeItemsSource(&FilteredItems)
+			.SelectionMode(ESelectionMode::Multi)
+			.OnGenerateRow(this, &SBatchMergeDialog::OnGenerateWidgetForTreeView)
+			.OnGetChildren(this, &SBatchMergeDialog::OnGetChildren)
+			.OnExpansionChanged(this, &SBatchMergeDialog::OnExpansionChanged)
+			.OnMouseButtonDoubleClick(this, &SBatchMergeDialog::OnItemDoubleClicked);
 		ChildSlot
 		[
 			SNew(SVerticalBox)
@@ -685,14 +1318,36 @@ public:
 						]
 					]
 					+ SVerticalBox::Slot()
-					.FillHeight(1.0f)
+					.AutoHeight()
+					.Padding(3.0f)
 					[
-						SNew(SScrollBox)
-						+ SScrollBox::Slot()
+						SNew(STextBlock)
+						.Text(this, &SBatchMergeDialog::GetEstimateText)
+						.ToolTipText(LOCTEXT("BatchEstimateTip", "From asset registry tags, time from the throughput of the latest batch reports"))
+					]
+					+ SVerticalBox::Slot()
+					.AutoHeight()
+					.Padding(3.0f)
+					[
+						SNew(SHorizontalBox)
+						+ SHorizontalBox::Slot().FillWidth(1.f)
+						[
+							SNew(SSearchBox)
+							.HintText(LOCTEXT("FilterMatched", "Filter matched names"))
+							.OnTextChanged(this, &SBatchMergeDialog::OnFilterTextChanged)
+						]
+						+ SHorizontalBox::Slot().AutoWidth().Padding(10.f, 0.f, 0.f, 0.f)
 						[
-							ListWidget.ToSharedRef()
+							SNew(SButton).Text(LOCTEXT("RemoveSelectedMatched", "Remove Selected"))
+							.ToolTipText(LOCTEXT("RemoveSelectedMatchedTip", "Leave the selected groups out of the batch, Delete does the same"))
+							.OnClicked(this, &SBatchMergeDialog::OnRemoveSelectedClicked)
 						]
 					]
+					+ SVerticalBox::Slot()
+					.FillHeight(1.0f)
+					[
+						TreeWidget.ToSharedRef()
+					]
 				]
 			]
 			+ SVerticalBox::Slot().AutoHeight().Padding(0.f,10.f,0.f,0.f)
@@ -712,18 +1367,145 @@ public:
 			]
 		];
 	}
+
+	virtual bool SupportsKeyboardFocus() const override
+	{
+		return true;
+	}
+
+	virtual FReply OnKeyDown(const FGeometry& MyGeometry, const FKeyEvent& InKeyEvent) override
+	{
+		if (InKeyEvent.GetKey() == EKeys::Delete)
+			return OnRemoveSelectedClicked();
+		return SCompoundWidget::OnKeyDown(MyGeometry, InKeyEvent);
+	}
+
 private:
-	TArray<FString> Names;
+	/** Every matched group in match order, removed ones are only flagged */
 	ItemArray Items;
-	TSharedPtr<ListView> ListWidget;
-	TSharedRef<ITableRow> OnGenerateWidgetForListView(TSharedPtr<FString> InItem, const TSharedRef<STableViewBase>& OwnerTable)
+	/** Groups passing the filter and not removed, what the tree shows. Removal swaps the last group in, the match order comes back with the next filter change */
+	ItemArray FilteredItems;
+	FString FilterText;
+	TSharedPtr<TreeView> TreeWidget;
+	FTextureBatchEstimate Estimate;
+
+	void GetNames(TArray<FString>& OutNames) const
 	{
-		return SNew(STableRow<TSharedPtr<FString>>, OwnerTable)
+		OutNames.Reserve(Items.Num());
+		for (const ItemType& Item : Items)
+		{
+			if (!Item->bRemoved)
+				OutNames.Add(Item->Name);
+		}
+	}
+
+	FText GetEstimateText() const
+	{
+		return Estimate.GetSummaryText();
+	}
+
+	bool IsGroup(const ItemType& Item) const
+	{
+		return Item->ObjectPath.IsEmpty() && !Item->bPlaceholder;
+	}
+
+	void OnGetChildren(ItemType InItem, ItemArray& OutChildren)
+	{
+		if (!IsGroup(InItem))
+			return;
+		if (InItem->bChildrenBuilt)
+		{
+			OutChildren = InItem->Children;
+			return;
+		}
+		// Each group has its own, the tree tracks items by pointer and a shared child would have several parents
+		if (!InItem->Placeholder.IsValid())
+		{
+			InItem->Placeholder = MakeShared<FBatchMergeItem>();
+			InItem->Placeholder->bPlaceholder = true;
+		}
+		OutChildren.Add(InItem->Placeholder);
+	}
+
+	void OnExpansionChanged(ItemType InItem, bool bExpanded)
+	{
+		if (!bExpanded || !IsGroup(InItem) || InItem->bChildrenBuilt)
+			return;
+		static const FText ChannelNames[5] = { LOCTEXT("SourceR", "R"), LOCTEXT("SourceG", "G"), LOCTEXT("SourceB", "B"), LOCTEXT("SourceA", "A"), LOCTEXT("SourceReplace", "Replace") };
+		auto Setting = UTextureMergeSettings::Get();
+		FString GroupName;
+		const FTextureChannelSrc* Channels[5];
+		Setting->GetChannels(Setting->SplitMatchedName(InItem->Name, GroupName), Channels);
+		for (int32 i = 0; i < 5; ++i)
+		{
+			if (!Channels[i]->Optional)
+				continue;
+			ItemType Child = MakeShared<FBatchMergeItem>();
+			Child->ChannelText = ChannelNames[i];
+			Child->ObjectPath = Setting->GetSourceObjectPath(GroupName, *Channels[i]);
+			InItem->Children.Add(Child);
+		}
+		InItem->bChildrenBuilt = true;
+		InItem->Placeholder.Reset();
+		TreeWidget->RequestTreeRefresh();
+	}
+
+	void OnItemDoubleClicked(ItemType InItem)
+	{
+		if (InItem->ObjectPath.IsEmpty())
+			return;
+		IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		const FAssetData Asset = AssetRegistry.GetAssetByObjectPath(*InItem->ObjectPath);
+		if (!Asset.IsValid())
+			return;
+		FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
+		ContentBrowserModule.Get().SyncBrowserToAssets(TArray<FAssetData>({ Asset }));
+	}
+
+	TSharedRef<ITableRow> OnGenerateWidgetForTreeView(ItemType InItem, const TSharedRef<STableViewBase>& OwnerTable)
+	{
+		if (InItem->bPlaceholder)
+			return SNew(STableRow<ItemType>, OwnerTable);
+
+		// Source rows are only generated when visible, so the registry is asked for the few on screen
+		if (!InItem->ObjectPath.IsEmpty())
+		{
+			IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+			const bool bExists = AssetRegistry.GetAssetByObjectPath(*InItem->ObjectPath).IsValid();
+			return SNew(STableRow<ItemType>, OwnerTable)
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot().AutoWidth().Padding(0.f, 0.f, 10.f, 0.f)
+				[
+					SNew(STextBlock).Text(InItem->ChannelText)
+				]
+				+ SHorizontalBox::Slot().FillWidth(1.f)
+				[
+					SNew(STextBlock).Text(FText::FromString(InItem->ObjectPath))
+					.ColorAndOpacity(bExists ? FLinearColor::White : FLinearColor::Red)
+					.ToolTipText(bExists ? LOCTEXT("BrowseSourceTip", "Double click to browse to the source") : LOCTEXT("MissingSourceTip", "Source is not in the asset registry"))
+				]
+			];
+		}
+
+		const FTextureBatchGroupEstimate* Group = Estimate.Groups.Find(InItem->Name);
+		FText GroupText;
+		if (Group && Group->WillFail())
+			GroupText = Group->Problem;
+		else if (Group)
+			GroupText = FText::Format(LOCTEXT("GroupEstimate", "{0}x{1}  {2}"), Group->Size.X, Group->Size.Y, FText::AsMemory(Group->CookedBytes));
+		return SNew(STableRow<ItemType>, OwnerTable)
 		[
 			SNew(SHorizontalBox)
 			+ SHorizontalBox::Slot().FillWidth(1.f)
 			[
-				SNew(STextBlock).Text(FText::FromString(*InItem))
+				SNew(STextBlock).Text(FText::FromString(InItem->Name))
+				.HighlightText(this, &SBatchMergeDialog::GetFilterText)
+			]
+			+ SHorizontalBox::Slot().AutoWidth().Padding(10.f, 0.f)
+			[
+				SNew(STextBlock).Text(GroupText)
+				.ColorAndOpacity(Group && Group->WillFail() ? FLinearColor::Red : FLinearColor::White)
 			]
 			+ SHorizontalBox::Slot().AutoWidth()
 			[
@@ -733,6 +1515,53 @@ private:
 		];
 	}
 
+	FText GetFilterText() const
+	{
+		return FText::FromString(FilterText);
+	}
+
+	void OnFilterTextChanged(const FText& InText)
+	{
+		FilterText = InText.ToString();
+		UpdateFilteredItems();
+	}
+
+	void UpdateFilteredItems()
+	{
+		FilteredItems.Reset();
+		for (const ItemType& Item : Items)
+		{
+			Item->FilteredIndex = INDEX_NONE;
+			if (!Item->bRemoved && (FilterText.IsEmpty() || Item->Name.Contains(FilterText)))
+				Item->FilteredIndex = FilteredItems.Add(Item);
+		}
+		TreeWidget->RequestTreeRefresh();
+	}
+
+	void Remove(const TArray<ItemType>& InItems)
+	{
+		int32 NumRemoved = 0;
+		for (const ItemType& Item : InItems)
+		{
+			if (!IsGroup(Item) || Item->bRemoved)
+				continue;
+			Item->bRemoved = true;
+			Estimate.Remove(Item->Name);
+			++NumRemoved;
+			if (FilteredItems.IsValidIndex(Item->FilteredIndex))
+			{
+				FilteredItems.Last()->FilteredIndex = Item->FilteredIndex;
+				FilteredItems.RemoveAtSwap(Item->FilteredIndex, 1, false);
+				Item->FilteredIndex = INDEX_NONE;
+			}
+		}
+		if (NumRemoved > 0)
+		{
+			TreeWidget->ClearSelection();
+			TreeWidget->RequestTreeRefresh();
+		}
+	}
+
 	void CloseDialog()
 	{
 		TSharedPtr<SWindow> ContainingWindow = FSlateApplication::Get().FindWidgetWindow(AsShared());
@@ -745,6 +1574,8 @@ private:
 
 	FReply OnConfirmClicked()
 	{
+		TArray<FString> Names;
+		GetNames(Names);
 		auto Setting = UTextureMergeSettings::Get();
 		Setting->Batch(Names);
 		CloseDialog();
@@ -756,11 +1587,15 @@ private:
 		return FReply::Handled();
 	}
 
-	FReply OnRemoveClicked(TSharedPtr<FString> InItem)
+	FReply OnRemoveClicked(ItemType InItem)
+	{
+		Remove({ InItem });
+		return FReply::Handled();
+	}
+
+	FReply OnRemoveSelectedClicked()
 	{
-		Items.Remove(InItem);
-		Names.Remove(*InItem);
-		ListWidget->RequestListRefresh();
+		Remove(TreeWidget->GetSelectedItems());
 		return FReply::Handled();
 	}
 };
@@ -5,23 +5,29 @@
 #include "Input/Reply.h"
 #include "Widgets/SCompoundWidget.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
+#include "AssetData.h"
+#include "TextureDuplicateFinder.h"
+#include "TexturePackingPlanner.h"
+#include "TextureCompressionOptimizer.h"
 
 template<class ItemType> class SListView;
 class UTexture2D;
 class AActor;
-class FAssetThumbnailPool;
+class FTextureThumbnailCache;
 class STableViewBase;
 class IDetailsView;
 class ITableRow;
 class SBox;
-struct FAssetData;
 class IMenu;
+struct FTextureChannelReport;
+struct FTextureDensityReport;
 
 enum class EToolMode
 {
 	TextureFinder,
 	TextureMerger,
 	TextureMergerBatch,
+	TextureAudit,
 };
 
 class STextureToolUI : public SCompoundWidget
@@ -30,6 +36,8 @@ private:
 	struct FTextureListItem
 	{
 		TSoftObjectPtr<UTexture2D> Texture;
+		TSharedPtr<FTextureChannelReport> ChannelReport;
+		TSharedPtr<FTextureDensityReport> DensityReport;
 	};
 	struct FNameListItem
 	{
@@ -41,6 +49,25 @@ private:
 	using STextureListView = SListView<TSharedPtr<FTextureListItem>>;
 	using FTextureItemArray = TArray<TSharedPtr<FTextureListItem>>;
 
+	enum class EAuditKind
+	{
+		Duplicate,
+		Channels,
+		Packing,
+		Compression,
+	};
+	struct FAuditListItem
+	{
+		EAuditKind Kind;
+		FAssetData Asset;
+		FText Issue;
+		FText Suggestion;
+		/** Index in DuplicateGroups, PackingProposals or CompressionProposals depending on Kind */
+		int32 Group = INDEX_NONE;
+	};
+	using SAuditListView = SListView<TSharedPtr<FAuditListItem>>;
+	using FAuditItemArray = TArray<TSharedPtr<FAuditListItem>>;
+
 public:
 	SLATE_BEGIN_ARGS(STextureToolUI) {}
 	SLATE_END_ARGS()
@@ -53,32 +80,63 @@ private:
 	TSharedPtr<SWidget> CreateToolBarWidget();
 	TSharedPtr<SWidget> CreateFinderWidget();
 	TSharedPtr<SWidget> CreateMergerWidget();
+	TSharedPtr<SWidget> CreateAuditWidget();
 	TSharedPtr<SWidget> CreateTextureContextMenu();
+	TSharedPtr<SWidget> CreateAuditContextMenu();
 	void CreateDetailView();
 	TSharedRef<ITableRow> OnGenerateWidgetForTextureListView(TSharedPtr<FTextureListItem> InItem, const TSharedRef<STableViewBase>& OwnerTable);
+	TSharedRef<ITableRow> OnGenerateWidgetForAuditListView(TSharedPtr<FAuditListItem> InItem, const TSharedRef<STableViewBase>& OwnerTable);
 
 	bool HasSelectedTexture() const;
 	bool HasSelectedActor() const;
 	bool CanMerge() const;
 	bool CanBatch() const;
 	bool CanAutoKeyword() const;
+	bool CanScanAudit() const;
+	bool CanConsolidate() const;
+	bool CanLoadIntoMerger() const;
+	bool CanBuildAtlas() const;
 	void OnDownScaleClicked();
 	void OnResetSizeClicked();
+	void OnApplySuggestedSizeClicked();
+	bool CanApplySuggestedSize() const;
 	void OnBrowseToClicked();
+	void OnAnalyzeChannelsClicked();
+	void OnAnalyzeDensityClicked();
 	void OnFindActorClicked();
 	FReply OnFindTextureClicked();
+	FReply OnBuildAtlasClicked();
 	FReply OnMergeClicked();
 	FReply OnBatchClicked();
+	FReply OnSavePresetClicked();
 	FReply OnAutoSuffixClicked();
+	TSharedRef<SWidget> OnGetMineKeywordsMenu();
+	FReply OnFindDuplicatesClicked();
+	FReply OnConsolidateClicked();
+	FReply OnFindChannelWasteClicked();
+	FReply OnPlanPackingClicked();
+	FReply OnFindCompressionWasteClicked();
+	FReply OnApplyCompressionClicked();
+	bool CanApplyCompression() const;
+	void OnLoadIntoMergerClicked();
+	void OnBrowseToAuditClicked();
 	void OpenTextureEditor(TSharedPtr<FTextureListItem> Item);
 
 	FTextureItemArray TextureListItems;
 	TSharedPtr<STextureListView> TextureListView;
 
-	TSharedPtr<FAssetThumbnailPool> AssetThumbnailPool;
+	TSharedPtr<FTextureThumbnailCache> ThumbnailCache;
+	FAuditItemArray AuditListItems;
+	TSharedPtr<SAuditListView> AuditListView;
+	TArray<FTextureDuplicateGroup> DuplicateGroups;
+	TArray<FTexturePackingProposal> PackingProposals;
+	TArray<FTextureCompressionProposal> CompressionProposals;
+
 	TSharedPtr<IDetailsView> SettingsDetailsView;
+	TSharedPtr<IDetailsView> AuditDetailsView;
 	TSharedPtr<SWidget> FinderWidget;
 	TSharedPtr<SWidget> MergerWidget;
+	TSharedPtr<SWidget> AuditWidget;
 	TSharedPtr<SBox> InlineContentHolder;
 	EToolMode Mode;
 };
\ No newline at end of file
@@ -26,8 +26,29 @@
 #include "Framework/MultiBox/MultiBoxBuilder.h"
 #include "Kismet/KismetStringLibrary.h"
 #include "Misc/FeedbackContext.h"
+#include "TextureMaterialRewriter.h"
+#include "TextureToolStats.h"
+#include "HAL/FileManager.h"
+#include "TextureMergeJournal.h"
+#include "TextureConsolidator.h"
+#include "TextureTiledMerge.h"
+#include "TextureMipChain.h"
+#include "Hash/CityHash.h"
+#include "UObject/StrongObjectPtr.h"
 #define LOCTEXT_NAMESPACE "TextureToolUI"
 
+DECLARE_CYCLE_STAT(TEXT("Match"), STAT_TextureTool_Match, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Match Registry Query"), STAT_TextureTool_MatchQuery, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Merge Draw"), STAT_TextureTool_MergeDraw, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch"), STAT_TextureTool_Batch, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch Registry Lookup"), STAT_TextureTool_BatchLookup, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch Package Load"), STAT_TextureTool_BatchLoad, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch Readback"), STAT_TextureTool_BatchReadback, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch Asset Created"), STAT_TextureTool_BatchAssetCreated, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch Rewire Materials"), STAT_TextureTool_BatchRewire, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch Consolidate"), STAT_TextureTool_BatchConsolidate, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Batch Save"), STAT_TextureTool_BatchSave, STATGROUP_TextureTool);
+
 UTextureMergeSettings* UTextureMergeSettings::Get()
 {
 	static UTextureMergeSettings* Settings = nullptr;
@@ -40,15 +61,36 @@ UTextureMergeSettings* UTextureMergeSettings::Get()
 	return Settings;
 }
 
+UTextureAuditSettings* UTextureAuditSettings::Get()
+{
+	static UTextureAuditSettings* Settings = nullptr;
+	if (!Settings)
+	{
+		Settings = DuplicateObject<UTextureAuditSettings>(GetMutableDefault<UTextureAuditSettings>(), GetTransientPackage());
+		Settings->AddToRoot();
+	}
+
+	return Settings;
+}
+
+bool UTextureAuditSettings::CanScan() const
+{
+	return !Directory.Path.IsEmpty();
+}
+
 UTextureMergeSettings::UTextureMergeSettings()
 {
 	ReplaceTexture.Optional = false;
+	SaveChunkSize = 32;
+	bMergeOnGPU = true;
+	OutputCompression = TC_Default;
 }
 
 bool MergeTextures(UTextureRenderTarget2D* RT,
-	UTexture2D* R, UTexture2D* G, UTexture2D* B, UTexture2D* A, FText& FailReason
+	UTexture2D* R, UTexture2D* G, UTexture2D* B, UTexture2D* A, const EChannel Channels[4], FText& FailReason
 	)
 {
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_MergeDraw);
 	int32 SizeX, SizeY;
 	auto GetSize = [](UTexture2D* T)
 	{
@@ -106,12 +148,17 @@ bool MergeTextures(UTextureRenderTarget2D* RT,
 	check(RT);
 	if (RT->SizeX != SizeX || RT->SizeY != SizeY)
 	{
+		LLM_SCOPE(ELLMTag::RenderTargets);
 		RT->InitAutoFormat(SizeX, SizeY);
 		RT->UpdateResourceImmediate(true);
 	}
 
 	auto MergeShader = LoadObject<UMaterialInterface>(nullptr, TEXT("Material'/TextureTool/Shader/MergeTexture.MergeTexture'"));
-	auto Merger = UMaterialInstanceDynamic::Create(MergeShader, GetTransientPackage());
+	UMaterialInstanceDynamic* Merger;
+	{
+		LLM_SCOPE(ELLMTag::Materials);
+		Merger = UMaterialInstanceDynamic::Create(MergeShader, GetTransientPackage());
+	}
 
 	static FName TextureParamR("TextureR");
 	static FName TextureParamG("TextureG");
@@ -121,15 +168,14 @@ bool MergeTextures(UTextureRenderTarget2D* RT,
 	static FName ChannelParamG("ChannelG");
 	static FName ChannelParamB("ChannelB");
 	static FName ChannelParamA("ChannelA");
-	auto Setting = UTextureMergeSettings::Get();
 	Merger->SetTextureParameterValue(TextureParamR, R);
 	Merger->SetTextureParameterValue(TextureParamG, G);
 	Merger->SetTextureParameterValue(TextureParamB, B);
 	Merger->SetTextureParameterValue(TextureParamA, A);
-	Merger->SetScalarParameterValue(ChannelParamR, (float)Setting->R.Channel);
-	Merger->SetScalarParameterValue(ChannelParamG, (float)Setting->G.Channel);
-	Merger->SetScalarParameterValue(ChannelParamB, (float)Setting->B.Channel);
-	Merger->SetScalarParameterValue(ChannelParamA, (float)Setting->A.Channel);
+	Merger->SetScalarParameterValue(ChannelParamR, (float)Channels[0]);
+	Merger->SetScalarParameterValue(ChannelParamG, (float)Channels[1]);
+	Merger->SetScalarParameterValue(ChannelParamB, (float)Channels[2]);
+	Merger->SetScalarParameterValue(ChannelParamA, (float)Channels[3]);
 	auto World = GEditor->GetEditorWorldContext().World();
 	UKismetRenderingLibrary::DrawMaterialToRenderTarget(World, RT, Merger);
 
@@ -171,17 +217,14 @@ bool UTextureMergeSettings::CanAutoKeyword() const
 	return I > 1;
 }
 
-bool UTextureMergeSettings::Match(TArray<FString>& Names)
+/** Groups of AssetsToSearch with a texture for every channel in use, Channels are R, G, B, A then ReplaceTexture */
+static void MatchChannels(const TArray<FAssetData>& AssetsToSearch, const FString& SrcPath, const FTextureChannelSrc* const Channels[5], TArray<FString>& Names)
 {
-	FString SrcPath = InputDirectory.Path;
-	if (SrcPath.IsEmpty())
-	{
-		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("SrcPathEmpty", "Input directory is empty!"));
-		return false;
-	}
-	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
-	TArray<FAssetData> AssetsToSearch;
-	AssetRegistry.GetAssetsByPath(FName(*SrcPath), AssetsToSearch, bRecursive);
+	const FTextureChannelSrc& R = *Channels[0];
+	const FTextureChannelSrc& G = *Channels[1];
+	const FTextureChannelSrc& B = *Channels[2];
+	const FTextureChannelSrc& A = *Channels[3];
+	const FTextureChannelSrc& ReplaceTexture = *Channels[4];
 
 	struct MergeGroup
 	{
@@ -198,7 +241,7 @@ bool UTextureMergeSettings::Match(TArray<FString>& Names)
 	int32 InPos;
 	TMap<FString, MergeGroup> MatchMap;
 
-	auto GetName = [&](FTextureChannelSrc& Src)
+	auto GetName = [&](const FTextureChannelSrc& Src)
 	{
 		if (!Src.Optional)
 			return FString();
@@ -258,6 +301,101 @@ bool UTextureMergeSettings::Match(TArray<FString>& Names)
 		if (Pair.Value.Size == ValidSize)
 			Names.Add(Pair.Key);
 	}
+}
+
+const UTextureMergePreset* UTextureMergeSettings::SplitMatchedName(const FString& Name, FString& OutGroupName) const
+{
+	FString PresetName;
+	if (!Name.Split(TEXT("|"), &PresetName, &OutGroupName))
+	{
+		OutGroupName = Name;
+		return nullptr;
+	}
+	// Presets of the same name may sit in different folders, only the path tells them apart
+	UTextureMergePreset* const* Preset = Presets.FindByPredicate([&](const UTextureMergePreset* Candidate) { return Candidate && Candidate->GetPathName() == PresetName; });
+	return Preset ? *Preset : nullptr;
+}
+
+void UTextureMergeSettings::GetChannels(const UTextureMergePreset* Preset, const FTextureChannelSrc* OutChannels[5]) const
+{
+	OutChannels[0] = Preset ? &Preset->R : &R;
+	OutChannels[1] = Preset ? &Preset->G : &G;
+	OutChannels[2] = Preset ? &Preset->B : &B;
+	OutChannels[3] = Preset ? &Preset->A : &A;
+	OutChannels[4] = Preset ? &Preset->ReplaceTexture : &ReplaceTexture;
+}
+
+FString UTextureMergeSettings::GetSourceObjectPath(const FString& GroupName, const FTextureChannelSrc& Src) const
+{
+	const FString PackageName = InputDirectory.Path / GroupName.Replace(TEXT("***"), *Src.Keyword);
+	return PackageName + TEXT(".") + FPaths::GetBaseFilename(PackageName);
+}
+
+FString UTextureMergeSettings::GetOutputName(const UTextureMergePreset* Preset, const FString& GroupName, const FString& SaveKeyword) const
+{
+	return GroupName.Replace(TEXT("***"), Preset && !Preset->OutputKeyword.IsEmpty() ? *Preset->OutputKeyword : *SaveKeyword);
+}
+
+bool UTextureMergeSettings::CheckOutputNames(const TArray<FString>& MatchedNames, const FString& SaveKeyword, FText& OutReason) const
+{
+	TMap<FString, FString> Outputs;
+	TArray<FString> Collisions;
+	for (const FString& Name : MatchedNames)
+	{
+		FString GroupName;
+		const FString Output = GetOutputName(SplitMatchedName(Name, GroupName), GroupName, SaveKeyword);
+		if (const FString* Other = Outputs.Find(Output))
+			Collisions.Add(FString::Printf(TEXT("%s: %s, %s"), *Output, **Other, *Name));
+		else
+			Outputs.Add(Output, Name);
+	}
+	if (Collisions.Num() == 0)
+		return true;
+	OutReason = FText::Format(LOCTEXT("OutputCollision", "Several presets would write the same outputs, give them distinct Output Keywords:\n{0}"), FText::FromString(FString::Join(Collisions, TEXT("\n"))));
+	return false;
+}
+
+bool UTextureMergeSettings::Match(TArray<FString>& Names)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_Match);
+	FString SrcPath = InputDirectory.Path;
+	if (SrcPath.IsEmpty())
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("SrcPathEmpty", "Input directory is empty!"));
+		return false;
+	}
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	TArray<FAssetData> AssetsToSearch;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_MatchQuery);
+		AssetRegistry.GetAssetsByPath(FName(*SrcPath), AssetsToSearch, bRecursive);
+	}
+
+	if (!Presets.ContainsByPredicate([](const UTextureMergePreset* Preset) { return Preset != nullptr; }))
+	{
+		const FTextureChannelSrc* Channels[5] = { &R, &G, &B, &A, &ReplaceTexture };
+		MatchChannels(AssetsToSearch, SrcPath, Channels, Names);
+		return Names.Num() > 0;
+	}
+
+	// One registry query for every preset, groups of the same name end up next to each other so their sources are shared
+	for (const UTextureMergePreset* Preset : Presets)
+	{
+		if (!Preset)
+			continue;
+		TArray<FString> PresetNames;
+		const FTextureChannelSrc* Channels[5] = { &Preset->R, &Preset->G, &Preset->B, &Preset->A, &Preset->ReplaceTexture };
+		MatchChannels(AssetsToSearch, SrcPath, Channels, PresetNames);
+		for (const FString& Name : PresetNames)
+			Names.Add(Preset->GetPathName() + TEXT("|") + Name);
+	}
+	Names.Sort([](const FString& A, const FString& B)
+	{
+		FString PresetA, GroupA, PresetB, GroupB;
+		A.Split(TEXT("|"), &PresetA, &GroupA);
+		B.Split(TEXT("|"), &PresetB, &GroupB);
+		return GroupA != GroupB ? GroupA < GroupB : PresetA < PresetB;
+	});
 	return Names.Num() > 0;
 }
 
@@ -320,20 +458,38 @@ void UTextureMergeSettings::Merge()
 	FEditorDirectories::Get().SetLastDirectory(ELastDirectory::NEW_ASSET, SavePackagePath);
 	PackageName = UPackageTools::SanitizePackageName(SavePackagePath / AssetName);
 
-	UTextureRenderTarget2D* RT = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
-	RT->RenderTargetFormat = RTF_RGBA16f;
-	if (!MergeTextures(RT,
-		R.Optional ? R.Texture : nullptr,
-		G.Optional ? G.Texture : nullptr,
-		B.Optional ? B.Texture : nullptr,
-		A.Optional ? A.Texture : nullptr,
-		FailureReason
-		))
-	{
-		FMessageDialog::Open(EAppMsgType::Ok, FailureReason);
-		return;
+	UTexture2D* ST;
+	// The render target has no mip chain of its own, channels with their own mip filter are merged on the CPU
+	const EMipFilter MipFilters[4] = { R.MipFilter, G.MipFilter, B.MipFilter, A.MipFilter };
+	if (bMergeOnGPU && !FTextureMipChain::NeedsMipChain(MipFilters))
+	{
+		UTextureRenderTarget2D* RT = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+		RT->RenderTargetFormat = RTF_RGBA16f;
+		const EChannel Channels[4] = { R.Channel, G.Channel, B.Channel, A.Channel };
+		if (!MergeTextures(RT,
+			R.Optional ? R.Texture : nullptr,
+			G.Optional ? G.Texture : nullptr,
+			B.Optional ? B.Texture : nullptr,
+			A.Optional ? A.Texture : nullptr,
+			Channels, FailureReason
+			))
+		{
+			FMessageDialog::Open(EAppMsgType::Ok, FailureReason);
+			return;
+		}
+		ST = RT->ConstructTexture2D(CreatePackage(NULL, *PackageName), SaveAssetName, Flags, CTF_Default, NULL);
+	}
+	else
+	{
+		UTexture2D* Sources[4] = { R.Optional ? R.Texture : nullptr, G.Optional ? G.Texture : nullptr, B.Optional ? B.Texture : nullptr, A.Optional ? A.Texture : nullptr };
+		const FTextureChannelSrc* Channels[4] = { &R, &G, &B, &A };
+		ST = FTextureTiledMerge::Merge(CreatePackage(NULL, *PackageName), SaveAssetName, Flags, Sources, Channels, FailureReason);
+		if (!ST)
+		{
+			FMessageDialog::Open(EAppMsgType::Ok, FailureReason);
+			return;
+		}
 	}
-	UTexture2D* ST = RT->ConstructTexture2D(CreatePackage(NULL, *PackageName), SaveAssetName, Flags, CTF_Default, NULL);
 	TArray<UObject*> Results;
 	if (ST)
 	{
@@ -350,6 +506,15 @@ void UTextureMergeSettings::Merge()
 		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("FailToSave", "Fail to save output texture!"));
 		return;
 	}
+	// Rewire before consolidating, materials must still sample the sources to be found
+	if (bRewireMaterials)
+	{
+		UTexture2D* Sources[4] = { R.Optional ? R.Texture : nullptr, G.Optional ? G.Texture : nullptr, B.Optional ? B.Texture : nullptr, A.Optional ? A.Texture : nullptr };
+		const EChannel SourceChannels[4] = { R.Channel, G.Channel, B.Channel, A.Channel };
+		FTextureMaterialRewriter Rewriter;
+		Rewriter.AddPacking(ST, Sources, SourceChannels);
+		Rewriter.Apply();
+	}
 	if (ReplaceTexture.Optional && IsValid(ReplaceTexture.Texture))
 	{
 		TArray<UObject*> ToReplace;
@@ -362,6 +527,23 @@ void UTextureMergeSettings::Merge()
 	return;
 }
 
+FString UTextureMergeSettings::GetBatchFingerprint(const FString& SavePackagePath, const FString& SaveKeyword) const
+{
+	FString Key = FString::Printf(TEXT("%s|%d|%s|%s|%d|%d|%d|%d"), *InputDirectory.Path, bRecursive, *SavePackagePath, *SaveKeyword, bRewireMaterials, bSaveOutputs, (int32)OutputCompression, bMergeOnGPU);
+	for (const FTextureChannelSrc* Src : { &R, &G, &B, &A, &ReplaceTexture })
+		Key += FString::Printf(TEXT("|%s|%d|%d|%d|%g"), *Src->Keyword, (int32)Src->Channel, Src->Optional, (int32)Src->MipFilter, Src->CoverageThreshold);
+	for (const UTextureMergePreset* Preset : Presets)
+	{
+		if (!Preset)
+			continue;
+		Key += FString::Printf(TEXT("|%s|%s"), *Preset->GetPathName(), *Preset->OutputKeyword);
+		for (const FTextureChannelSrc* Src : { &Preset->R, &Preset->G, &Preset->B, &Preset->A, &Preset->ReplaceTexture })
+			Key += FString::Printf(TEXT("|%s|%d|%d|%d|%g"), *Src->Keyword, (int32)Src->Channel, Src->Optional, (int32)Src->MipFilter, Src->CoverageThreshold);
+	}
+	const FTCHARToUTF8 Utf8(*Key);
+	return FString::Printf(TEXT("%016llx"), CityHash64(Utf8.Get(), Utf8.Length()));
+}
+
 void UTextureMergeSettings::Batch(const TArray<FString>& MatchedNames)
 {
 	FString SrcPath = InputDirectory.Path;
@@ -405,38 +587,198 @@ void UTextureMergeSettings::Batch(const TArray<FString>& MatchedNames)
 	FEditorDirectories::Get().SetLastDirectory(ELastDirectory::NEW_ASSET, SavePackagePath);
 	PackageName = UPackageTools::SanitizePackageName(SavePackagePath / AssetName);
 
+	FText CollisionReason;
+	if (!CheckOutputNames(MatchedNames, SaveKeyword, CollisionReason))
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, CollisionReason);
+		return;
+	}
+
+	FTextureMergeJournal Journal(GetBatchFingerprint(SavePackagePath, SaveKeyword));
+	if (Journal.GetCompleted().Num() > 0)
+	{
+		const FText Message = FText::Format(LOCTEXT("ResumeBatch", "A batch with the same settings stopped after {0} of {1} groups.\nResume it? No starts over."), Journal.GetCompleted().Num(), MatchedNames.Num());
+		const EAppReturnType::Type Answer = FMessageDialog::Open(EAppMsgType::YesNoCancel, Message);
+		if (Answer == EAppReturnType::Cancel)
+			return;
+		if (Answer == EAppReturnType::No)
+			Journal.Reset();
+	}
+
+	TArray<UObject*> Results;
+	ExecuteBatch(MatchedNames, SavePackagePath, SaveKeyword, Journal, Results);
+	ContentBrowserModule.Get().SyncBrowserToAssets(Results);
+}
+
+bool UTextureMergeSettings::ExecuteBatch(const TArray<FString>& MatchedNames, const FString& SavePackagePath, const FString& SaveKeyword, FTextureMergeJournal& Journal, TArray<UObject*>& Results)
+{
+	const FString SrcPath = InputDirectory.Path;
+
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_Batch);
+	const double BatchStartTime = FPlatformTime::Seconds();
+	FTextureToolBatchReport Report;
+	FTextureToolMemoryTracker Memory;
 	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
 	FText FailureReason;
 	UTextureRenderTarget2D* RT = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
 	RT->RenderTargetFormat = RTF_RGBA16f;
-	GWarn->BeginSlowTask(LOCTEXT("PerformBatchMerge", "Performing Merge"), true, false);
+	// Garbage is collected between save chunks
+	TStrongObjectPtr<UTextureRenderTarget2D> RTReference(RT);
+	Memory.Track(ETextureToolMemory::RenderTargets, RT);
+	GWarn->BeginSlowTask(LOCTEXT("PerformBatchMerge", "Performing Merge"), true, true);
 	int32 Size = MatchedNames.Num();
 	int32 I = 0;
-	TArray<UObject*> Results;
+	bool bCancelled = false;
+	FTextureMaterialRewriter Rewriter;
+	// Replaced textures are consolidated together at the end, a single pass over their referencers
+	FTextureConsolidator Consolidator;
+	// Sources shared by the presets of a group are looked up and loaded once, and decoded once while they fit in the cache
+	TMap<FString, UTexture2D*> LoadedSources;
+	FTextureSourceDecodeCache DecodeCache;
+	// Sources the batch loaded, and those it released which the next garbage collection has not freed yet
+	TArray<UTexture2D*> BatchSources;
+	TSet<UTexture2D*> ReleasedSources;
+	FString LastGroupName;
+	// Names are sorted by group, the sources of a finished group are not used again
+	auto ReleaseSources = [&]()
+	{
+		for (UTexture2D* Source : BatchSources)
+		{
+			// Materials are rewired and replaced textures consolidated at the end of the batch, they need their sources
+			if (bRewireMaterials || Consolidator.Contains(Source) || Source->GetOutermost()->IsDirty())
+				continue;
+			Source->ClearFlags(RF_Standalone);
+			ReleasedSources.Add(Source);
+		}
+		BatchSources.Reset();
+		LoadedSources.Reset();
+		DecodeCache.Reset();
+	};
+	// Output by matched name, the name is what the journal records
+	TArray<TPair<FString, UTexture2D*>> PendingSaves;
+	TArray<FString> SavedFiles;
+	// Matched name and package of saves whose file may still be in flight, journaled once the writes are done
+	TArray<TPair<FString, FString>> UnjournaledSaves;
+	auto JournalWrittenSaves = [&]()
+	{
+		UPackage::WaitForAsyncFileWrites();
+		for (auto& Saved : UnjournaledSaves)
+			Journal.Append(Saved.Key, Saved.Value);
+		UnjournaledSaves.Reset();
+	};
+	// Serialization has to run on the game thread, SAVE_Async hands the file writes to a background thread.
+	// The previous chunk had this whole chunk's merge to be written, it is only journaled now, a crash before leaves it to be merged again
+	auto SaveOutputs = [&]()
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchSave);
+		FTextureToolStageTimer Timer(&Report, TEXT("Save"));
+		JournalWrittenSaves();
+		for (auto& Pending : PendingSaves)
+		{
+			UTexture2D* Texture = Pending.Value;
+			UPackage* Package = Texture->GetOutermost();
+			const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+			if (UPackage::SavePackage(Package, Texture, RF_Standalone, *Filename, GWarn, nullptr, false, true, SAVE_Async | SAVE_NoError))
+			{
+				SavedFiles.Add(Filename);
+				UnjournaledSaves.Emplace(Pending.Key, Package->GetName());
+			}
+			else
+				UE_LOG(LogTemp, Error, TEXT("Fail to save %s"), *Package->GetName());
+		}
+		PendingSaves.Reset();
+	};
 	for (auto& Name : MatchedNames)
 	{
+		if (GWarn->ReceivedUserCancel())
+		{
+			bCancelled = true;
+			break;
+		}
 		GWarn->StatusUpdate(I, Size, FText::FromString(Name));
-		auto GetTexture = [&](FTextureChannelSrc& Src) -> UTexture2D*
+		const double GroupStartTime = FPlatformTime::Seconds();
+		FString GroupName;
+		const UTextureMergePreset* Preset = SplitMatchedName(Name, GroupName);
+		if (GroupName != LastGroupName)
+		{
+			ReleaseSources();
+			LastGroupName = GroupName;
+		}
+		const FTextureChannelSrc& SrcR = Preset ? Preset->R : R;
+		const FTextureChannelSrc& SrcG = Preset ? Preset->G : G;
+		const FTextureChannelSrc& SrcB = Preset ? Preset->B : B;
+		const FTextureChannelSrc& SrcA = Preset ? Preset->A : A;
+		const FTextureChannelSrc& SrcReplace = Preset ? Preset->ReplaceTexture : ReplaceTexture;
+		const EChannel SourceChannels[4] = { SrcR.Channel, SrcG.Channel, SrcB.Channel, SrcA.Channel };
+		const EMipFilter MipFilters[4] = { SrcR.MipFilter, SrcG.MipFilter, SrcB.MipFilter, SrcA.MipFilter };
+		const bool bOnGPU = bMergeOnGPU && !FTextureMipChain::NeedsMipChain(MipFilters);
+		auto GetTexture = [&](const FTextureChannelSrc& Src) -> UTexture2D*
 		{
 			if (!Src.Optional)
 				return nullptr;
-			auto RelativePath = Name.Replace(TEXT("***"), *Src.Keyword);
+			auto RelativePath = GroupName.Replace(TEXT("***"), *Src.Keyword);
 			auto PackageName = SrcPath / RelativePath;
 			auto ObjectName = FPaths::GetBaseFilename(PackageName);
 			auto ObjectPath = PackageName + TEXT(".") + ObjectName;
-			FAssetData Texture = AssetRegistry.GetAssetByObjectPath(*(ObjectPath));
-			return (UTexture2D*)Texture.GetAsset();
+			if (UTexture2D** Loaded = LoadedSources.Find(ObjectPath))
+				return *Loaded;
+			FAssetData Texture;
+			{
+				SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchLookup);
+				FTextureToolStageTimer Timer(&Report, TEXT("RegistryLookup"));
+				Texture = AssetRegistry.GetAssetByObjectPath(*(ObjectPath));
+			}
+			SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchLoad);
+			LLM_SCOPE(ELLMTag::Textures);
+			FTextureToolStageTimer Timer(&Report, TEXT("PackageLoad"));
+			const bool bWasLoaded = Texture.IsAssetLoaded();
+			UTexture2D* Loaded = (UTexture2D*)Texture.GetAsset();
+			// Released with an earlier group but still in memory, it must survive until this group is done
+			if (Loaded && (!bWasLoaded || ReleasedSources.Remove(Loaded) > 0))
+			{
+				Loaded->SetFlags(RF_Standalone);
+				BatchSources.Add(Loaded);
+			}
+			Memory.Track(ETextureToolMemory::Sources, Loaded);
+			LoadedSources.Add(ObjectPath, Loaded);
+			return Loaded;
 		};
-		auto TR = GetTexture(R);
-		auto TG = GetTexture(G);
-		auto TB = GetTexture(B);
-		auto TA = GetTexture(A);
-		if (!MergeTextures(RT, TR, TG, TB, TA, FailureReason))
+		// Merged by an interrupted run, only the steps done at the end of the batch are left
+		const FString AssetName = GetOutputName(Preset, GroupName, SaveKeyword);
+		if (const FString* Output = Journal.GetCompleted().Find(Name))
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s merge failed due to %s"), *Name, *FailureReason.ToString());
-			continue;
+			if (UTexture2D* ST = LoadObject<UTexture2D>(nullptr, *FString::Printf(TEXT("%s.%s"), **Output, *FPaths::GetBaseFilename(AssetName))))
+			{
+				if (bRewireMaterials)
+				{
+					UTexture2D* Sources[4] = { GetTexture(SrcR), GetTexture(SrcG), GetTexture(SrcB), GetTexture(SrcA) };
+					Rewriter.AddPacking(ST, Sources, SourceChannels);
+				}
+				Consolidator.Add(GetTexture(SrcReplace), ST);
+				Results.Add(ST);
+				++I;
+				continue;
+			}
 		}
-		EObjectFlags Flags;
+
+		auto TR = GetTexture(SrcR);
+		auto TG = GetTexture(SrcG);
+		auto TB = GetTexture(SrcB);
+		auto TA = GetTexture(SrcA);
+		if (bOnGPU)
+		{
+			bool bMerged;
+			{
+				FTextureToolStageTimer Timer(&Report, TEXT("Draw"));
+				bMerged = MergeTextures(RT, TR, TG, TB, TA, SourceChannels, FailureReason);
+			}
+			if (!bMerged)
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s merge failed due to %s"), *Name, *FailureReason.ToString());
+				continue;
+			}
+		}
+		EObjectFlags Flags = RF_Public | RF_Standalone;
 		if (TR)
 			Flags = TR->GetFlags();
 		else if (TG)
@@ -445,13 +787,29 @@ void UTextureMergeSettings::Batch(const TArray<FString>& MatchedNames)
 			Flags = TB->GetFlags();
 		else if (TA)
 			Flags = TA->GetFlags();
-		const FString AssetName = Name.Replace(TEXT("***"), *SaveKeyword);
-		const FString SavePackageName = FPackageName::ObjectPathToPackageName(SavePackagePath / AssetName);
-		FEditorDirectories::Get().SetLastDirectory(ELastDirectory::NEW_ASSET, SavePackagePath);
 		const FString PackageName = UPackageTools::SanitizePackageName(SavePackagePath / AssetName);
-		UTexture2D* ST = RT->ConstructTexture2D(CreatePackage(NULL, *PackageName), AssetName, Flags, CTF_Default, NULL);
+		UTexture2D* ST;
+		if (bOnGPU)
+		{
+			// Waits for the draw on the GPU, then builds the texture from the pixels read back
+			SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchReadback);
+			LLM_SCOPE(ELLMTag::Textures);
+			FTextureToolStageTimer Timer(&Report, TEXT("Readback"));
+			ST = RT->ConstructTexture2D(CreatePackage(NULL, *PackageName), AssetName, Flags, CTF_Default, NULL);
+		}
+		else
+		{
+			FTextureToolStageTimer Timer(&Report, TEXT("TiledMerge"));
+			UTexture2D* Sources[4] = { TR, TG, TB, TA };
+			const FTextureChannelSrc* Channels[4] = { &SrcR, &SrcG, &SrcB, &SrcA };
+			ST = FTextureTiledMerge::Merge(CreatePackage(NULL, *PackageName), AssetName, Flags, Sources, Channels, FailureReason, &Memory, &DecodeCache, OutputCompression);
+			if (!ST)
+				UE_LOG(LogTemp, Error, TEXT("%s merge failed due to %s"), *Name, *FailureReason.ToString());
+		}
 		if (ST)
 		{
+			SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchAssetCreated);
+			FTextureToolStageTimer Timer(&Report, TEXT("AssetCreated"));
 			// package needs saving
 			ST->MarkPackageDirty();
 
@@ -459,43 +817,98 @@ void UTextureMergeSettings::Batch(const TArray<FString>& MatchedNames)
 			FAssetRegistryModule::AssetCreated(ST);
 
 			Results.Add(ST);
+			// Once per group, a CPU merge has tracked its output already
+			Memory.Track(ETextureToolMemory::Outputs, ST);
+			Memory.Sample();
 		}
 		else
 		{
 			UE_LOG(LogTemp, Error, TEXT("Fail to save %s"), *Name);
 			continue;
 		}
-		auto RP = GetTexture(ReplaceTexture);
-		if (RP)
+		if (bRewireMaterials)
+		{
+			UTexture2D* Sources[4] = { TR, TG, TB, TA };
+			Rewriter.AddPacking(ST, Sources, SourceChannels);
+		}
+		Consolidator.Add(GetTexture(SrcReplace), ST);
+		Report.AddGroup(FPlatformTime::Seconds() - GroupStartTime, (int64)ST->GetSizeX() * ST->GetSizeY());
+		if (bSaveOutputs)
 		{
-			TArray<UObject*> ToReplace;
-			ToReplace.Add(RP);
-			ObjectTools::ConsolidateObjects(ST, ToReplace);
+			PendingSaves.Emplace(Name, ST);
+			if (PendingSaves.Num() >= SaveChunkSize)
+			{
+				SaveOutputs();
+				// Frees released sources and the transient merge materials and render data of the chunk
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+				ReleasedSources.Reset();
+			}
+		}
+		else
+		{
+			// Resumable only if the package is saved before the run stops, checked when resuming
+			Journal.Append(Name, ST->GetOutermost()->GetName());
 		}
 		++I;
 	}
-	ContentBrowserModule.Get().SyncBrowserToAssets(Results);
+	if (bSaveOutputs)
+	{
+		SaveOutputs();
+		{
+			FTextureToolStageTimer Timer(&Report, TEXT("Save"));
+			JournalWrittenSaves();
+		}
+		int64 SavedBytes = 0;
+		for (const FString& Filename : SavedFiles)
+			SavedBytes += FMath::Max<int64>(IFileManager::Get().FileSize(*Filename), 0);
+		Report.AddSaved(SavedFiles.Num(), SavedBytes);
+	}
+	// Rewiring and consolidation of the completed groups are left to the resumed run
+	if (bCancelled)
+	{
+		GWarn->EndSlowTask();
+		UE_LOG(LogTemp, Warning, TEXT("Batch cancelled after %d of %d groups, run it again with the same settings to resume"), I, Size);
+		return false;
+	}
+	// Materials are rewired in one batch, before consolidation removes the sources they reference
+	if (bRewireMaterials)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchRewire);
+		FTextureToolStageTimer Timer(&Report, TEXT("RewireMaterials"));
+		GWarn->StatusUpdate(I, Size, LOCTEXT("RewireMaterials", "Rewiring materials"));
+		Rewriter.Apply();
+	}
+	if (Consolidator.Num() > 0)
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchConsolidate);
+		FTextureToolStageTimer Timer(&Report, TEXT("Consolidate"));
+		GWarn->StatusUpdate(I, Size, LOCTEXT("ConsolidateTextures", "Consolidating replaced textures"));
+		Consolidator.Apply();
+	}
 	GWarn->EndSlowTask();
-	
-	return;
+	Journal.Delete();
+	const double BatchSeconds = FPlatformTime::Seconds() - BatchStartTime;
+	Memory.Finish(TEXT("BatchMerge"));
+	Report.Finish(TEXT("BatchMerge"), BatchSeconds, &Memory);
+	return true;
 }
 
 FString GetCommonPrefix(const FString& A, const FString& B)
 {
-	FString Result;
-	int32 N = FMath::Min(A.Len(), B.Len());
-	for (int32 i = 0; i < N && A[i] == B[i]; ++i)
-		Result.AppendChar(A[i]);
-	return Result;
+	const int32 N = FMath::Min(A.Len(), B.Len());
+	int32 i = 0;
+	while (i < N && A[i] == B[i])
+		++i;
+	return A.Left(i);
 }
 
 FString GetCommonSuffix(const FString& A, const FString& B)
 {
-	FString Result;
-	int32 N = FMath::Min(A.Len(), B.Len());
-	for (int32 i = 0; i < N && A[A.Len() - i - 1] == B[B.Len() - i - 1]; ++i)
-		Result.AppendChar(A[A.Len() - i - 1]);
-	return Result.Reverse();
+	const int32 N = FMath::Min(A.Len(), B.Len());
+	int32 i = 0;
+	while (i < N && A[A.Len() - i - 1] == B[B.Len() - i - 1])
+		++i;
+	return A.Right(i);
 }
 
 void UTextureMergeSettings::AutoKeyword()
@@ -553,4 +966,49 @@ void UTextureMergeSettings::AutoKeyword()
 		ReplaceTexture.Keyword = Name.Mid(Prefix.Len(), Name.Len() - Prefix.Len() - Suffix.Len());
 	}
 	return;
-}
\ No newline at end of file
+}
+
+void UTextureMergeSettings::SaveAsPreset()
+{
+	FAssetToolsModule& AssetToolsModule = FModuleManager::Get().LoadModuleChecked<FAssetToolsModule>("AssetTools");
+	FString AssetPath;
+
+	const FString DefaultFilesystemDirectory = FEditorDirectories::Get().GetLastDirectory(ELastDirectory::NEW_ASSET);
+	if (DefaultFilesystemDirectory.IsEmpty() || !FPackageName::TryConvertFilenameToLongPackageName(DefaultFilesystemDirectory, AssetPath))
+		AssetPath = TEXT("/Game");
+
+	FString PackageName;
+	FString AssetName;
+	AssetToolsModule.Get().CreateUniqueAssetName(AssetPath / TEXT("MergePreset"), TEXT(""), PackageName, AssetName);
+
+	FSaveAssetDialogConfig SaveAssetDialogConfig;
+	SaveAssetDialogConfig.DialogTitleOverride = LOCTEXT("SaveAssetDialogTitle_Preset", "Save Merge Preset As");
+	SaveAssetDialogConfig.DefaultPath = AssetPath;
+	SaveAssetDialogConfig.DefaultAssetName = AssetName;
+	SaveAssetDialogConfig.ExistingAssetPolicy = ESaveAssetDialogExistingAssetPolicy::Disallow;
+
+	FContentBrowserModule& ContentBrowserModule = FModuleManager::LoadModuleChecked<FContentBrowserModule>("ContentBrowser");
+	FString SaveObjectPath = ContentBrowserModule.Get().CreateModalSaveAssetDialog(SaveAssetDialogConfig);
+	if (SaveObjectPath.IsEmpty())
+		return;
+
+	const FString SavePackageName = FPackageName::ObjectPathToPackageName(SaveObjectPath);
+	FEditorDirectories::Get().SetLastDirectory(ELastDirectory::NEW_ASSET, FPaths::GetPath(SavePackageName));
+	UTextureMergePreset* Preset = NewObject<UTextureMergePreset>(CreatePackage(NULL, *SavePackageName), *FPaths::GetBaseFilename(SavePackageName), RF_Public | RF_Standalone);
+	Preset->CopyFrom(this);
+	Preset->MarkPackageDirty();
+	FAssetRegistryModule::AssetCreated(Preset);
+	Presets.AddUnique(Preset);
+	ContentBrowserModule.Get().SyncBrowserToAssets(TArray<UObject*>({ Preset }));
+}
+
+void UTextureMergePreset::CopyFrom(const UTextureMergeSettings* Settings)
+{
+	R = Settings->R;
+	G = Settings->G;
+	B = Settings->B;
+	A = Settings->A;
+	ReplaceTexture = Settings->ReplaceTexture;
+	for (FTextureChannelSrc* Src : { &R, &G, &B, &A, &ReplaceTexture })
+		Src->Texture = nullptr;
+}
@@ -0,0 +1,252 @@
+#include "TextureAnalysisCache.h"
+#include "AssetData.h"
+#include "AssetRegistryModule.h"
+#include "Engine/Texture2D.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+#include "Hash/CityHash.h"
+
+static const uint32 AnalysisCacheMagic = 0x43415454; // "TTAC"
+static const uint32 AnalysisCacheFileVersion = 1;
+static const uint32 PackageSourceVersion = 2;
+
+static bool EntryLess(const FGuid& KeyA, uint32 KindA, const FGuid& KeyB, uint32 KindB)
+{
+	return KeyA != KeyB ? KeyA < KeyB : KindA < KindB;
+}
+
+FTextureAnalysisCache& FTextureAnalysisCache::Get()
+{
+	static FTextureAnalysisCache Cache;
+	return Cache;
+}
+
+FTextureAnalysisCache::FTextureAnalysisCache()
+{
+	Filename = FPaths::ProjectSavedDir() / TEXT("TextureTool") / TEXT("AnalysisCache.bin");
+	Open();
+}
+
+FTextureAnalysisCache::~FTextureAnalysisCache()
+{
+	Close();
+}
+
+void FTextureAnalysisCache::Open()
+{
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+	MappedHandle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+	if (MappedHandle)
+	{
+		MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+		if (MappedRegion)
+		{
+			Data = MappedRegion->GetMappedPtr();
+			Size = MappedRegion->GetMappedSize();
+		}
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedData, *Filename, FILEREAD_Silent))
+	{
+		Data = LoadedData.GetData();
+		Size = LoadedData.Num();
+	}
+
+	if (!Data || Size < (int64)sizeof(FFileHeader))
+		return;
+	const FFileHeader* Header = (const FFileHeader*)Data;
+	const int64 ExpectedSize = sizeof(FFileHeader) + (int64)Header->NumEntries * sizeof(FFileEntry) + Header->BlobSize;
+	if (Header->Magic != AnalysisCacheMagic || Header->FileVersion != AnalysisCacheFileVersion || Size < ExpectedSize)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Ignore texture analysis cache %s, it is outdated or truncated"), *Filename);
+		return;
+	}
+	Entries = (const FFileEntry*)(Data + sizeof(FFileHeader));
+	NumEntries = Header->NumEntries;
+	Blob = (const uint8*)(Entries + NumEntries);
+	for (int32 Index = 0; Index < NumEntries; ++Index)
+		NoteVersion(Entries[Index].Kind, Entries[Index].Version);
+}
+
+void FTextureAnalysisCache::Close()
+{
+	Entries = nullptr;
+	NumEntries = 0;
+	Blob = nullptr;
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+	LoadedData.Empty();
+}
+
+const FTextureAnalysisCache::FFileEntry* FTextureAnalysisCache::FindEntry(const FGuid& Key, ETextureAnalysis Kind) const
+{
+	int32 Begin = 0, End = NumEntries;
+	while (Begin < End)
+	{
+		const int32 Middle = (Begin + End) / 2;
+		if (EntryLess(Entries[Middle].Key, Entries[Middle].Kind, Key, (uint32)Kind))
+			Begin = Middle + 1;
+		else
+			End = Middle;
+	}
+	return Begin < NumEntries && Entries[Begin].Key == Key && Entries[Begin].Kind == (uint32)Kind ? &Entries[Begin] : nullptr;
+}
+
+void FTextureAnalysisCache::NoteVersion(uint32 Kind, uint32 Version) const
+{
+	uint32& Latest = LatestVersions.FindOrAdd(Kind);
+	Latest = FMath::Max(Latest, Version);
+}
+
+bool FTextureAnalysisCache::FindRaw(const FGuid& Key, ETextureAnalysis Kind, uint32 Version, void* OutResult, int32 Size) const
+{
+	NoteVersion((uint32)Kind, Version);
+	if (const FPendingResult* Result = Pending.Find(TPair<FGuid, uint32>(Key, (uint32)Kind)))
+	{
+		if (Result->Version != Version || Result->Data.Num() != Size)
+			return false;
+		FMemory::Memcpy(OutResult, Result->Data.GetData(), Size);
+		return true;
+	}
+	const FFileEntry* Entry = FindEntry(Key, Kind);
+	if (!Entry || Entry->Version != Version || Entry->Size != (uint32)Size)
+		return false;
+	FMemory::Memcpy(OutResult, Blob + Entry->Offset, Size);
+	return true;
+}
+
+void FTextureAnalysisCache::AddRaw(const FGuid& Key, ETextureAnalysis Kind, uint32 Version, const void* Result, int32 Size)
+{
+	NoteVersion((uint32)Kind, Version);
+	FPendingResult& Entry = Pending.Add(TPair<FGuid, uint32>(Key, (uint32)Kind));
+	Entry.Version = Version;
+	Entry.Data.SetNumUninitialized(Size);
+	FMemory::Memcpy(Entry.Data.GetData(), Result, Size);
+}
+
+bool FTextureAnalysisCache::FindSourceId(const FAssetData& Asset, FGuid& OutSourceId) const
+{
+	if (Asset.IsAssetLoaded())
+	{
+		UTexture2D* Texture = Cast<UTexture2D>(Asset.GetAsset());
+		if (Texture)
+			OutSourceId = Texture->Source.GetId();
+		return Texture != nullptr;
+	}
+	// Package GUID changes on every save, an unchanged GUID means an unchanged source
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	const FAssetPackageData* PackageData = AssetRegistry.GetAssetPackageData(Asset.PackageName);
+	FPackageSource PackageSource;
+	if (!PackageData || !Find(PackageData->PackageGuid, ETextureAnalysis::PackageSource, PackageSourceVersion, PackageSource))
+		return false;
+	OutSourceId = PackageSource.SourceId;
+	return true;
+}
+
+void FTextureAnalysisCache::AddSourceId(const FAssetData& Asset, const FGuid& SourceId)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	if (const FAssetPackageData* PackageData = AssetRegistry.GetAssetPackageData(Asset.PackageName))
+	{
+		const FString PackageName = Asset.PackageName.ToString();
+		const FTCHARToUTF8 Utf8(*PackageName);
+		const FPackageSource PackageSource = { SourceId, CityHash64(Utf8.Get(), Utf8.Length()) };
+		Add(PackageData->PackageGuid, ETextureAnalysis::PackageSource, PackageSourceVersion, PackageSource);
+	}
+}
+
+void FTextureAnalysisCache::Flush()
+{
+	if (Pending.Num() == 0)
+		return;
+
+	// Merge the mapped table with new results, both sorted, new results win
+	struct FMergedEntry
+	{
+		FGuid Key;
+		uint32 Kind;
+		uint32 Version;
+		const uint8* Data;
+		uint32 Size;
+	};
+	auto IsLatestVersion = [&](uint32 Kind, uint32 Version) { return Version >= LatestVersions.FindRef(Kind); };
+	// A package GUID changes on every save, the one seen last replaces the older ones of its package
+	TMap<uint64, FGuid> LatestPackageGuids;
+	auto GetPackageNameHash = [&](uint32 Kind, uint32 Version, const uint8* Data, uint32 Size, uint64& OutHash)
+	{
+		if (Kind != (uint32)ETextureAnalysis::PackageSource || Version != PackageSourceVersion || Size != sizeof(FPackageSource))
+			return false;
+		OutHash = ((const FPackageSource*)Data)->PackageNameHash;
+		return true;
+	};
+	for (const auto& Pair : Pending)
+	{
+		uint64 PackageNameHash;
+		if (GetPackageNameHash(Pair.Key.Value, Pair.Value.Version, Pair.Value.Data.GetData(), Pair.Value.Data.Num(), PackageNameHash))
+			LatestPackageGuids.Add(PackageNameHash, Pair.Key.Key);
+	}
+
+	TArray<FMergedEntry> Merged;
+	Merged.Reserve(NumEntries + Pending.Num());
+	int32 NumDropped = 0;
+	for (int32 Index = 0; Index < NumEntries; ++Index)
+	{
+		const FFileEntry& Entry = Entries[Index];
+		if (Pending.Contains(TPair<FGuid, uint32>(Entry.Key, Entry.Kind)))
+			continue;
+		uint64 PackageNameHash;
+		const FGuid* LatestPackageGuid = GetPackageNameHash(Entry.Kind, Entry.Version, Blob + Entry.Offset, Entry.Size, PackageNameHash) ? LatestPackageGuids.Find(PackageNameHash) : nullptr;
+		if (!IsLatestVersion(Entry.Kind, Entry.Version) || (LatestPackageGuid && *LatestPackageGuid != Entry.Key))
+		{
+			++NumDropped;
+			continue;
+		}
+		Merged.Add({ Entry.Key, Entry.Kind, Entry.Version, Blob + Entry.Offset, Entry.Size });
+	}
+	for (const auto& Pair : Pending)
+	{
+		if (IsLatestVersion(Pair.Key.Value, Pair.Value.Version))
+			Merged.Add({ Pair.Key.Key, Pair.Key.Value, Pair.Value.Version, Pair.Value.Data.GetData(), (uint32)Pair.Value.Data.Num() });
+	}
+	Merged.Sort([](const FMergedEntry& A, const FMergedEntry& B) { return EntryLess(A.Key, A.Kind, B.Key, B.Kind); });
+
+	TArray<FFileEntry> Table;
+	Table.SetNumUninitialized(Merged.Num());
+	uint32 BlobSize = 0;
+	for (int32 Index = 0; Index < Merged.Num(); ++Index)
+	{
+		Table[Index] = { Merged[Index].Key, Merged[Index].Kind, Merged[Index].Version, BlobSize, Merged[Index].Size };
+		BlobSize += Merged[Index].Size;
+	}
+	FFileHeader Header = { AnalysisCacheMagic, AnalysisCacheFileVersion, (uint32)Table.Num(), BlobSize };
+
+	// Written next to the mapped file, which can only be replaced once unmapped
+	const FString TempFilename = Filename + TEXT(".tmp");
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempFilename));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Fail to write texture analysis cache %s"), *TempFilename);
+		return;
+	}
+	Writer->Serialize(&Header, sizeof(Header));
+	Writer->Serialize(Table.GetData(), Table.Num() * sizeof(FFileEntry));
+	for (const FMergedEntry& Entry : Merged)
+		Writer->Serialize(const_cast<uint8*>(Entry.Data), Entry.Size);
+	const bool bWritten = Writer->Close();
+	Writer.Reset();
+
+	Close();
+	if (bWritten && IFileManager::Get().Move(*Filename, *TempFilename, true, true))
+	{
+		Pending.Reset();
+		UE_LOG(LogTemp, Log, TEXT("Texture analysis cache saved, %d results, %d outdated ones dropped"), Header.NumEntries, NumDropped);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Fail to replace texture analysis cache %s, new results are kept in memory"), *Filename);
+	}
+	Open();
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Misc/Guid.h"
+#include "Templates/IsTriviallyCopyConstructible.h"
+
+struct FAssetData;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+enum class ETextureAnalysis : uint32
+{
+	/** Source GUID by package GUID, so results of unchanged packages are found without loading them */
+	PackageSource,
+	DuplicateHash,
+	Channels,
+	Content,
+};
+
+/**
+ * Analysis results by source GUID, persisted in Saved/TextureTool/AnalysisCache.bin.
+ * The file is a sorted table of fixed size entries followed by their payloads, it is memory mapped
+ * and searched in place so opening it costs nothing whatever its size. New results stay in memory
+ * until Flush rewrites the file. Each analysis has its own version and only results of that version
+ * are found. Versions only go up, so Flush drops results older than the newest version of their
+ * analysis, and keeps only the source GUID of the latest package GUID seen for each package.
+ * Game thread only.
+ */
+class FTextureAnalysisCache
+{
+public:
+	static FTextureAnalysisCache& Get();
+	~FTextureAnalysisCache();
+
+	template<typename T>
+	bool Find(const FGuid& Key, ETextureAnalysis Kind, uint32 Version, T& OutResult) const
+	{
+		static_assert(TIsTriviallyCopyConstructible<T>::Value, "Cached results are stored as raw bytes");
+		return FindRaw(Key, Kind, Version, &OutResult, sizeof(T));
+	}
+	template<typename T>
+	void Add(const FGuid& Key, ETextureAnalysis Kind, uint32 Version, const T& Result)
+	{
+		static_assert(TIsTriviallyCopyConstructible<T>::Value, "Cached results are stored as raw bytes");
+		AddRaw(Key, Kind, Version, &Result, sizeof(T));
+	}
+
+	/** Source GUID of a loaded texture, or of an unloaded one whose package did not change since it was last seen */
+	bool FindSourceId(const FAssetData& Asset, FGuid& OutSourceId) const;
+	void AddSourceId(const FAssetData& Asset, const FGuid& SourceId);
+	/** Result of an asset, without loading it when its package is known */
+	template<typename T>
+	bool FindForAsset(const FAssetData& Asset, ETextureAnalysis Kind, uint32 Version, T& OutResult) const
+	{
+		FGuid SourceId;
+		return FindSourceId(Asset, SourceId) && Find(SourceId, Kind, Version, OutResult);
+	}
+
+	/** Write new results to disk, called after scans and on shutdown */
+	void Flush();
+
+private:
+	FTextureAnalysisCache();
+	void Open();
+	void Close();
+	bool FindRaw(const FGuid& Key, ETextureAnalysis Kind, uint32 Version, void* OutResult, int32 Size) const;
+	void AddRaw(const FGuid& Key, ETextureAnalysis Kind, uint32 Version, const void* Result, int32 Size);
+
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint32 FileVersion;
+		uint32 NumEntries;
+		uint32 BlobSize;
+	};
+	struct FFileEntry
+	{
+		FGuid Key;
+		uint32 Kind;
+		uint32 Version;
+		uint32 Offset;
+		uint32 Size;
+	};
+	struct FPendingResult
+	{
+		uint32 Version;
+		TArray<uint8> Data;
+	};
+	/** Result of PackageSource, the package name tells which entries an edited package replaces */
+	struct FPackageSource
+	{
+		FGuid SourceId;
+		uint64 PackageNameHash;
+	};
+	const FFileEntry* FindEntry(const FGuid& Key, ETextureAnalysis Kind) const;
+	void NoteVersion(uint32 Kind, uint32 Version) const;
+
+	FString Filename;
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	/** File content when the platform can not map files */
+	TArray<uint8> LoadedData;
+	const FFileEntry* Entries = nullptr;
+	int32 NumEntries = 0;
+	const uint8* Blob = nullptr;
+	TMap<TPair<FGuid, uint32>, FPendingResult> Pending;
+	/** Newest version of each analysis seen in the file or asked for */
+	mutable TMap<uint32, uint32> LatestVersions;
+};
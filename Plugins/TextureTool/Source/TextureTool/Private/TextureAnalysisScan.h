@@ -0,0 +1,90 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "AssetData.h"
+#include "Engine/Texture2D.h"
+#include "Misc/ScopedSlowTask.h"
+#include "UObject/UObjectGlobals.h"
+#include "TextureAnalysisCache.h"
+#include "TextureToolStats.h"
+
+/** Batch loop of the directory scans whose results are kept in the texture analysis cache */
+struct FTextureAnalysisScan
+{
+	/**
+	 * Results of unchanged packages come from the cache without loading them, the other textures are loaded
+	 * BatchSize at a time and given to AnalyzeBatch(Textures, OutResults, OutValid), which adds new results to the cache.
+	 * OnResult(Asset, Result) is called for every valid result. Garbage is collected after batches that loaded.
+	 * Returns false if cancelled.
+	 */
+	template<typename ResultType, typename AnalyzeFuncType, typename ResultFuncType>
+	static bool Run(const TArray<FAssetData>& Assets, ETextureAnalysis Kind, uint32 Version, int32 BatchSize, const FText& Title, const TCHAR* Name,
+		AnalyzeFuncType AnalyzeBatch, ResultFuncType OnResult)
+	{
+		FTextureAnalysisCache& Cache = FTextureAnalysisCache::Get();
+		FScopedSlowTask SlowTask(Assets.Num(), Title);
+		SlowTask.MakeDialog(true);
+
+		TArray<UTexture2D*> ToAnalyze;
+		TArray<int32> AssetIndices;
+		TArray<ResultType> Results;
+		TArray<bool> Valid;
+		FTextureToolMemoryTracker Memory;
+		for (int32 Start = 0; Start < Assets.Num(); Start += BatchSize)
+		{
+			if (SlowTask.ShouldCancel())
+				return false;
+
+			const int32 End = FMath::Min(Start + BatchSize, Assets.Num());
+			bool bLoadedAny = false;
+			for (int32 i = Start; i < End; ++i)
+			{
+				const FAssetData& Asset = Assets[i];
+				SlowTask.EnterProgressFrame(1.f, FText::FromName(Asset.AssetName));
+
+				ResultType Result = ResultType();
+				if (!Asset.IsAssetLoaded() && Cache.FindForAsset(Asset, Kind, Version, Result))
+				{
+					OnResult(Asset, Result);
+					continue;
+				}
+
+				bLoadedAny |= !Asset.IsAssetLoaded();
+				UTexture2D* Texture;
+				{
+					LLM_SCOPE(ELLMTag::Textures);
+					Texture = Cast<UTexture2D>(Asset.GetAsset());
+				}
+				if (!Texture)
+					continue;
+				Memory.Track(ETextureToolMemory::Sources, Texture);
+				Cache.AddSourceId(Asset, Texture->Source.GetId());
+				if (Cache.Find(Texture->Source.GetId(), Kind, Version, Result))
+				{
+					OnResult(Asset, Result);
+					continue;
+				}
+				ToAnalyze.Add(Texture);
+				AssetIndices.Add(i);
+			}
+
+			Results.Reset();
+			Results.SetNum(ToAnalyze.Num());
+			Valid.Init(false, ToAnalyze.Num());
+			AnalyzeBatch(ToAnalyze, Results, Valid);
+			for (int32 i = 0; i < ToAnalyze.Num(); ++i)
+			{
+				if (Valid[i])
+					OnResult(Assets[AssetIndices[i]], Results[i]);
+			}
+			ToAnalyze.Reset();
+			AssetIndices.Reset();
+
+			Memory.Sample();
+			if (bLoadedAny)
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+		Memory.Finish(Name);
+		Cache.Flush();
+		return true;
+	}
+};
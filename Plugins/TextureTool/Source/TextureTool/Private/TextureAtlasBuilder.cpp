@@ -0,0 +1,257 @@
+#include "TextureAtlasBuilder.h"
+#include "TextureAtlas.h"
+#include "TextureSourceAccess.h"
+#include "TextureToolStats.h"
+#include "Engine/Texture2D.h"
+#include "Engine/DataTable.h"
+#include "Materials/MaterialInterface.h"
+#include "AssetRegistryModule.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Async/ParallelFor.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+DECLARE_CYCLE_STAT(TEXT("Atlas Pack"), STAT_TextureTool_AtlasPack, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Atlas Copy"), STAT_TextureTool_AtlasCopy, STATGROUP_TextureTool);
+
+FTextureSkylinePacker::FTextureSkylinePacker(int32 InWidth, int32 InHeight)
+	: Width(InWidth), Height(InHeight)
+{
+	Skyline.Add({ 0, 0, Width });
+}
+
+int32 FTextureSkylinePacker::Fit(int32 Index, FIntPoint Size) const
+{
+	if (Skyline[Index].X + Size.X > Width)
+		return INDEX_NONE;
+	// Skyline covers the whole width, the nodes under the rect are all there
+	int32 Y = 0;
+	for (int32 i = Index, Remaining = Size.X; Remaining > 0; ++i)
+	{
+		Y = FMath::Max(Y, Skyline[i].Y);
+		if (Y + Size.Y > Height)
+			return INDEX_NONE;
+		Remaining -= Skyline[i].Width;
+	}
+	return Y;
+}
+
+bool FTextureSkylinePacker::Insert(FIntPoint Size, FIntPoint& OutPosition)
+{
+	int32 BestIndex = INDEX_NONE;
+	int32 BestTop = MAX_int32;
+	int32 BestWidth = MAX_int32;
+	int32 BestY = 0;
+	for (int32 i = 0; i < Skyline.Num(); ++i)
+	{
+		const int32 Y = Fit(i, Size);
+		if (Y == INDEX_NONE)
+			continue;
+		if (Y + Size.Y < BestTop || (Y + Size.Y == BestTop && Skyline[i].Width < BestWidth))
+		{
+			BestIndex = i;
+			BestTop = Y + Size.Y;
+			BestWidth = Skyline[i].Width;
+			BestY = Y;
+		}
+	}
+	if (BestIndex == INDEX_NONE)
+		return false;
+
+	OutPosition = FIntPoint(Skyline[BestIndex].X, BestY);
+	Skyline.Insert({ OutPosition.X, BestTop, Size.X }, BestIndex);
+
+	// Nodes now under the rect are cut or removed
+	for (int32 i = BestIndex + 1; i < Skyline.Num();)
+	{
+		const int32 Cut = Skyline[i - 1].X + Skyline[i - 1].Width - Skyline[i].X;
+		if (Cut <= 0)
+			break;
+		Skyline[i].X += Cut;
+		Skyline[i].Width -= Cut;
+		if (Skyline[i].Width > 0)
+			break;
+		Skyline.RemoveAt(i);
+	}
+	for (int32 i = 0; i + 1 < Skyline.Num();)
+	{
+		if (Skyline[i].Y == Skyline[i + 1].Y)
+		{
+			Skyline[i].Width += Skyline[i + 1].Width;
+			Skyline.RemoveAt(i + 1);
+		}
+		else
+			++i;
+	}
+	return true;
+}
+
+bool FTextureSkylinePacker::Pack(const TArray<FIntPoint>& Sizes, int32 MaxSize, TArray<FIntPoint>& OutPositions, FIntPoint& OutAtlasSize)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_AtlasPack);
+	TArray<int32> Order;
+	int64 Area = 0;
+	FIntPoint Largest = FIntPoint::ZeroValue;
+	for (int32 i = 0; i < Sizes.Num(); ++i)
+	{
+		Order.Add(i);
+		Area += (int64)Sizes[i].X * Sizes[i].Y;
+		Largest = Largest.ComponentMax(Sizes[i]);
+	}
+	Order.Sort([&](int32 A, int32 B) { return Sizes[A].Y != Sizes[B].Y ? Sizes[A].Y > Sizes[B].Y : Sizes[A].X > Sizes[B].X; });
+
+	const int32 Start = FMath::RoundUpToPowerOfTwo(FMath::Max(Largest.X, FMath::CeilToInt(FMath::Sqrt((double)Area))));
+	for (int32 Side = Start; Side <= MaxSize; Side *= 2)
+	{
+		for (const FIntPoint Candidate : { FIntPoint(Side, Side / 2), FIntPoint(Side, Side) })
+		{
+			if (Candidate.Y < Largest.Y || (int64)Candidate.X * Candidate.Y < Area)
+				continue;
+			FTextureSkylinePacker Packer(Candidate.X, Candidate.Y);
+			OutPositions.SetNum(Sizes.Num());
+			bool bFits = true;
+			for (int32 i = 0; i < Order.Num() && bFits; ++i)
+				bFits = Packer.Insert(Sizes[Order[i]], OutPositions[Order[i]]);
+			if (bFits)
+			{
+				OutAtlasSize = Candidate;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool FTextureAtlasBuilder::CanAtlas(UTexture2D* Texture)
+{
+	if (!Texture)
+		return false;
+	const FTextureSource& Source = Texture->Source;
+	const ETextureSourceFormat Format = Source.GetFormat();
+	// Color textures only, the atlas is BGRA8 with the usual color compression
+	return FTextureSourceAccess::IsSupportedFormat(Format) && Format != TSF_RGBA16F && Format != TSF_BGRE8 && Format != TSF_RGBE8
+		&& Texture->CompressionSettings == TC_Default && Source.GetSizeX() > 0 && FMath::Max(Source.GetSizeX(), Source.GetSizeY()) <= MaxInputSize;
+}
+
+UTexture2D* FTextureAtlasBuilder::Build(const TArray<UTexture2D*>& Textures, const TArray<UMaterialInterface*>& Materials, const FString& PackagePath, const FString& AssetName,
+	UDataTable*& OutTable, FTextureAtlasReport& OutReport, FText& FailReason)
+{
+	// Rects start on a compression block and on a texel of the last padded mip, the gutter is one texel of that mip
+	const int32 Gutter = 1 << PaddedMips;
+	const int32 Alignment = FMath::Max(Gutter, 4);
+	TArray<FIntPoint> Cells;
+	int64 UsedTexels = 0;
+	bool bSRGB = false;
+	for (UTexture2D* Texture : Textures)
+	{
+		const FIntPoint Size(Texture->Source.GetSizeX(), Texture->Source.GetSizeY());
+		Cells.Add(FIntPoint(Align(Size.X + 2 * Gutter, Alignment), Align(Size.Y + 2 * Gutter, Alignment)));
+		UsedTexels += (int64)Size.X * Size.Y;
+		bSRGB |= Texture->SRGB;
+		OutReport.BytesBefore += Texture->CalcTextureMemorySizeEnum(TMC_AllMips);
+	}
+
+	TArray<FIntPoint> Positions;
+	FIntPoint AtlasSize;
+	const double PackStartTime = FPlatformTime::Seconds();
+	if (!FTextureSkylinePacker::Pack(Cells, MaxAtlasSize, Positions, AtlasSize))
+	{
+		FailReason = FText::Format(LOCTEXT("AtlasTooLarge", "Textures do not fit in a {0} atlas!"), (int32)MaxAtlasSize);
+		return nullptr;
+	}
+	OutReport.PackSeconds = FPlatformTime::Seconds() - PackStartTime;
+	OutReport.NumTextures = Textures.Num();
+	OutReport.AtlasSize = AtlasSize;
+	OutReport.Efficiency = (float)((double)UsedTexels / ((double)AtlasSize.X * AtlasSize.Y));
+
+	UTexture2D* Atlas = NewObject<UTexture2D>(CreatePackage(nullptr, *(PackagePath / AssetName)), *AssetName, RF_Public | RF_Standalone);
+	Atlas->SRGB = bSRGB;
+	Atlas->Source.Init(AtlasSize.X, AtlasSize.Y, 1, 1, TSF_BGRA8);
+	FColor* Texels = (FColor*)Atlas->Source.LockMip(0);
+	FMemory::Memzero(Texels, (int64)AtlasSize.X * AtlasSize.Y * sizeof(FColor));
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_AtlasCopy);
+		IImageWrapperModule* ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+		ParallelFor(Textures.Num(), [&](int32 Index)
+		{
+			FTextureSource& Source = Textures[Index]->Source;
+			const ETextureSourceFormat Format = Source.GetFormat();
+			const int32 SizeX = Source.GetSizeX();
+			const int32 SizeY = Source.GetSizeY();
+			const int32 BytesPerPixel = Source.GetBytesPerPixel();
+			TArray<uint8> MipData;
+			Source.GetMipData(MipData, 0, ImageWrapperModule);
+			if (MipData.Num() < SizeX * SizeY * BytesPerPixel)
+				return;
+
+			// Linear textures are encoded to sRGB when they share an atlas with sRGB ones
+			const bool bEncode = bSRGB && !Textures[Index]->SRGB;
+			const FIntPoint Origin = Positions[Index];
+			for (int32 y = 0; y < Cells[Index].Y; ++y)
+			{
+				// Gutter and alignment padding repeat the edge texels
+				const int32 SourceY = FMath::Clamp(y - Gutter, 0, SizeY - 1);
+				FColor* Row = Texels + (int64)(Origin.Y + y) * AtlasSize.X + Origin.X;
+				for (int32 x = 0; x < Cells[Index].X; ++x)
+				{
+					const int32 SourceX = FMath::Clamp(x - Gutter, 0, SizeX - 1);
+					const FLinearColor Color = FTextureSourceAccess::DecodePixel(&MipData[(SourceY * SizeX + SourceX) * BytesPerPixel], Format);
+					Row[x] = bEncode ? Color.ToFColor(true) : Color.QuantizeRound();
+				}
+			}
+		});
+	}
+	Atlas->Source.UnlockMip(0);
+	Atlas->PostEditChange();
+	Atlas->MarkPackageDirty();
+	FAssetRegistryModule::AssetCreated(Atlas);
+	OutReport.BytesAfter = Atlas->CalcTextureMemorySizeEnum(TMC_AllMips);
+
+	const FString TableName = AssetName + TEXT("_UVs");
+	UDataTable* Table = NewObject<UDataTable>(CreatePackage(nullptr, *(PackagePath / TableName)), *TableName, RF_Public | RF_Standalone);
+	Table->RowStruct = FTextureAtlasRect::StaticStruct();
+	const FVector2D AtlasExtent(AtlasSize);
+	for (int32 i = 0; i < Textures.Num(); ++i)
+	{
+		FTextureAtlasRect Rect;
+		Rect.Texture = Textures[i];
+		Rect.Position = Positions[i] + FIntPoint(Gutter, Gutter);
+		Rect.Size = FIntPoint(Textures[i]->Source.GetSizeX(), Textures[i]->Source.GetSizeY());
+		Rect.UVOffset = FVector2D(Rect.Position) / AtlasExtent;
+		Rect.UVScale = FVector2D(Rect.Size) / AtlasExtent;
+		// Textures of different folders may share a name
+		FName RowName = Textures[i]->GetFName();
+		for (int32 Suffix = 1; Table->GetRowMap().Contains(RowName); ++Suffix)
+			RowName = FName(*FString::Printf(TEXT("%s_%d"), *Textures[i]->GetName(), Suffix));
+		Table->AddRow(RowName, Rect);
+	}
+	Table->MarkPackageDirty();
+	FAssetRegistryModule::AssetCreated(Table);
+	OutTable = Table;
+
+	TSet<UTexture*> Atlased;
+	for (UTexture2D* Texture : Textures)
+		Atlased.Add(Texture);
+	for (UMaterialInterface* Material : Materials)
+	{
+		TArray<UTexture*> Used;
+		Material->GetUsedTextures(Used, EMaterialQualityLevel::Num, true, ERHIFeatureLevel::Num, true);
+		int32 NumAtlased = 0;
+		for (UTexture* Texture : Used)
+			NumAtlased += Atlased.Contains(Texture) ? 1 : 0;
+		if (NumAtlased == 0)
+			continue;
+		++OutReport.NumMaterials;
+		OutReport.SamplersSaved += NumAtlased - 1;
+		if (NumAtlased == Used.Num())
+			++OutReport.NumAtlasOnlyMaterials;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Atlas %s: %d textures packed in %.2f ms into %dx%d, %.0f%% used, %.1f MB -> %.1f MB"), *AssetName, OutReport.NumTextures, OutReport.PackSeconds * 1000.0,
+		AtlasSize.X, AtlasSize.Y, OutReport.Efficiency * 100.f, OutReport.BytesBefore / (1024.0 * 1024.0), OutReport.BytesAfter / (1024.0 * 1024.0));
+	UE_LOG(LogTemp, Log, TEXT("Atlas %s: %d materials sample it, %d samplers fewer, %d use only atlas textures and can share one draw call"), *AssetName,
+		OutReport.NumMaterials, OutReport.SamplersSaved, OutReport.NumAtlasOnlyMaterials);
+	return Atlas;
+}
+
+#undef LOCTEXT_NAMESPACE
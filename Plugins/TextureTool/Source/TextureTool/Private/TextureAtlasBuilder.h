@@ -0,0 +1,68 @@
+#pragma once
+#include "CoreMinimal.h"
+
+class UTexture2D;
+class UDataTable;
+class UMaterialInterface;
+
+/** Skyline bottom left packer, rects sorted by height are placed where they end up lowest */
+class FTextureSkylinePacker
+{
+public:
+	FTextureSkylinePacker(int32 InWidth, int32 InHeight);
+	/** Returns false when the rect does not fit anymore */
+	bool Insert(FIntPoint Size, FIntPoint& OutPosition);
+
+	/** Pack every size in the smallest power of two atlas up to MaxSize, positions are in the order of Sizes */
+	static bool Pack(const TArray<FIntPoint>& Sizes, int32 MaxSize, TArray<FIntPoint>& OutPositions, FIntPoint& OutAtlasSize);
+
+private:
+	struct FNode
+	{
+		int32 X;
+		int32 Y;
+		int32 Width;
+	};
+	/** Lowest Y at which a rect of Size can sit starting at node Index, INDEX_NONE if it does not fit */
+	int32 Fit(int32 Index, FIntPoint Size) const;
+
+	int32 Width;
+	int32 Height;
+	TArray<FNode> Skyline;
+};
+
+struct FTextureAtlasReport
+{
+	int32 NumTextures = 0;
+	FIntPoint AtlasSize = FIntPoint::ZeroValue;
+	/** Texels of the packed textures over texels of the atlas */
+	float Efficiency = 0.f;
+	double PackSeconds = 0.0;
+	int64 BytesBefore = 0;
+	int64 BytesAfter = 0;
+	/** Materials sampling only atlas textures, they can share one material and one draw call once remapped */
+	int32 NumMaterials = 0;
+	int32 NumAtlasOnlyMaterials = 0;
+	int32 SamplersSaved = 0;
+};
+
+/**
+ * Packs small textures used together into one atlas and a UV rect table to remap them.
+ * Rects are aligned and padded with dilated edges so the first PaddedMips mips do not bleed into neighbours.
+ */
+struct FTextureAtlasBuilder
+{
+	/** Largest side of a texture worth moving into an atlas */
+	static const int32 MaxInputSize = 256;
+	static const int32 MaxAtlasSize = 8192;
+	/** Mips below mip 0 which stay free of bleeding, sets both alignment and gutter */
+	static const int32 PaddedMips = 2;
+
+	static bool CanAtlas(UTexture2D* Texture);
+	/**
+	 * Create the atlas AssetName and its table AssetName_UVs under PackagePath.
+	 * Materials are only used to report draw call and sampler savings.
+	 */
+	static UTexture2D* Build(const TArray<UTexture2D*>& Textures, const TArray<UMaterialInterface*>& Materials, const FString& PackagePath, const FString& AssetName,
+		UDataTable*& OutTable, FTextureAtlasReport& OutReport, FText& FailReason);
+};
@@ -0,0 +1,190 @@
+#include "TextureBatchEstimator.h"
+#include "SettingObjects.h"
+#include "TextureUtils.h"
+#include "TextureMipChain.h"
+#include "TextureToolStats.h"
+#include "AssetRegistryModule.h"
+#include "RHI.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Timespan.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+DECLARE_CYCLE_STAT(TEXT("Batch Estimate"), STAT_TextureTool_BatchEstimate, STATGROUP_TextureTool);
+
+/** Reports averaged for the throughput, older runs may have been on other settings or another machine */
+static const int32 NumThroughputReports = 5;
+
+static bool IsHDRFormat(EPixelFormat Format)
+{
+	return Format == PF_FloatRGBA || Format == PF_FloatRGB || Format == PF_A32B32G32R32F || Format == PF_BC6H || Format == PF_R16F || Format == PF_R32_FLOAT;
+}
+
+static bool Is16BitFormat(EPixelFormat Format)
+{
+	return Format == PF_G16 || Format == PF_A16B16G16R16;
+}
+
+EPixelFormat FTextureBatchEstimator::GetOutputPixelFormat(TextureCompressionSettings Compression, bool bHDR, bool b16Bit, bool bAlpha)
+{
+	if (bHDR)
+		return PF_FloatRGBA;
+	switch (Compression)
+	{
+	case TC_Normalmap:
+		return PF_BC5;
+	case TC_Grayscale:
+	case TC_Displacementmap:
+	case TC_DistanceFieldFont:
+		return b16Bit ? PF_G16 : PF_G8;
+	case TC_VectorDisplacementmap:
+	case TC_EditorIcon:
+		return PF_B8G8R8A8;
+	case TC_HDR:
+		return PF_FloatRGBA;
+	case TC_Alpha:
+		return PF_BC4;
+	case TC_HDR_Compressed:
+		return PF_BC6H;
+	case TC_BC7:
+		return PF_BC7;
+	default:
+		return bAlpha ? PF_DXT5 : PF_DXT1;
+	}
+}
+
+void FTextureBatchEstimator::Estimate(const UTextureMergeSettings* Settings, const TArray<FString>& MatchedNames, FTextureBatchEstimate& OutEstimate)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_BatchEstimate);
+	static const FName SRGBTag("SRGB");
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	OutEstimate.Groups.Reset();
+	OutEstimate.Groups.Reserve(MatchedNames.Num());
+	for (const FString& Name : MatchedNames)
+	{
+		FString GroupName;
+		const FTextureChannelSrc* Channels[5];
+		Settings->GetChannels(Settings->SplitMatchedName(Name, GroupName), Channels);
+
+		FTextureBatchGroupEstimate& Group = OutEstimate.Groups.Add(Name);
+		const EMipFilter MipFilters[4] = { Channels[0]->MipFilter, Channels[1]->MipFilter, Channels[2]->MipFilter, Channels[3]->MipFilter };
+		const bool bBuildMips = FTextureMipChain::NeedsMipChain(MipFilters);
+		// The GPU merge draws into an RGBA16F target, channels with their own mip filter are merged on the CPU
+		const bool bOnGPU = Settings->bMergeOnGPU && !bBuildMips;
+		bool bHDR = bOnGPU;
+		bool b16Bit = false;
+		for (int32 i = 0; i < 4 && Group.Problem.IsEmpty(); ++i)
+		{
+			if (!Channels[i]->Optional)
+				continue;
+			const FString ObjectPath = Settings->GetSourceObjectPath(GroupName, *Channels[i]);
+			const FAssetData Asset = AssetRegistry.GetAssetByObjectPath(*ObjectPath);
+			FIntPoint SourceSize = FIntPoint::ZeroValue;
+			if (!Asset.IsValid() || !FTextureToolUtils::GetSourceSize(Asset, SourceSize))
+				Group.Problem = FText::Format(LOCTEXT("EstimateNoSource", "{0} has no size in the asset registry!"), FText::FromString(ObjectPath));
+			else if (Group.Size != FIntPoint::ZeroValue && Group.Size != SourceSize)
+				Group.Problem = LOCTEXT("SizeNotMatch", "Source textures' size does not match!");
+			Group.Size = SourceSize;
+
+			const EPixelFormat Format = FTextureToolUtils::GetPixelFormat(Asset);
+			bHDR |= IsHDRFormat(Format);
+			b16Bit |= Is16BitFormat(Format);
+			// The CPU merge widens linearized sRGB color channels to 16 bit
+			FString SRGB;
+			b16Bit |= Asset.GetTagValue(SRGBTag, SRGB) && SRGB.ToBool() && Channels[i]->Channel != EChannel::A;
+		}
+		if (!Group.Problem.IsEmpty())
+			continue;
+		if (Group.Size == FIntPoint::ZeroValue || !FMath::IsPowerOfTwo(Group.Size.X) || !FMath::IsPowerOfTwo(Group.Size.Y))
+		{
+			Group.Problem = LOCTEXT("SizeNotValid", "Source textures' size is not valid, must be power of two!");
+			continue;
+		}
+
+		// Output source is BGRA8, RGBA16 or RGBA16F, with the whole chain when a channel filters its own mips
+		const EPixelFormat SourceFormat = bHDR ? PF_FloatRGBA : b16Bit ? PF_A16B16G16R16 : PF_B8G8R8A8;
+		const int64 Mip0Bytes = (int64)Group.Size.X * Group.Size.Y * GPixelFormats[SourceFormat].BlockBytes;
+		Group.SourceBytes = bBuildMips ? FTextureToolUtils::EstimateBytes(Group.Size, SourceFormat) : Mip0Bytes;
+		const TextureCompressionSettings Compression = bOnGPU ? TC_HDR : (TextureCompressionSettings)Settings->OutputCompression;
+		Group.CookedBytes = FTextureToolUtils::EstimateBytes(Group.Size, GetOutputPixelFormat(Compression, bHDR, b16Bit, Channels[3]->Optional));
+	}
+
+	OutEstimate.SecondsPerMegapixel = GetSecondsPerMegapixel();
+	OutEstimate.Sum(MatchedNames);
+}
+
+double FTextureBatchEstimator::GetSecondsPerMegapixel()
+{
+	const FString Directory = FPaths::ProjectSavedDir() / TEXT("TextureTool");
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Directory / TEXT("BatchMerge-*.json")), true, false);
+	// Named after the date, so the latest sort last
+	Files.Sort();
+
+	double Seconds = 0.0;
+	double Megapixels = 0.0;
+	for (int32 Index = Files.Num() - 1; Index >= FMath::Max(Files.Num() - NumThroughputReports, 0); --Index)
+	{
+		FString Text;
+		TSharedPtr<FJsonObject> Root;
+		if (!FFileHelper::LoadFileToString(Text, *(Directory / Files[Index])) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Root) || !Root.IsValid())
+			continue;
+		Seconds += Root->GetNumberField(TEXT("TotalSeconds"));
+		Megapixels += Root->GetNumberField(TEXT("Megapixels"));
+	}
+	return Megapixels > 0.0 ? Seconds / Megapixels : -1.0;
+}
+
+void FTextureBatchEstimate::Sum(const TArray<FString>& Names)
+{
+	NumGroups = Names.Num();
+	NumFailing = 0;
+	NumPixels = 0;
+	SourceBytes = 0;
+	CookedBytes = 0;
+	for (const FString& Name : Names)
+	{
+		const FTextureBatchGroupEstimate* Group = Groups.Find(Name);
+		if (!Group)
+			continue;
+		if (Group->WillFail())
+		{
+			++NumFailing;
+			continue;
+		}
+		NumPixels += (int64)Group->Size.X * Group->Size.Y;
+		SourceBytes += Group->SourceBytes;
+		CookedBytes += Group->CookedBytes;
+	}
+	Seconds = SecondsPerMegapixel >= 0.0 ? SecondsPerMegapixel * NumPixels / 1000000.0 : -1.0;
+}
+
+void FTextureBatchEstimate::Remove(const FString& Name)
+{
+	const FTextureBatchGroupEstimate* Group = Groups.Find(Name);
+	--NumGroups;
+	if (!Group)
+		return;
+	if (Group->WillFail())
+	{
+		--NumFailing;
+		return;
+	}
+	NumPixels -= (int64)Group->Size.X * Group->Size.Y;
+	SourceBytes -= Group->SourceBytes;
+	CookedBytes -= Group->CookedBytes;
+	Seconds = SecondsPerMegapixel >= 0.0 ? SecondsPerMegapixel * NumPixels / 1000000.0 : -1.0;
+}
+
+FText FTextureBatchEstimate::GetSummaryText() const
+{
+	const FText Time = Seconds >= 0.0 ? FText::AsTimespan(FTimespan::FromSeconds(FMath::CeilToDouble(Seconds))) : LOCTEXT("EstimateNoTime", "unknown time, no earlier batch report");
+	return FText::Format(LOCTEXT("EstimateSummary", "{0} groups, {1} will fail. Output {2} MP, source {3}, cooked {4}, about {5}"),
+		NumGroups, NumFailing, FText::AsNumber(NumPixels / 1000000), FText::AsMemory(SourceBytes), FText::AsMemory(CookedBytes), Time);
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,56 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "Engine/TextureDefines.h"
+
+class UTextureMergeSettings;
+
+/** What a matched group is expected to produce, from asset registry tags only */
+struct FTextureBatchGroupEstimate
+{
+	FIntPoint Size = FIntPoint::ZeroValue;
+	/** Uncompressed source data of the output package */
+	int64 SourceBytes = 0;
+	/** Full mip chain in the output compression */
+	int64 CookedBytes = 0;
+	/** Why the merge would reject the group, empty when it passes the size checks */
+	FText Problem;
+
+	bool WillFail() const { return !Problem.IsEmpty(); }
+};
+
+struct FTextureBatchEstimate
+{
+	TMap<FString, FTextureBatchGroupEstimate> Groups;
+	/** From earlier batch reports, negative when there is none */
+	double SecondsPerMegapixel = -1.0;
+
+	/** Totals of the groups in Names, set by Sum */
+	int32 NumGroups = 0;
+	int32 NumFailing = 0;
+	int64 NumPixels = 0;
+	int64 SourceBytes = 0;
+	int64 CookedBytes = 0;
+	/** Negative when no earlier run measured the throughput */
+	double Seconds = -1.0;
+
+	/** Totals over Names only, groups removed from the batch are left out without estimating again */
+	void Sum(const TArray<FString>& Names);
+	/** Take a group out of the totals */
+	void Remove(const FString& Name);
+	FText GetSummaryText() const;
+};
+
+/**
+ * Dry run of a batch merge. Sizes and formats are read from registry tags, no package is loaded,
+ * so 10k groups take a few seconds. Sources with 16 bit or HDR platform formats are taken for
+ * 16 bit or HDR sources, the registry does not tell the source format itself.
+ */
+struct FTextureBatchEstimator
+{
+	static void Estimate(const UTextureMergeSettings* Settings, const TArray<FString>& MatchedNames, FTextureBatchEstimate& OutEstimate);
+	/** Time over output megapixels of the latest BatchMerge reports in Saved/TextureTool */
+	static double GetSecondsPerMegapixel();
+	/** Format the texture build picks on desktop for a merged output, TC_Default and TC_Masks keep alpha only when a source fills it */
+	static EPixelFormat GetOutputPixelFormat(TextureCompressionSettings Compression, bool bHDR, bool b16Bit, bool bAlpha);
+};
@@ -0,0 +1,286 @@
+#include "TextureChannelAnalyzer.h"
+#include "TextureSourceAccess.h"
+#include "TextureUtils.h"
+#include "Engine/Texture2D.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "TextureAnalysisCache.h"
+#include "TextureAnalysisScan.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+/** Pixels per parallel task, and per float accumulation run before flushing into doubles */
+static const int64 ChannelScanTaskPixels = 256 * 1024;
+static const int64 ChannelScanRunPixels = 4096;
+/** Textures loaded per step when scanning a directory */
+static const int32 ChannelScanBatchSize = 16;
+/** Channel range, or standard deviation, below which a channel is reported as constant */
+static const float ConstantRangeThreshold = 2.f / 255.f;
+static const float ConstantDeviationThreshold = 0.5f / 255.f;
+
+/** Load one source pixel as RGBA floats, not normalized */
+template<ETextureSourceFormat Format>
+static FORCEINLINE VectorRegister LoadSourcePixel(const uint8* Pixel);
+
+template<> FORCEINLINE VectorRegister LoadSourcePixel<TSF_G8>(const uint8* Pixel)
+{
+	float V = Pixel[0];
+	return MakeVectorRegister(V, V, V, 255.f);
+}
+
+template<> FORCEINLINE VectorRegister LoadSourcePixel<TSF_BGRA8>(const uint8* Pixel)
+{
+	return VectorSwizzle(VectorLoadByte4(Pixel), 2, 1, 0, 3);
+}
+
+template<> FORCEINLINE VectorRegister LoadSourcePixel<TSF_RGBA8>(const uint8* Pixel)
+{
+	return VectorLoadByte4(Pixel);
+}
+
+template<> FORCEINLINE VectorRegister LoadSourcePixel<TSF_RGBA16>(const uint8* Pixel)
+{
+	const uint16* P = (const uint16*)Pixel;
+	return MakeVectorRegister((float)P[0], (float)P[1], (float)P[2], (float)P[3]);
+}
+
+template<> FORCEINLINE VectorRegister LoadSourcePixel<TSF_RGBA16F>(const uint8* Pixel)
+{
+	const FFloat16* P = (const FFloat16*)Pixel;
+	return MakeVectorRegister(P[0].GetFloat(), P[1].GetFloat(), P[2].GetFloat(), P[3].GetFloat());
+}
+
+template<> FORCEINLINE VectorRegister LoadSourcePixel<TSF_BGRE8>(const uint8* Pixel)
+{
+	FLinearColor Color = FTextureSourceAccess::DecodePixel(Pixel, TSF_BGRE8);
+	return VectorLoad(&Color.R);
+}
+
+template<> FORCEINLINE VectorRegister LoadSourcePixel<TSF_RGBE8>(const uint8* Pixel)
+{
+	FLinearColor Color = FTextureSourceAccess::DecodePixel(Pixel, TSF_RGBE8);
+	return VectorLoad(&Color.R);
+}
+
+struct FChannelAccumulator
+{
+	float Min[4] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+	float Max[4] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	double Sum[4] = { 0, 0, 0, 0 };
+	double SumSq[4] = { 0, 0, 0, 0 };
+	float Delta[4] = { 0.f, 0.f, 0.f, 0.f };
+
+	void Merge(const FChannelAccumulator& Other)
+	{
+		for (int32 i = 0; i < 4; ++i)
+		{
+			Min[i] = FMath::Min(Min[i], Other.Min[i]);
+			Max[i] = FMath::Max(Max[i], Other.Max[i]);
+			Sum[i] += Other.Sum[i];
+			SumSq[i] += Other.SumSq[i];
+			Delta[i] = FMath::Max(Delta[i], Other.Delta[i]);
+		}
+	}
+};
+
+template<ETextureSourceFormat Format>
+static void AccumulatePixels(const uint8* Data, int64 Begin, int64 End, int32 BytesPerPixel, FChannelAccumulator& Out)
+{
+	VectorRegister Min = VectorSetFloat1(FLT_MAX);
+	VectorRegister Max = VectorSetFloat1(-FLT_MAX);
+	VectorRegister Delta = VectorZero();
+	for (int64 RunBegin = Begin; RunBegin < End; RunBegin += ChannelScanRunPixels)
+	{
+		// Short float runs keep sums exact enough, they are flushed into doubles after each run
+		VectorRegister Sum = VectorZero();
+		VectorRegister SumSq = VectorZero();
+		const int64 RunEnd = FMath::Min(RunBegin + ChannelScanRunPixels, End);
+		const uint8* Pixel = Data + RunBegin * BytesPerPixel;
+		for (int64 i = RunBegin; i < RunEnd; ++i, Pixel += BytesPerPixel)
+		{
+			VectorRegister V = LoadSourcePixel<Format>(Pixel);
+			Min = VectorMin(Min, V);
+			Max = VectorMax(Max, V);
+			Sum = VectorAdd(Sum, V);
+			SumSq = VectorMultiplyAdd(V, V, SumSq);
+			// x = |R - G|, y = |G - B|
+			Delta = VectorMax(Delta, VectorAbs(VectorSubtract(V, VectorSwizzle(V, 1, 2, 0, 3))));
+		}
+		float RunSum[4], RunSumSq[4];
+		VectorStore(Sum, RunSum);
+		VectorStore(SumSq, RunSumSq);
+		for (int32 c = 0; c < 4; ++c)
+		{
+			Out.Sum[c] += RunSum[c];
+			Out.SumSq[c] += RunSumSq[c];
+		}
+	}
+	VectorStore(Min, Out.Min);
+	VectorStore(Max, Out.Max);
+	VectorStore(Delta, Out.Delta);
+}
+
+FTextureChannelStats FTextureChannelAnalyzer::ComputeStats(const uint8* Data, int64 NumPixels, ETextureSourceFormat Format)
+{
+	using FAccumulateFunc = void(*)(const uint8*, int64, int64, int32, FChannelAccumulator&);
+	FAccumulateFunc Accumulate = nullptr;
+	float Scale = 1.f;
+	int32 BytesPerPixel = 4;
+	switch (Format)
+	{
+	case TSF_G8: Accumulate = &AccumulatePixels<TSF_G8>; Scale = 1.f / 255.f; BytesPerPixel = 1; break;
+	case TSF_BGRA8: Accumulate = &AccumulatePixels<TSF_BGRA8>; Scale = 1.f / 255.f; break;
+	case TSF_RGBA8: Accumulate = &AccumulatePixels<TSF_RGBA8>; Scale = 1.f / 255.f; break;
+	case TSF_BGRE8: Accumulate = &AccumulatePixels<TSF_BGRE8>; break;
+	case TSF_RGBE8: Accumulate = &AccumulatePixels<TSF_RGBE8>; break;
+	case TSF_RGBA16: Accumulate = &AccumulatePixels<TSF_RGBA16>; Scale = 1.f / 65535.f; BytesPerPixel = 8; break;
+	case TSF_RGBA16F: Accumulate = &AccumulatePixels<TSF_RGBA16F>; BytesPerPixel = 8; break;
+	default: break;
+	}
+
+	FTextureChannelStats Stats;
+	if (!Accumulate || NumPixels <= 0)
+		return Stats;
+
+	const int32 NumTasks = (int32)((NumPixels + ChannelScanTaskPixels - 1) / ChannelScanTaskPixels);
+	TArray<FChannelAccumulator> Partials;
+	Partials.SetNum(NumTasks);
+	ParallelFor(NumTasks, [&](int32 Task)
+	{
+		const int64 Begin = Task * ChannelScanTaskPixels;
+		Accumulate(Data, Begin, FMath::Min(Begin + ChannelScanTaskPixels, NumPixels), BytesPerPixel, Partials[Task]);
+	});
+
+	FChannelAccumulator Total;
+	for (const FChannelAccumulator& Partial : Partials)
+		Total.Merge(Partial);
+
+	for (int32 c = 0; c < 4; ++c)
+	{
+		const double Mean = Total.Sum[c] / NumPixels;
+		Stats.Min[c] = Total.Min[c] * Scale;
+		Stats.Max[c] = Total.Max[c] * Scale;
+		Stats.Mean[c] = (float)(Mean * Scale);
+		Stats.Variance[c] = (float)(FMath::Max(Total.SumSq[c] / NumPixels - Mean * Mean, 0.0) * Scale * Scale);
+	}
+	Stats.MaxDeltaRG = Total.Delta[0] * Scale;
+	Stats.MaxDeltaGB = Total.Delta[1] * Scale;
+	return Stats;
+}
+
+FTextureChannelReport FTextureChannelAnalyzer::Classify(const FTextureChannelStats& Stats, ETextureSourceFormat Format)
+{
+	FTextureChannelReport Report;
+	Report.Stats = Stats;
+	const bool bHasColor = Format != TSF_G8;
+	const bool bHasAlpha = Format == TSF_BGRA8 || Format == TSF_RGBA8 || Format == TSF_RGBA16 || Format == TSF_RGBA16F;
+	Report.bHasColor = bHasColor;
+	Report.bHasAlpha = bHasAlpha;
+
+	for (int32 c = 0; c < 4; ++c)
+	{
+		if (c == 3 && !bHasAlpha)
+			continue;
+		if (Stats.Max[c] - Stats.Min[c] <= ConstantRangeThreshold || FMath::Sqrt(Stats.Variance[c]) <= ConstantDeviationThreshold)
+			Report.ConstantChannels |= 1 << c;
+	}
+	Report.bGrayscale = bHasColor && Stats.MaxDeltaRG <= ConstantRangeThreshold && Stats.MaxDeltaGB <= ConstantRangeThreshold;
+	// A constant alpha below 1 still fades or masks, only an opaque one can be dropped
+	Report.bUnusedAlpha = bHasAlpha && (Report.ConstantChannels & 8) != 0 && Stats.Min[3] >= 1.f - ConstantRangeThreshold;
+	return Report;
+}
+
+FText FTextureChannelReport::GetIssueText() const
+{
+	TArray<FString> Issues;
+	if (!bHasColor && (ConstantChannels & 7))
+	{
+		Issues.Add(TEXT("Constant"));
+	}
+	else if (ConstantChannels & 7)
+	{
+		FString Channels;
+		const TCHAR* Names[] = { TEXT("R"), TEXT("G"), TEXT("B") };
+		for (int32 c = 0; c < 3; ++c)
+		{
+			if (ConstantChannels & (1 << c))
+				Channels += Names[c];
+		}
+		Issues.Add(FString::Printf(TEXT("Constant %s"), *Channels));
+	}
+	if (bGrayscale)
+		Issues.Add(TEXT("Grayscale stored as RGB"));
+	if (bUnusedAlpha)
+		Issues.Add(TEXT("Unused alpha"));
+	return FText::FromString(FString::Join(Issues, TEXT(", ")));
+}
+
+FText FTextureChannelReport::GetSuggestionText() const
+{
+	// Without alpha, or with one that can be dropped, only the color is left to suggest for
+	const bool bNoAlpha = !bHasAlpha || bUnusedAlpha;
+	if ((ConstantChannels & 7) == 7 && (bNoAlpha || (ConstantChannels & 8)))
+		return LOCTEXT("ChannelSuggestScalar", "Replace with a scalar or vector parameter");
+	if (bGrayscale && bNoAlpha)
+		return LOCTEXT("ChannelSuggestG8", "Switch to Grayscale (G8) or Alpha (BC4) compression");
+	if (bGrayscale)
+		return LOCTEXT("ChannelSuggestGrayAlpha", "Pack luminance and alpha into two channels");
+	if (bUnusedAlpha)
+		return LOCTEXT("ChannelSuggestBC1", "Drop alpha (Compress Without Alpha) to get BC1");
+	if (ConstantChannels & 7)
+		return LOCTEXT("ChannelSuggestPack", "Replace constant channels with scalars and pack the rest");
+	return FText::GetEmpty();
+}
+
+bool FTextureChannelAnalyzer::Analyze(UTexture2D* Texture, FTextureChannelReport& OutReport, IImageWrapperModule* ImageWrapperModule)
+{
+	FTextureSource& Source = Texture->Source;
+	const ETextureSourceFormat Format = Source.GetFormat();
+	if (!FTextureSourceAccess::IsSupportedFormat(Format))
+		return false;
+
+	TArray<uint8> MipData;
+	Source.GetMipData(MipData, 0, ImageWrapperModule);
+	const int64 NumPixels = (int64)Source.GetSizeX() * Source.GetSizeY();
+	if (MipData.Num() < NumPixels * Source.GetBytesPerPixel())
+		return false;
+
+	OutReport = Classify(ComputeStats(MipData.GetData(), NumPixels, Format), Format);
+	return true;
+}
+
+void FTextureChannelAnalyzer::Analyze(const TArray<UTexture2D*>& Textures, TArray<FTextureChannelReport>& OutReports, TArray<bool>& OutValid)
+{
+	IImageWrapperModule* ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	OutReports.SetNum(Textures.Num());
+	OutValid.SetNum(Textures.Num());
+	ParallelFor(Textures.Num(), [&](int32 Index)
+	{
+		OutValid[Index] = Textures[Index] && Analyze(Textures[Index], OutReports[Index], ImageWrapperModule);
+	});
+
+	FTextureAnalysisCache& Cache = FTextureAnalysisCache::Get();
+	for (int32 Index = 0; Index < Textures.Num(); ++Index)
+	{
+		if (OutValid[Index])
+			Cache.Add(Textures[Index]->Source.GetId(), ETextureAnalysis::Channels, CacheVersion, OutReports[Index]);
+	}
+}
+
+bool FTextureChannelAnalyzer::Scan(const FString& Path, bool bRecursive, TArray<TPair<FAssetData, FTextureChannelReport>>& OutReports)
+{
+	TArray<FAssetData> Assets = FTextureToolUtils::GetTexturesInDirectory(Path, bRecursive);
+	return FTextureAnalysisScan::Run<FTextureChannelReport>(Assets, ETextureAnalysis::Channels, CacheVersion, ChannelScanBatchSize,
+		LOCTEXT("AnalyzeTextureChannels", "Analyzing texture channels..."), TEXT("ChannelScan"),
+		[](const TArray<UTexture2D*>& Textures, TArray<FTextureChannelReport>& OutBatchReports, TArray<bool>& OutValid)
+		{
+			Analyze(Textures, OutBatchReports, OutValid);
+		},
+		[&](const FAssetData& Asset, const FTextureChannelReport& Report)
+		{
+			OutReports.Emplace(Asset, Report);
+		});
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,54 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/Texture.h"
+
+class UTexture2D;
+class IImageWrapperModule;
+struct FAssetData;
+
+/** Per channel statistics of a texture source, RGBA order, integer formats normalized to [0, 1] */
+struct FTextureChannelStats
+{
+	float Min[4] = { 0.f, 0.f, 0.f, 0.f };
+	float Max[4] = { 0.f, 0.f, 0.f, 0.f };
+	float Mean[4] = { 0.f, 0.f, 0.f, 0.f };
+	float Variance[4] = { 0.f, 0.f, 0.f, 0.f };
+	/** Largest per pixel difference between R and G, and between G and B */
+	float MaxDeltaRG = 0.f;
+	float MaxDeltaGB = 0.f;
+};
+
+struct FTextureChannelReport
+{
+	FTextureChannelStats Stats;
+	/** Bit per RGBA channel which is constant or nearly constant */
+	uint8 ConstantChannels = 0;
+	/** RGB channels are identical */
+	bool bGrayscale = false;
+	/** Source has an alpha channel which is constant and fully opaque */
+	bool bUnusedAlpha = false;
+	/** Source format has RGB channels, G8 has a single one read as RGB, and an alpha channel */
+	bool bHasColor = true;
+	bool bHasAlpha = false;
+
+	bool HasIssue() const { return ConstantChannels != 0 || bGrayscale || bUnusedAlpha; }
+	FText GetIssueText() const;
+	FText GetSuggestionText() const;
+};
+
+/** Finds constant, duplicated and unused channels by scanning source mip 0 */
+struct FTextureChannelAnalyzer
+{
+	/** Version of cached reports, bump when ComputeStats or Classify change */
+	static const uint32 CacheVersion = 3;
+
+	/** Analyze one texture, ImageWrapperModule must be given when called from a worker thread */
+	static bool Analyze(UTexture2D* Texture, FTextureChannelReport& OutReport, IImageWrapperModule* ImageWrapperModule = nullptr);
+	/** Analyze several loaded textures in parallel, reports are added to the texture analysis cache */
+	static void Analyze(const TArray<UTexture2D*>& Textures, TArray<FTextureChannelReport>& OutReports, TArray<bool>& OutValid);
+	/** Scan every texture under Path, returns false if cancelled */
+	static bool Scan(const FString& Path, bool bRecursive, TArray<TPair<FAssetData, FTextureChannelReport>>& OutReports);
+
+	static FTextureChannelStats ComputeStats(const uint8* Data, int64 NumPixels, ETextureSourceFormat Format);
+	static FTextureChannelReport Classify(const FTextureChannelStats& Stats, ETextureSourceFormat Format);
+};
@@ -0,0 +1,451 @@
+#include "TextureCompressionOptimizer.h"
+#include "TextureSourceAccess.h"
+#include "TextureUtils.h"
+#include "TextureToolStats.h"
+#include "TextureAnalysisCache.h"
+#include "Engine/Texture2D.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceConstant.h"
+#include "Materials/MaterialFunction.h"
+#include "Materials/MaterialExpressionTextureSample.h"
+#include "Materials/MaterialExpressionTextureSampleParameter.h"
+#include "MaterialShared.h"
+#include "MaterialEditingLibrary.h"
+#include "Toolkits/AssetEditorManager.h"
+#include "AssetRegistryModule.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Async/ParallelFor.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+DECLARE_CYCLE_STAT(TEXT("Compression Classify"), STAT_TextureTool_CompressionClassify, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Compression Rebuild"), STAT_TextureTool_CompressionRebuild, STATGROUP_TextureTool);
+
+/** Classification reads the smallest source mip at least this large, on a grid of at most SampleGrid^2 pixels */
+static const int32 CompressionSampleMipSize = 256;
+static const int32 CompressionSampleGrid = 128;
+/** Textures loaded per step when scanning a directory */
+static const int32 CompressionScanBatchSize = 16;
+/** Share of samples which must be unit vectors facing +Z for a normal map */
+static const float NormalSampleRatio = 0.95f;
+static const float NormalLengthTolerance = 0.1f;
+/** Share of channel samples near 0 or 1 for a mask */
+static const float MaskExtremeRatio = 0.7f;
+static const float MaskExtremeMargin = 0.1f;
+/** Packed masks hold unrelated data per channel, saturated color art has channels which follow each other */
+static const float MaskMaxCorrelation = 0.5f;
+static const float GrayscaleTolerance = 2.f / 255.f;
+static const float OpaqueAlphaTolerance = 2.f / 255.f;
+/** Smaller textures may stay resident */
+static const int32 MinStreamingSize = 256;
+/** Bump when Classify changes */
+static const uint32 ContentCacheVersion = 2;
+
+struct FCachedContent
+{
+	ETextureContent Content;
+	bool bUnusedAlpha;
+};
+
+/** Pearson correlation of two channels from their sums, a constant channel is not correlated to anything */
+static double GetCorrelation(int32 N, double SumX, double SumY, double SumXX, double SumYY, double SumXY)
+{
+	const double Variance = (N * SumXX - SumX * SumX) * (N * SumYY - SumY * SumY);
+	return Variance > SMALL_NUMBER ? (N * SumXY - SumX * SumY) / FMath::Sqrt(Variance) : 0.0;
+}
+
+bool FTextureCompressionOptimizer::Classify(UTexture2D* Texture, ETextureContent& OutContent, bool& bOutUnusedAlpha, IImageWrapperModule* ImageWrapperModule)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_CompressionClassify);
+	FTextureSource& Source = Texture->Source;
+	const ETextureSourceFormat Format = Source.GetFormat();
+	if (!FTextureSourceAccess::IsSupportedFormat(Format))
+		return false;
+
+	const int32 MipIndex = FTextureSourceAccess::GetSmallestMipAtLeast(Source, CompressionSampleMipSize);
+	const FIntPoint MipSize = FTextureSourceAccess::GetMipSize(Source, MipIndex);
+	const int32 BytesPerPixel = Source.GetBytesPerPixel();
+	TArray<uint8> MipData;
+	Source.GetMipData(MipData, MipIndex, ImageWrapperModule);
+	if (MipData.Num() < (int64)MipSize.X * MipSize.Y * BytesPerPixel)
+		return false;
+
+	const int32 StepX = FMath::Max(MipSize.X / CompressionSampleGrid, 1);
+	const int32 StepY = FMath::Max(MipSize.Y / CompressionSampleGrid, 1);
+	int32 NumSamples = 0, NumNormals = 0, NumExtremes = 0;
+	float MaxDelta = 0.f, MaxValue = 0.f, MinAlpha = 1.f, MaxAlpha = 0.f;
+	double Sum[3] = {}, SumSq[3] = {}, SumRG = 0.0, SumGB = 0.0, SumRB = 0.0;
+	for (int32 Y = 0; Y < MipSize.Y; Y += StepY)
+	{
+		for (int32 X = 0; X < MipSize.X; X += StepX)
+		{
+			const FLinearColor Color = FTextureSourceAccess::DecodePixel(MipData.GetData() + ((int64)Y * MipSize.X + X) * BytesPerPixel, Format);
+			const FVector Normal(Color.R * 2.f - 1.f, Color.G * 2.f - 1.f, Color.B * 2.f - 1.f);
+			++NumSamples;
+			NumNormals += Normal.Z >= 0.f && FMath::Abs(Normal.Size() - 1.f) <= NormalLengthTolerance;
+			for (float Value : { Color.R, Color.G, Color.B })
+				NumExtremes += Value <= MaskExtremeMargin || Value >= 1.f - MaskExtremeMargin;
+			MaxDelta = FMath::Max3(MaxDelta, FMath::Abs(Color.R - Color.G), FMath::Abs(Color.G - Color.B));
+			MaxValue = FMath::Max3(MaxValue, Color.R, FMath::Max(Color.G, Color.B));
+			MinAlpha = FMath::Min(MinAlpha, Color.A);
+			MaxAlpha = FMath::Max(MaxAlpha, Color.A);
+			const float Channels[3] = { Color.R, Color.G, Color.B };
+			for (int32 Channel = 0; Channel < 3; ++Channel)
+			{
+				Sum[Channel] += Channels[Channel];
+				SumSq[Channel] += Channels[Channel] * Channels[Channel];
+			}
+			SumRG += Color.R * Color.G;
+			SumGB += Color.G * Color.B;
+			SumRB += Color.R * Color.B;
+		}
+	}
+	const double MaxCorrelation = FMath::Max3(
+		FMath::Abs(GetCorrelation(NumSamples, Sum[0], Sum[1], SumSq[0], SumSq[1], SumRG)),
+		FMath::Abs(GetCorrelation(NumSamples, Sum[1], Sum[2], SumSq[1], SumSq[2], SumGB)),
+		FMath::Abs(GetCorrelation(NumSamples, Sum[0], Sum[2], SumSq[0], SumSq[2], SumRB)));
+
+	const bool bHasAlpha = Format == TSF_BGRA8 || Format == TSF_RGBA8 || Format == TSF_RGBA16 || Format == TSF_RGBA16F;
+	const bool bFloat = Format == TSF_RGBA16F || Format == TSF_BGRE8 || Format == TSF_RGBE8;
+	// Compressing without alpha reads back 1, a constant alpha below that is still used
+	bOutUnusedAlpha = bHasAlpha && MinAlpha >= 1.f - OpaqueAlphaTolerance;
+	if (bFloat && MaxValue > 1.f)
+		OutContent = ETextureContent::HDR;
+	else if (MaxDelta <= GrayscaleTolerance)
+		OutContent = ETextureContent::Grayscale;
+	else if (NumNormals >= NumSamples * NormalSampleRatio)
+		OutContent = ETextureContent::Normal;
+	else if (NumExtremes >= NumSamples * 3 * MaskExtremeRatio && MaxCorrelation <= MaskMaxCorrelation)
+		OutContent = ETextureContent::Mask;
+	else if (bOutUnusedAlpha)
+		OutContent = ETextureContent::OpaqueAlpha;
+	else
+		OutContent = ETextureContent::Color;
+	return true;
+}
+
+void FTextureCompressionOptimizer::Propose(UTexture2D* Texture, ETextureContent Content, bool bUnusedAlpha, FTextureCompressionProposal& Out)
+{
+	Out.Asset = FAssetData(Texture);
+	Out.Content = Content;
+	Out.CompressionSettings = Out.OldCompressionSettings = Texture->CompressionSettings;
+	Out.bSRGB = Out.bOldSRGB = Texture->SRGB;
+	Out.bCompressionNoAlpha = Out.bOldCompressionNoAlpha = Texture->CompressionNoAlpha;
+	Out.LODGroup = Out.OldLODGroup = Texture->LODGroup;
+	Out.bNeverStream = Out.bOldNeverStream = Texture->NeverStream;
+
+	// Explicit compression settings were chosen by someone, only defaults are second guessed
+	if (Texture->CompressionSettings == TC_Default)
+	{
+		switch (Content)
+		{
+		case ETextureContent::Normal:
+			Out.CompressionSettings = TC_Normalmap;
+			Out.bSRGB = false;
+			break;
+		case ETextureContent::Mask:
+			Out.CompressionSettings = TC_Masks;
+			Out.bSRGB = false;
+			break;
+		case ETextureContent::HDR:
+			Out.CompressionSettings = TC_HDR_Compressed;
+			Out.bSRGB = false;
+			break;
+		default:
+			break;
+		}
+		// BC3 to BC1, grayscale stays in BC1 as G8 would double the size
+		Out.bCompressionNoAlpha |= bUnusedAlpha && Out.CompressionSettings == TC_Default;
+	}
+
+	// Only the world groups are moved between, other groups are a deliberate choice
+	const bool bWorldGroup = Texture->LODGroup == TEXTUREGROUP_World || Texture->LODGroup == TEXTUREGROUP_WorldNormalMap || Texture->LODGroup == TEXTUREGROUP_WorldSpecular;
+	if (bWorldGroup)
+	{
+		if (Out.CompressionSettings == TC_Normalmap)
+			Out.LODGroup = TEXTUREGROUP_WorldNormalMap;
+		else if (Out.CompressionSettings == TC_Masks)
+			Out.LODGroup = TEXTUREGROUP_WorldSpecular;
+		else if (Texture->LODGroup == TEXTUREGROUP_WorldNormalMap)
+			Out.LODGroup = TEXTUREGROUP_World;
+	}
+
+	const bool bCanStream = Texture->Source.IsPowerOfTwo() && Texture->MipGenSettings != TMGS_NoMipmaps
+		&& FMath::Max(Texture->Source.GetSizeX(), Texture->Source.GetSizeY()) > MinStreamingSize;
+	if (Texture->NeverStream && bWorldGroup && bCanStream)
+		Out.bNeverStream = false;
+}
+
+bool FTextureCompressionProposal::HasChange() const
+{
+	return CompressionSettings != OldCompressionSettings || bSRGB != bOldSRGB || bCompressionNoAlpha != bOldCompressionNoAlpha
+		|| LODGroup != OldLODGroup || bNeverStream != bOldNeverStream;
+}
+
+FText FTextureCompressionProposal::GetContentText() const
+{
+	switch (Content)
+	{
+	case ETextureContent::Normal: return LOCTEXT("ContentNormal", "Normal map");
+	case ETextureContent::Mask: return LOCTEXT("ContentMask", "Mask");
+	case ETextureContent::Grayscale: return LOCTEXT("ContentGrayscale", "Grayscale");
+	case ETextureContent::HDR: return LOCTEXT("ContentHDR", "HDR");
+	case ETextureContent::OpaqueAlpha: return LOCTEXT("ContentOpaqueAlpha", "Color with opaque alpha");
+	default: return LOCTEXT("ContentColor", "Color");
+	}
+}
+
+FText FTextureCompressionProposal::GetChangeText() const
+{
+	UEnum* CompressionEnum = StaticEnum<TextureCompressionSettings>();
+	UEnum* GroupEnum = StaticEnum<TextureGroup>();
+	TArray<FString> Changes;
+	if (CompressionSettings != OldCompressionSettings)
+		Changes.Add(CompressionEnum->GetDisplayNameTextByValue(CompressionSettings).ToString());
+	if (bSRGB != bOldSRGB)
+		Changes.Add(bSRGB ? TEXT("sRGB") : TEXT("Linear"));
+	if (bCompressionNoAlpha != bOldCompressionNoAlpha)
+		Changes.Add(TEXT("Compress Without Alpha"));
+	if (LODGroup != OldLODGroup)
+		Changes.Add(GroupEnum->GetDisplayNameTextByValue(LODGroup).ToString());
+	if (bNeverStream != bOldNeverStream)
+		Changes.Add(bNeverStream ? TEXT("Never Stream") : TEXT("Stream"));
+	return FText::FromString(FString::Join(Changes, TEXT(", ")));
+}
+
+void FTextureCompressionProposal::ApplyTo(UTexture2D* Texture) const
+{
+	Texture->CompressionSettings = CompressionSettings;
+	Texture->SRGB = bSRGB;
+	Texture->CompressionNoAlpha = bCompressionNoAlpha;
+	Texture->LODGroup = LODGroup;
+	Texture->NeverStream = bNeverStream;
+}
+
+bool FTextureCompressionOptimizer::Scan(const FString& Path, bool bRecursive, TArray<FTextureCompressionProposal>& OutProposals)
+{
+	FTextureAnalysisCache& Cache = FTextureAnalysisCache::Get();
+	TArray<FAssetData> Assets = FTextureToolUtils::GetTexturesInDirectory(Path, bRecursive);
+	IImageWrapperModule* ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	FScopedSlowTask SlowTask(Assets.Num(), LOCTEXT("ClassifyTextures", "Classifying textures..."));
+	SlowTask.MakeDialog(true);
+
+	FTextureToolMemoryTracker Memory;
+	TArray<UTexture2D*> Textures;
+	for (int32 Start = 0; Start < Assets.Num(); Start += CompressionScanBatchSize)
+	{
+		if (SlowTask.ShouldCancel())
+			return false;
+
+		const int32 End = FMath::Min(Start + CompressionScanBatchSize, Assets.Num());
+		bool bLoadedAny = false;
+		Textures.Reset();
+		for (int32 i = Start; i < End; ++i)
+		{
+			SlowTask.EnterProgressFrame(1.f, FText::FromName(Assets[i].AssetName));
+			bLoadedAny |= !Assets[i].IsAssetLoaded();
+			LLM_SCOPE(ELLMTag::Textures);
+			if (UTexture2D* Texture = Cast<UTexture2D>(Assets[i].GetAsset()))
+			{
+				Memory.Track(ETextureToolMemory::Sources, Texture);
+				Textures.Add(Texture);
+			}
+		}
+
+		// Proposals depend on current settings so textures are still loaded, only the source decode is saved
+		TArray<FCachedContent> Contents;
+		TArray<bool> Cached, Valid;
+		Contents.SetNum(Textures.Num());
+		Cached.SetNum(Textures.Num());
+		Valid.SetNum(Textures.Num());
+		for (int32 i = 0; i < Textures.Num(); ++i)
+			Cached[i] = Cache.Find(Textures[i]->Source.GetId(), ETextureAnalysis::Content, ContentCacheVersion, Contents[i]);
+		ParallelFor(Textures.Num(), [&](int32 Index)
+		{
+			Valid[Index] = Cached[Index] || Classify(Textures[Index], Contents[Index].Content, Contents[Index].bUnusedAlpha, ImageWrapperModule);
+		});
+		for (int32 i = 0; i < Textures.Num(); ++i)
+		{
+			if (!Valid[i])
+				continue;
+			if (!Cached[i])
+				Cache.Add(Textures[i]->Source.GetId(), ETextureAnalysis::Content, ContentCacheVersion, Contents[i]);
+			FTextureCompressionProposal Proposal;
+			Propose(Textures[i], Contents[i].Content, Contents[i].bUnusedAlpha, Proposal);
+			if (Proposal.HasChange())
+				OutProposals.Add(Proposal);
+		}
+
+		Memory.Sample();
+		if (bLoadedAny)
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+	Memory.Finish(TEXT("CompressionScan"));
+	Cache.Flush();
+	return true;
+}
+
+/** Start editing Owner, a material or a material function, the first time one of its expressions changes */
+static void BeginExpressionEdit(UObject* Owner, TSet<UObject*>& Edited)
+{
+	if (Edited.Contains(Owner))
+		return;
+	// Graph is edited directly, an open editor would write its own copy back
+	FAssetEditorManager::Get().CloseAllEditorsForAsset(Owner);
+	Owner->Modify();
+	Owner->PreEditChange(nullptr);
+	Edited.Add(Owner);
+}
+
+/** Samples of changed textures take the sampler type of their new settings */
+static void FixSamplerTypes(UObject* Owner, const TArray<UMaterialExpression*>& Expressions, const TSet<UTexture*>& Changed, TSet<UObject*>& Edited)
+{
+	for (UMaterialExpression* Expression : Expressions)
+	{
+		UMaterialExpressionTextureSample* Sample = Cast<UMaterialExpressionTextureSample>(Expression);
+		if (!Sample || !Changed.Contains(Sample->Texture))
+			continue;
+		const EMaterialSamplerType SamplerType = UMaterialExpressionTextureBase::GetSamplerTypeForTexture(Sample->Texture);
+		if (Sample->SamplerType != SamplerType)
+		{
+			BeginExpressionEdit(Owner, Edited);
+			Sample->SamplerType = SamplerType;
+		}
+	}
+}
+
+int32 FTextureCompressionOptimizer::Apply(const TArray<FTextureCompressionProposal>& Proposals, TArray<FText>& OutConflicts)
+{
+	FScopedSlowTask SlowTask(3.f, LOCTEXT("ApplyCompression", "Applying compression settings..."));
+	SlowTask.MakeDialog();
+
+	SlowTask.EnterProgressFrame(1.f);
+	TArray<UTexture2D*> Textures;
+	for (const FTextureCompressionProposal& Proposal : Proposals)
+	{
+		UTexture2D* Texture = Cast<UTexture2D>(Proposal.Asset.GetAsset());
+		if (!Texture)
+			continue;
+		Texture->Modify();
+		Texture->ReleaseResource();
+		Proposal.ApplyTo(Texture);
+		Textures.Add(Texture);
+	}
+
+	// Every build is started before the first is waited on, PostEditChange would build them one by one
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_CompressionRebuild);
+		for (UTexture2D* Texture : Textures)
+			Texture->BeginCachePlatformData();
+		SlowTask.EnterProgressFrame(1.f);
+		for (UTexture2D* Texture : Textures)
+		{
+			Texture->FinishCachePlatformData();
+			Texture->UpdateCachedLODBias();
+			Texture->UpdateResource();
+			Texture->MarkPackageDirty();
+		}
+	}
+
+	// Compression and sRGB decide the sampler type, samples of changed textures must follow or the material fails to compile.
+	// Samples sit in materials, in material functions, or are parameters which an instance overrides with a changed texture
+	SlowTask.EnterProgressFrame(1.f);
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	TSet<UTexture*> Changed;
+	TSet<UMaterial*> Materials;
+	TSet<UMaterialFunction*> Functions;
+	TSet<UMaterialInstanceConstant*> Instances;
+	for (UTexture2D* Texture : Textures)
+	{
+		Changed.Add(Texture);
+		TArray<FName> Referencers;
+		AssetRegistry.GetReferencers(Texture->GetOutermost()->GetFName(), Referencers);
+		for (FName PackageName : Referencers)
+		{
+			TArray<FAssetData> Assets;
+			AssetRegistry.GetAssetsByPackageName(PackageName, Assets);
+			for (const FAssetData& Asset : Assets)
+			{
+				if (Asset.AssetClass == UMaterial::StaticClass()->GetFName())
+					Materials.Add(Cast<UMaterial>(Asset.GetAsset()));
+				else if (Asset.AssetClass == UMaterialFunction::StaticClass()->GetFName())
+					Functions.Add(Cast<UMaterialFunction>(Asset.GetAsset()));
+				else if (Asset.AssetClass == UMaterialInstanceConstant::StaticClass()->GetFName())
+					Instances.Add(Cast<UMaterialInstanceConstant>(Asset.GetAsset()));
+			}
+		}
+	}
+	Materials.Remove(nullptr);
+	Functions.Remove(nullptr);
+	Instances.Remove(nullptr);
+
+	TSet<UObject*> Edited;
+	for (UMaterialFunction* Function : Functions)
+		FixSamplerTypes(Function, Function->FunctionExpressions, Changed, Edited);
+	for (UMaterial* Material : Materials)
+		FixSamplerTypes(Material, Material->Expressions, Changed, Edited);
+
+	// A parameter is validated against its default texture, it only follows an override when the default needs the same type.
+	// Otherwise other instances may rely on the old type, the parameter is left as is and reported
+	for (UMaterialInstanceConstant* Instance : Instances)
+	{
+		UMaterial* Base = Instance->GetMaterial();
+		if (!Base)
+			continue;
+		TArray<UMaterialExpressionTextureSampleParameter*> Parameters;
+		Base->GetAllExpressionsInMaterialAndFunctionsOfType(Parameters);
+		for (const FTextureParameterValue& Value : Instance->TextureParameterValues)
+		{
+			if (!Changed.Contains(Value.ParameterValue))
+				continue;
+			const EMaterialSamplerType SamplerType = UMaterialExpressionTextureBase::GetSamplerTypeForTexture(Value.ParameterValue);
+			for (UMaterialExpressionTextureSampleParameter* Parameter : Parameters)
+			{
+				if (Parameter->ParameterName != Value.ParameterInfo.Name || Parameter->SamplerType == SamplerType)
+					continue;
+				if (Parameter->Texture && UMaterialExpressionTextureBase::GetSamplerTypeForTexture(Parameter->Texture) != SamplerType)
+				{
+					OutConflicts.Add(FText::Format(LOCTEXT("SamplerConflict", "{0} overrides {1} of {2} with {3}, which now needs another sampler type than the default texture {4}"),
+						FText::FromString(Instance->GetName()), FText::FromName(Parameter->ParameterName), FText::FromString(Parameter->GetOuter()->GetName()),
+						FText::FromString(Value.ParameterValue->GetName()), FText::FromString(Parameter->Texture->GetName())));
+					continue;
+				}
+				BeginExpressionEdit(Parameter->GetOuter(), Edited);
+				Parameter->SamplerType = SamplerType;
+			}
+		}
+	}
+
+	{
+		FMaterialUpdateContext UpdateContext;
+		for (UObject* Object : Edited)
+		{
+			if (UMaterial* Material = Cast<UMaterial>(Object))
+				UpdateContext.AddMaterial(Material);
+			Object->PostEditChange();
+			Object->MarkPackageDirty();
+		}
+		for (UMaterial* Material : Materials)
+		{
+			if (!Edited.Contains(Material))
+				UpdateContext.AddMaterial(Material);
+		}
+		for (UMaterialInstanceConstant* Instance : Instances)
+			UpdateContext.AddMaterialInstance(Instance);
+	}
+	// Loaded materials using an edited function recompile with it, the others pick it up when loaded
+	for (UObject* Object : Edited)
+	{
+		if (UMaterialFunction* Function = Cast<UMaterialFunction>(Object))
+			UMaterialEditingLibrary::UpdateMaterialFunction(Function, nullptr);
+	}
+	for (const FText& Conflict : OutConflicts)
+		UE_LOG(LogTemp, Warning, TEXT("%s"), *Conflict.ToString());
+
+	UE_LOG(LogTemp, Log, TEXT("Applied compression settings to %d textures, %d materials and functions updated"), Textures.Num(), Edited.Num());
+	return Textures.Num();
+}
+
+#undef LOCTEXT_NAMESPACE
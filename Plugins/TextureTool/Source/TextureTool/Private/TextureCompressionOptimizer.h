@@ -0,0 +1,57 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "AssetData.h"
+#include "Engine/Texture.h"
+
+class UTexture2D;
+class IImageWrapperModule;
+
+enum class ETextureContent : uint8
+{
+	Color,
+	Normal,
+	/** Non color data, channels mostly near 0 or 1 and unrelated to each other */
+	Mask,
+	Grayscale,
+	HDR,
+	/** Color with an alpha channel which is fully opaque */
+	OpaqueAlpha,
+};
+
+/** Settings proposed for one texture, from the content of its source */
+struct FTextureCompressionProposal
+{
+	FAssetData Asset;
+	ETextureContent Content = ETextureContent::Color;
+	TextureCompressionSettings CompressionSettings = TC_Default;
+	bool bSRGB = true;
+	bool bCompressionNoAlpha = false;
+	TextureGroup LODGroup = TEXTUREGROUP_World;
+	bool bNeverStream = false;
+	/** What the texture has now, changes are the differences */
+	TextureCompressionSettings OldCompressionSettings = TC_Default;
+	bool bOldSRGB = true;
+	bool bOldCompressionNoAlpha = false;
+	TextureGroup OldLODGroup = TEXTUREGROUP_World;
+	bool bOldNeverStream = false;
+
+	bool HasChange() const;
+	FText GetContentText() const;
+	FText GetChangeText() const;
+	void ApplyTo(UTexture2D* Texture) const;
+};
+
+/** Classifies textures from a small source mip and proposes compression, sRGB and LOD group settings */
+struct FTextureCompressionOptimizer
+{
+	/** Scan every texture under Path, only proposals with a change are returned, false if cancelled */
+	static bool Scan(const FString& Path, bool bRecursive, TArray<FTextureCompressionProposal>& OutProposals);
+	/** Sample a small source mip, ImageWrapperModule must be given when called from a worker thread */
+	static bool Classify(UTexture2D* Texture, ETextureContent& OutContent, bool& bOutUnusedAlpha, IImageWrapperModule* ImageWrapperModule = nullptr);
+	static void Propose(UTexture2D* Texture, ETextureContent Content, bool bUnusedAlpha, FTextureCompressionProposal& OutProposal);
+	/**
+	 * Apply settings, rebuild platform data of every texture at once on the DDC worker threads, then fix sampler types of the materials,
+	 * material functions and instance parameters using them. Parameters which can't follow an override are left and described in OutConflicts
+	 */
+	static int32 Apply(const TArray<FTextureCompressionProposal>& Proposals, TArray<FText>& OutConflicts);
+};
@@ -0,0 +1,122 @@
+#include "TextureConsolidator.h"
+#include "AssetRegistryModule.h"
+#include "Editor.h"
+#include "Editor/Transactor.h"
+#include "Misc/FeedbackContext.h"
+#include "Serialization/ArchiveReplaceObjectRef.h"
+#include "UObject/ObjectRedirector.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectHash.h"
+#include "UObject/UObjectIterator.h"
+#include "TextureToolStats.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+DECLARE_CYCLE_STAT(TEXT("Consolidate Load Referencers"), STAT_TextureTool_ConsolidateLoad, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Consolidate Replace References"), STAT_TextureTool_ConsolidateReplace, STATGROUP_TextureTool);
+
+void FTextureConsolidator::Add(UObject* Old, UObject* New)
+{
+	if (Old && New && Old != New)
+		Replacements.Add(Old, New);
+}
+
+int32 FTextureConsolidator::Apply()
+{
+	if (Replacements.Num() == 0)
+		return 0;
+
+	// A replacement may itself be replaced later in the batch, point straight at the last one
+	for (auto& Pair : Replacements)
+	{
+		for (int32 Depth = 0; Depth < Replacements.Num(); ++Depth)
+		{
+			UObject** Next = Replacements.Find(Pair.Value);
+			if (!Next)
+				break;
+			Pair.Value = *Next;
+		}
+	}
+
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	TSet<UPackage*> ReplacedPackages;
+	TSet<FName> ReferencerNames;
+	for (auto& Pair : Replacements)
+	{
+		UPackage* Package = Pair.Key->GetOutermost();
+		ReplacedPackages.Add(Package);
+		TArray<FName> Referencers;
+		AssetRegistry.GetReferencers(Package->GetFName(), Referencers);
+		ReferencerNames.Append(Referencers);
+	}
+
+	TArray<UPackage*> Referencers;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_ConsolidateLoad);
+		int32 Index = 0;
+		for (FName PackageName : ReferencerNames)
+		{
+			GWarn->StatusUpdate(Index++, ReferencerNames.Num(), LOCTEXT("ConsolidateLoad", "Loading referencers"));
+			const FString Name = PackageName.ToString();
+			UPackage* Package = FindPackage(nullptr, *Name);
+			if (!Package)
+				Package = LoadPackage(nullptr, *Name, LOAD_NoWarn);
+			if (Package && !ReplacedPackages.Contains(Package))
+				Referencers.Add(Package);
+		}
+		// Unsaved edits are not in the registry yet
+		for (TObjectIterator<UPackage> It; It; ++It)
+		{
+			if (It->IsDirty() && !ReplacedPackages.Contains(*It))
+				Referencers.AddUnique(*It);
+		}
+	}
+
+	int32 NumChanged = 0;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_ConsolidateReplace);
+		for (UPackage* Package : Referencers)
+		{
+			TArray<UObject*> Objects;
+			GetObjectsWithOuter(Package, Objects, true);
+			for (UObject* Object : Objects)
+			{
+				if (Object->IsPendingKill())
+					continue;
+				FArchiveReplaceObjectRef<UObject> ReplaceAr(Object, Replacements, false, true, true);
+				if (ReplaceAr.GetCount() == 0)
+					continue;
+				Object->PostEditChange();
+				Object->MarkPackageDirty();
+				++NumChanged;
+			}
+		}
+	}
+
+	// Same as ConsolidateObjects, each replaced asset leaves a redirector to its replacement.
+	// The old object is not killed, transient MIDs, editors, thumbnails or render proxies outside the referencers
+	// may still point at it, it stays valid until they let go and GC collects it
+	for (auto& Pair : Replacements)
+	{
+		UObject* Old = Pair.Key;
+		UPackage* Package = Old->GetOutermost();
+		const FName Name = Old->GetFName();
+		FAssetRegistryModule::AssetDeleted(Old);
+		Old->ClearFlags(RF_Public | RF_Standalone);
+		Old->Rename(nullptr, GetTransientPackage(), REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty | REN_ForceNoResetLoaders);
+
+		UObjectRedirector* Redirector = NewObject<UObjectRedirector>(Package, Name, RF_Public | RF_Standalone);
+		Redirector->DestinationObject = Pair.Value;
+		FAssetRegistryModule::AssetCreated(Redirector);
+		Package->MarkPackageDirty();
+	}
+
+	// Undo would bring back references to the replaced assets
+	if (GEditor && GEditor->Trans)
+		GEditor->Trans->Reset(LOCTEXT("ConsolidateTransactionReset", "Consolidate Textures"));
+
+	UE_LOG(LogTemp, Log, TEXT("Consolidated %d textures, %d objects in %d referencing packages updated"), Replacements.Num(), NumChanged, Referencers.Num());
+	Replacements.Reset();
+	return NumChanged;
+}
+
+#undef LOCTEXT_NAMESPACE
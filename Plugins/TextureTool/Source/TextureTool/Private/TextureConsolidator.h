@@ -0,0 +1,22 @@
+#pragma once
+#include "CoreMinimal.h"
+
+/**
+ * Replaces assets by others in a single pass, for batches where ObjectTools::ConsolidateObjects
+ * would scan every object in memory once per replaced asset.
+ * Only packages the asset registry lists as referencers are loaded and fixed up,
+ * replaced assets become redirectors so references it could not see still resolve. The replaced objects
+ * move to the transient package and are left to garbage collection, never killed while something may use them.
+ */
+class FTextureConsolidator
+{
+public:
+	void Add(UObject* Old, UObject* New);
+	int32 Num() const { return Replacements.Num(); }
+	bool Contains(UObject* Old) const { return Replacements.Contains(Old); }
+	/** Returns the number of objects whose references were replaced */
+	int32 Apply();
+
+private:
+	TMap<UObject*, UObject*> Replacements;
+};
@@ -0,0 +1,141 @@
+#include "TextureDensityAnalyzer.h"
+#include "TextureToolStats.h"
+#include "Engine/Texture2D.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Components/StaticMeshComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "StaticMeshResources.h"
+#include "EngineUtils.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Density Analyze"), STAT_TextureTool_DensityAnalyze, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Density Mesh UVs"), STAT_TextureTool_DensityMesh, STATGROUP_TextureTool);
+
+/** Suggestions never go below this, smaller mips are too cheap to bother */
+static const int32 MinSuggestedSize = 32;
+
+FTextureDensityAnalyzer& FTextureDensityAnalyzer::Get()
+{
+	static FTextureDensityAnalyzer Analyzer;
+	return Analyzer;
+}
+
+void FTextureDensityAnalyzer::ComputeMeshDensity(UStaticMesh* Mesh, FMeshDensity& Out)
+{
+	Out.LightingGuid = Mesh->LightingGuid;
+	Out.UVDensities.Init(0.f, Mesh->StaticMaterials.Num());
+	if (!Mesh->RenderData.IsValid() || Mesh->RenderData->LODResources.Num() == 0)
+		return;
+
+	const FStaticMeshLODResources& LOD = Mesh->RenderData->LODResources[0];
+	const FPositionVertexBuffer& Positions = LOD.VertexBuffers.PositionVertexBuffer;
+	const FStaticMeshVertexBuffer& Vertices = LOD.VertexBuffers.StaticMeshVertexBuffer;
+	const FIndexArrayView Indices = LOD.IndexBuffer.GetArrayView();
+	if (Vertices.GetNumTexCoords() == 0 || Indices.Num() == 0)
+		return;
+
+	TArray<double> SurfaceAreas, UVAreas;
+	SurfaceAreas.SetNumZeroed(Out.UVDensities.Num());
+	UVAreas.SetNumZeroed(Out.UVDensities.Num());
+	for (const FStaticMeshSection& Section : LOD.Sections)
+	{
+		if (!Out.UVDensities.IsValidIndex(Section.MaterialIndex))
+			continue;
+		for (uint32 Triangle = 0; Triangle < Section.NumTriangles; ++Triangle)
+		{
+			const uint32 First = Section.FirstIndex + Triangle * 3;
+			const uint32 I0 = Indices[First], I1 = Indices[First + 1], I2 = Indices[First + 2];
+			const FVector P0 = Positions.VertexPosition(I0);
+			const FVector2D UV0 = Vertices.GetVertexUV(I0, 0);
+			SurfaceAreas[Section.MaterialIndex] += 0.5 * ((Positions.VertexPosition(I1) - P0) ^ (Positions.VertexPosition(I2) - P0)).Size();
+			UVAreas[Section.MaterialIndex] += 0.5 * FMath::Abs((Vertices.GetVertexUV(I1, 0) - UV0) ^ (Vertices.GetVertexUV(I2, 0) - UV0));
+		}
+	}
+	for (int32 Index = 0; Index < Out.UVDensities.Num(); ++Index)
+	{
+		if (SurfaceAreas[Index] > SMALL_NUMBER && UVAreas[Index] > SMALL_NUMBER)
+			Out.UVDensities[Index] = (float)FMath::Sqrt(UVAreas[Index] / SurfaceAreas[Index]);
+	}
+}
+
+void FTextureDensityAnalyzer::Analyze(UWorld* World, float TexelsPerUnit, TMap<UTexture2D*, FTextureDensityReport>& OutReports)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_DensityAnalyze);
+	TArray<UStaticMeshComponent*> Components;
+	TSet<UStaticMesh*> Meshes;
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		for (UActorComponent* Component : It->GetComponents())
+		{
+			UStaticMeshComponent* MeshComponent = Cast<UStaticMeshComponent>(Component);
+			if (MeshComponent && MeshComponent->GetStaticMesh())
+			{
+				Components.Add(MeshComponent);
+				Meshes.Add(MeshComponent->GetStaticMesh());
+			}
+		}
+	}
+
+	// Only meshes not cached yet or rebuilt since, they are independent so each gets its own task
+	TArray<UStaticMesh*> ToCompute;
+	for (UStaticMesh* Mesh : Meshes)
+	{
+		const FMeshDensity* Cached = MeshDensities.Find(Mesh);
+		if (!Cached || Cached->LightingGuid != Mesh->LightingGuid)
+			ToCompute.Add(Mesh);
+	}
+	TArray<FMeshDensity> Computed;
+	Computed.SetNum(ToCompute.Num());
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_DensityMesh);
+		ParallelFor(ToCompute.Num(), [&](int32 Index)
+		{
+			ComputeMeshDensity(ToCompute[Index], Computed[Index]);
+		});
+	}
+	for (int32 Index = 0; Index < ToCompute.Num(); ++Index)
+		MeshDensities.Add(ToCompute[Index], MoveTemp(Computed[Index]));
+
+	TMap<UMaterialInterface*, TArray<UTexture2D*>> TexturesByMaterial;
+	for (UStaticMeshComponent* Component : Components)
+	{
+		const FMeshDensity& Density = MeshDensities.FindChecked(Component->GetStaticMesh());
+		const float Scale = FMath::Max(Component->GetComponentTransform().GetMaximumAxisScale(), KINDA_SMALL_NUMBER);
+		for (int32 MaterialIndex = 0; MaterialIndex < Density.UVDensities.Num(); ++MaterialIndex)
+		{
+			UMaterialInterface* Material = Component->GetMaterial(MaterialIndex);
+			const float UVPerUnit = Density.UVDensities[MaterialIndex] / Scale;
+			if (!Material || UVPerUnit <= 0.f)
+				continue;
+
+			TArray<UTexture2D*>* Textures = TexturesByMaterial.Find(Material);
+			if (!Textures)
+			{
+				TArray<UTexture*> Used;
+				Material->GetUsedTextures(Used, EMaterialQualityLevel::Num, false, GMaxRHIFeatureLevel, false);
+				Textures = &TexturesByMaterial.Add(Material);
+				for (UTexture* Texture : Used)
+				{
+					if (UTexture2D* Texture2D = Cast<UTexture2D>(Texture))
+						Textures->AddUnique(Texture2D);
+				}
+			}
+
+			for (UTexture2D* Texture : *Textures)
+			{
+				FTextureDensityReport& Report = OutReports.FindOrAdd(Texture);
+				Report.RequiredSize = FMath::Max(Report.RequiredSize, TexelsPerUnit / UVPerUnit);
+				++Report.NumUses;
+			}
+		}
+	}
+
+	for (auto& Pair : OutReports)
+	{
+		FTextureDensityReport& Report = Pair.Value;
+		Report.CurrentSize = FMath::Max(Pair.Key->GetSizeX(), Pair.Key->GetSizeY());
+		Report.SuggestedSize = FMath::Max<int32>(FMath::RoundUpToPowerOfTwo(FMath::CeilToInt(FMath::Min(Report.RequiredSize, 16384.f))), MinSuggestedSize);
+	}
+	UE_LOG(LogTemp, Log, TEXT("Texel density of %d textures from %d components, %d of %d meshes computed"), OutReports.Num(), Components.Num(), ToCompute.Num(), Meshes.Num());
+}
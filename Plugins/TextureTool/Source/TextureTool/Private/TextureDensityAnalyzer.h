@@ -0,0 +1,47 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UTexture2D;
+class UStaticMesh;
+class UWorld;
+
+struct FTextureDensityReport
+{
+	/** Largest side the texture needs to reach the target density where its UVs are stretched the most */
+	float RequiredSize = 0.f;
+	/** Required size rounded up to a power of two, what MaxTextureSize should be */
+	int32 SuggestedSize = 0;
+	/** Largest side in game today */
+	int32 CurrentSize = 0;
+	/** Mesh sections sampling the texture */
+	int32 NumUses = 0;
+
+	/** At least twice the texels the level can show at the target density */
+	bool IsOversized() const { return SuggestedSize > 0 && CurrentSize >= 2 * SuggestedSize; }
+};
+
+/**
+ * Texel density of textures on the static meshes of a level, from the UV area over the surface area
+ * of each mesh section and the component scale. Mesh densities are computed in parallel and cached
+ * per static mesh until the mesh is rebuilt. UV tiling done inside materials is not seen.
+ */
+class FTextureDensityAnalyzer
+{
+public:
+	static FTextureDensityAnalyzer& Get();
+
+	/** TexelsPerUnit is the target density, texels per world unit */
+	void Analyze(UWorld* World, float TexelsPerUnit, TMap<UTexture2D*, FTextureDensityReport>& OutReports);
+
+private:
+	struct FMeshDensity
+	{
+		FGuid LightingGuid;
+		/** UV units per local unit by material index, 0 when the material has no triangles */
+		TArray<float> UVDensities;
+	};
+	static void ComputeMeshDensity(UStaticMesh* Mesh, FMeshDensity& Out);
+
+	TMap<TWeakObjectPtr<UStaticMesh>, FMeshDensity> MeshDensities;
+};
@@ -0,0 +1,199 @@
+#include "TextureDuplicateFinder.h"
+#include "TextureUtils.h"
+#include "Engine/Texture2D.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Async/ParallelFor.h"
+#include "Hash/CityHash.h"
+#include "ObjectTools.h"
+#include "TextureAnalysisCache.h"
+#include "TextureAnalysisScan.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+/** Textures loaded per step, loaded packages are released by a GC after each batch */
+static const int32 DuplicateScanBatchSize = 16;
+/** Bump when HashTextureSource changes */
+static const uint32 DuplicateHashVersion = 1;
+
+FTextureDuplicateFinder& FTextureDuplicateFinder::Get()
+{
+	static FTextureDuplicateFinder Finder;
+	return Finder;
+}
+
+/** Hash size, format and every mip, one mip in memory at a time */
+static uint64 HashTextureSource(FTextureSource& Source, IImageWrapperModule* ImageWrapperModule)
+{
+	int32 Header[4] = { Source.GetSizeX(), Source.GetSizeY(), Source.GetNumMips(), (int32)Source.GetFormat() };
+	uint64 Hash = CityHash64((const char*)Header, sizeof(Header));
+
+	TArray<uint8> MipData;
+	for (int32 MipIndex = 0; MipIndex < Source.GetNumMips(); ++MipIndex)
+	{
+		MipData.Reset();
+		Source.GetMipData(MipData, MipIndex, ImageWrapperModule);
+		Hash = CityHash64WithSeed((const char*)MipData.GetData(), MipData.Num(), Hash);
+	}
+	return Hash;
+}
+
+/** Settings that change how identical sources render */
+static uint32 GetRenderSettingsKey(const UTexture2D* Texture)
+{
+	return (uint32)Texture->SRGB | ((uint32)Texture->CompressionSettings << 1) | ((uint32)Texture->LODGroup << 9);
+}
+
+/**
+ * Split textures sharing a hash into groups of byte identical sources with the same render settings.
+ * The first texture left is the reference, only its mips stay decoded, each candidate is decoded one mip
+ * at a time against it. Textures which don't match are compared again against the next reference.
+ */
+static void ConfirmDuplicates(const TArray<FAssetData>& Candidates, uint64 Hash, IImageWrapperModule* ImageWrapperModule, TArray<FTextureDuplicateGroup>& OutGroups)
+{
+	TArray<FAssetData> Assets;
+	TArray<UTexture2D*> Textures;
+	for (const FAssetData& Asset : Candidates)
+	{
+		UTexture2D* Texture;
+		{
+			LLM_SCOPE(ELLMTag::Textures);
+			Texture = Cast<UTexture2D>(Asset.GetAsset());
+		}
+		if (!Texture)
+			continue;
+		Assets.Add(Asset);
+		Textures.Add(Texture);
+	}
+
+	TArray<TArray<uint8>> ReferenceMips;
+	TArray<uint8> MipData;
+	TArray<FAssetData> Matches, NextAssets;
+	TArray<UTexture2D*> NextTextures;
+	while (Textures.Num() > 1)
+	{
+		FTextureSource& Reference = Textures[0]->Source;
+		const uint32 SettingsKey = GetRenderSettingsKey(Textures[0]);
+		// Decoded when a candidate first gets that far
+		ReferenceMips.Reset();
+		ReferenceMips.SetNum(Reference.GetNumMips());
+		Matches.Reset();
+		Matches.Add(Assets[0]);
+		NextAssets.Reset();
+		NextTextures.Reset();
+		for (int32 i = 1; i < Textures.Num(); ++i)
+		{
+			FTextureSource& Source = Textures[i]->Source;
+			bool bIdentical = GetRenderSettingsKey(Textures[i]) == SettingsKey && Source.GetSizeX() == Reference.GetSizeX() && Source.GetSizeY() == Reference.GetSizeY()
+				&& Source.GetFormat() == Reference.GetFormat() && Source.GetNumMips() == Reference.GetNumMips();
+			for (int32 MipIndex = 0; bIdentical && MipIndex < ReferenceMips.Num(); ++MipIndex)
+			{
+				if (ReferenceMips[MipIndex].Num() == 0)
+					Reference.GetMipData(ReferenceMips[MipIndex], MipIndex, ImageWrapperModule);
+				MipData.Reset();
+				Source.GetMipData(MipData, MipIndex, ImageWrapperModule);
+				bIdentical = MipData == ReferenceMips[MipIndex];
+			}
+			MipData.Empty();
+			if (bIdentical)
+			{
+				Matches.Add(Assets[i]);
+			}
+			else
+			{
+				NextAssets.Add(Assets[i]);
+				NextTextures.Add(Textures[i]);
+			}
+		}
+		ReferenceMips.Empty();
+
+		if (Matches.Num() > 1)
+		{
+			OutGroups.AddDefaulted();
+			FTextureDuplicateGroup& Group = OutGroups.Last();
+			Group.Hash = Hash;
+			Group.Textures = Matches;
+			Group.Textures.Sort([](const FAssetData& A, const FAssetData& B) { return A.PackageName.Compare(B.PackageName) < 0; });
+		}
+		Swap(Assets, NextAssets);
+		Swap(Textures, NextTextures);
+	}
+}
+
+bool FTextureDuplicateFinder::Scan(const FString& Path, bool bRecursive, TArray<FTextureDuplicateGroup>& OutGroups)
+{
+	FTextureAnalysisCache& Cache = FTextureAnalysisCache::Get();
+	IImageWrapperModule* ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	TArray<FAssetData> Assets = FTextureToolUtils::GetTexturesInDirectory(Path, bRecursive);
+
+	TMap<uint64, TArray<FAssetData>> AssetsByHash;
+	const bool bScanned = FTextureAnalysisScan::Run<uint64>(Assets, ETextureAnalysis::DuplicateHash, DuplicateHashVersion, DuplicateScanBatchSize,
+		LOCTEXT("FindDuplicateTextures", "Hashing textures..."), TEXT("DuplicateScan"),
+		[&](const TArray<UTexture2D*>& Textures, TArray<uint64>& OutHashes, TArray<bool>& OutValid)
+		{
+			ParallelFor(Textures.Num(), [&](int32 Index)
+			{
+				OutHashes[Index] = HashTextureSource(Textures[Index]->Source, ImageWrapperModule);
+				OutValid[Index] = true;
+			});
+			for (int32 Index = 0; Index < Textures.Num(); ++Index)
+				Cache.Add(Textures[Index]->Source.GetId(), ETextureAnalysis::DuplicateHash, DuplicateHashVersion, OutHashes[Index]);
+		},
+		[&](const FAssetData& Asset, uint64 Hash)
+		{
+			AssetsByHash.FindOrAdd(Hash).Add(Asset);
+		});
+	if (!bScanned)
+		return false;
+
+	// A shared hash only makes a candidate, the bytes and render settings decide
+	int32 NumCandidates = 0;
+	for (auto& Pair : AssetsByHash)
+	{
+		if (Pair.Value.Num() > 1)
+			NumCandidates += Pair.Value.Num();
+	}
+	FScopedSlowTask ConfirmTask(NumCandidates, LOCTEXT("ConfirmDuplicateTextures", "Comparing duplicate candidates..."));
+	ConfirmTask.MakeDialog(true);
+	int32 NumSinceCollect = 0;
+	for (auto& Pair : AssetsByHash)
+	{
+		if (Pair.Value.Num() < 2)
+			continue;
+		if (ConfirmTask.ShouldCancel())
+			return false;
+		ConfirmTask.EnterProgressFrame(Pair.Value.Num());
+		ConfirmDuplicates(Pair.Value, Pair.Key, ImageWrapperModule, OutGroups);
+		NumSinceCollect += Pair.Value.Num();
+		if (NumSinceCollect >= DuplicateScanBatchSize)
+		{
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+			NumSinceCollect = 0;
+		}
+	}
+
+	OutGroups.Sort([](const FTextureDuplicateGroup& A, const FTextureDuplicateGroup& B) { return A.Textures.Num() > B.Textures.Num(); });
+	return true;
+}
+
+bool FTextureDuplicateFinder::Consolidate(const FTextureDuplicateGroup& Group)
+{
+	if (Group.Textures.Num() < 2)
+		return false;
+
+	UObject* ToKeep = Group.Textures[0].GetAsset();
+	TArray<UObject*> ToReplace;
+	for (int32 i = 1; i < Group.Textures.Num(); ++i)
+	{
+		if (UObject* Texture = Group.Textures[i].GetAsset())
+			ToReplace.Add(Texture);
+	}
+	if (!ToKeep || ToReplace.Num() == 0)
+		return false;
+
+	FConsolidationResults Results = ObjectTools::ConsolidateObjects(ToKeep, ToReplace);
+	return Results.FailedConsolidationObjs.Num() == 0 && Results.InvalidConsolidationObjs.Num() == 0;
+}
+
+#undef LOCTEXT_NAMESPACE
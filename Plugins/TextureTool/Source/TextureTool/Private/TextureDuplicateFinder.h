@@ -0,0 +1,27 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "AssetData.h"
+
+struct FTextureDuplicateGroup
+{
+	uint64 Hash = 0;
+	/** Sorted by package name, the first texture is the one kept by Consolidate */
+	TArray<FAssetData> Textures;
+};
+
+/**
+ * Finds byte identical textures by hashing their source mips.
+ * Hashes are kept in the texture analysis cache, unchanged packages are not even loaded on re-scan.
+ * Textures sharing a hash are then loaded to compare their bytes, and only grouped when sRGB,
+ * compression settings and LOD group match too, consolidating them must not change rendering.
+ */
+class FTextureDuplicateFinder
+{
+public:
+	static FTextureDuplicateFinder& Get();
+
+	/** Hash every texture under Path, returns false if cancelled */
+	bool Scan(const FString& Path, bool bRecursive, TArray<FTextureDuplicateGroup>& OutGroups);
+	/** Replace every reference to the group's textures by the first one */
+	static bool Consolidate(const FTextureDuplicateGroup& Group);
+};
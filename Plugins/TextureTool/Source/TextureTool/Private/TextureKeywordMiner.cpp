@@ -0,0 +1,211 @@
+#include "TextureKeywordMiner.h"
+#include "SettingObjects.h"
+#include "TextureUtils.h"
+#include "TextureToolStats.h"
+#include "AssetData.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+DECLARE_CYCLE_STAT(TEXT("Keyword Mining"), STAT_TextureTool_KeywordMining, STATGROUP_TextureTool);
+
+/** Match finds keywords case sensitively, so they are told apart the same way */
+struct FCaseSensitiveKeyFuncs : TDefaultMapKeyFuncs<FString, int32, false>
+{
+	static bool Matches(const FString& A, const FString& B)
+	{
+		return A.Equals(B, ESearchCase::CaseSensitive);
+	}
+	static uint32 GetKeyHash(const FString& Key)
+	{
+		return FCrc::StrCrc32(*Key);
+	}
+};
+
+static int32 CountBits(uint32 Mask)
+{
+	int32 Count = 0;
+	for (; Mask; Mask &= Mask - 1)
+		++Count;
+	return Count;
+}
+
+/** Support of every subset of two to four bits of Mask */
+static void AddSubsets(const TArray<int32>& Bits, int32 Start, uint32 Subset, int32 Size, int32 Count, TMap<uint32, int32>& Support)
+{
+	if (Size >= 2)
+		Support.FindOrAdd(Subset) += Count;
+	if (Size == 4)
+		return;
+	for (int32 i = Start; i < Bits.Num(); ++i)
+		AddSubsets(Bits, i + 1, Subset | (1u << Bits[i]), Size + 1, Count, Support);
+}
+
+FText FTextureKeywordProposal::GetText() const
+{
+	static const TCHAR* ChannelNames[] = { TEXT("R"), TEXT("G"), TEXT("B"), TEXT("A") };
+	FString Channels;
+	for (int32 i = 0; i < Keywords.Num(); ++i)
+		Channels += FString::Printf(TEXT("%s%s=%s"), i > 0 ? TEXT("  ") : TEXT(""), ChannelNames[i], *Keywords[i]);
+	return FText::Format(LOCTEXT("KeywordProposal", "{0}  ({1} groups)"), FText::FromString(Channels), NumGroups);
+}
+
+void FTextureKeywordProposal::ApplyTo(UTextureMergeSettings* Settings) const
+{
+	FTextureChannelSrc* Channels[] = { &Settings->R, &Settings->G, &Settings->B, &Settings->A };
+	for (int32 i = 0; i < 4; ++i)
+	{
+		Channels[i]->Optional = Keywords.IsValidIndex(i);
+		if (Channels[i]->Optional)
+			Channels[i]->Keyword = Keywords[i];
+	}
+	Settings->ReplaceTexture.Optional = false;
+}
+
+void FTextureKeywordMiner::Mine(const FString& SrcPath, bool bRecursive, TArray<FTextureKeywordProposal>& OutProposals, TArray<FTextureKeywordStats>& OutStats)
+{
+	TArray<FAssetData> Assets = FTextureToolUtils::GetTexturesInDirectory(SrcPath, bRecursive);
+	TArray<FString> PackageNames;
+	PackageNames.Reserve(Assets.Num());
+	for (const FAssetData& Asset : Assets)
+		PackageNames.Add(Asset.PackageName.ToString());
+	Mine(SrcPath, PackageNames, OutProposals, OutStats);
+}
+
+void FTextureKeywordMiner::Mine(const FString& SrcPath, const TArray<FString>& PackageNames, TArray<FTextureKeywordProposal>& OutProposals, TArray<FTextureKeywordStats>& OutStats)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_KeywordMining);
+	OutProposals.Reset();
+	OutStats.Reset();
+
+	// Keywords and stems are interned, a stem keeps the ids of the keywords seen on it
+	TMap<FString, int32, FDefaultSetAllocator, FCaseSensitiveKeyFuncs> KeywordIds;
+	TMap<FString, int32> StemIds;
+	TArray<TArray<int32>> StemKeywords;
+	for (const FString& PackageName : PackageNames)
+	{
+		// Relative to the input directory, as Match names groups
+		const FString Name = PackageName.RightChop(SrcPath.Len() + 1);
+		int32 Slash = INDEX_NONE;
+		Name.FindLastChar(TEXT('/'), Slash);
+		const int32 BaseStart = Slash + 1;
+		const int32 Len = Name.Len();
+		// The first token is the asset type prefix
+		int32 TokenStart = Name.Find(TEXT("_"), ESearchCase::CaseSensitive, ESearchDir::FromStart, BaseStart);
+		while (TokenStart != INDEX_NONE)
+		{
+			const int32 TokenEnd = Name.Find(TEXT("_"), ESearchCase::CaseSensitive, ESearchDir::FromStart, TokenStart + 1);
+			const int32 TokenLen = (TokenEnd == INDEX_NONE ? Len : TokenEnd) - TokenStart;
+			if (TokenLen > 1 && !FChar::IsDigit(Name[TokenStart + 1]))
+			{
+				const FString Keyword = Name.Mid(TokenStart, TokenLen);
+				int32 KeywordId;
+				if (const int32* Found = KeywordIds.Find(Keyword))
+				{
+					KeywordId = *Found;
+				}
+				else
+				{
+					KeywordId = OutStats.Num();
+					KeywordIds.Add(Keyword, KeywordId);
+					OutStats.AddDefaulted();
+					OutStats.Last().Keyword = Keyword;
+				}
+				if (TokenEnd == INDEX_NONE)
+					++OutStats[KeywordId].NumSuffix;
+				else
+					++OutStats[KeywordId].NumInfix;
+
+				// Match replaces the last occurrence, which may be a later token
+				const int32 MatchPos = Name.Find(Keyword, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+				const FString Stem = Name.Left(MatchPos) + TEXT("***") + Name.RightChop(MatchPos + TokenLen);
+				int32* StemId = StemIds.Find(Stem);
+				if (!StemId)
+				{
+					StemId = &StemIds.Add(Stem, StemKeywords.Num());
+					StemKeywords.AddDefaulted();
+				}
+				StemKeywords[*StemId].AddUnique(KeywordId);
+			}
+			TokenStart = TokenEnd;
+		}
+	}
+
+	for (const TArray<int32>& Keywords : StemKeywords)
+	{
+		if (Keywords.Num() < 2)
+			continue;
+		for (int32 KeywordId : Keywords)
+			++OutStats[KeywordId].NumSharedStems;
+	}
+
+	// Sets are counted over the most shared keywords, one bit each
+	TArray<int32> Ranked;
+	for (int32 KeywordId = 0; KeywordId < OutStats.Num(); ++KeywordId)
+	{
+		if (OutStats[KeywordId].NumSharedStems > 0)
+			Ranked.Add(KeywordId);
+	}
+	Ranked.Sort([&](int32 A, int32 B) { return OutStats[A].NumSharedStems > OutStats[B].NumSharedStems; });
+	Ranked.SetNum(FMath::Min(Ranked.Num(), MaxKeywords));
+	TArray<int32> BitOfKeyword;
+	BitOfKeyword.Init(INDEX_NONE, OutStats.Num());
+	for (int32 Bit = 0; Bit < Ranked.Num(); ++Bit)
+		BitOfKeyword[Ranked[Bit]] = Bit;
+
+	// Stems with the same keywords are counted once, then every set they complete gets their count
+	TMap<uint32, int32> MaskCounts;
+	for (const TArray<int32>& Keywords : StemKeywords)
+	{
+		uint32 Mask = 0;
+		for (int32 KeywordId : Keywords)
+		{
+			if (BitOfKeyword[KeywordId] != INDEX_NONE)
+				Mask |= 1u << BitOfKeyword[KeywordId];
+		}
+		if (CountBits(Mask) >= 2)
+			++MaskCounts.FindOrAdd(Mask);
+	}
+	TMap<uint32, int32> Support;
+	for (const auto& Pair : MaskCounts)
+	{
+		TArray<int32> Bits;
+		for (int32 Bit = 0; Bit < Ranked.Num(); ++Bit)
+		{
+			if (Pair.Key & (1u << Bit))
+				Bits.Add(Bit);
+		}
+		AddSubsets(Bits, 0, 0, 0, Pair.Value, Support);
+	}
+
+	// A set is only worth proposing when adding a channel to it loses groups
+	TArray<TPair<uint32, int32>> Sets;
+	for (const auto& Pair : Support)
+	{
+		bool bClosed = true;
+		for (int32 Bit = 0; Bit < Ranked.Num() && bClosed; ++Bit)
+		{
+			const int32* Superset = (Pair.Key & (1u << Bit)) ? nullptr : Support.Find(Pair.Key | (1u << Bit));
+			bClosed = !Superset || *Superset < Pair.Value;
+		}
+		if (bClosed)
+			Sets.Emplace(Pair.Key, Pair.Value);
+	}
+	Sets.Sort([](const TPair<uint32, int32>& A, const TPair<uint32, int32>& B)
+	{
+		return A.Value != B.Value ? A.Value > B.Value : CountBits(A.Key) > CountBits(B.Key);
+	});
+	for (int32 Index = 0; Index < Sets.Num() && OutProposals.Num() < MaxProposals; ++Index)
+	{
+		OutProposals.AddDefaulted();
+		FTextureKeywordProposal& Proposal = OutProposals.Last();
+		Proposal.NumGroups = Sets[Index].Value;
+		for (int32 Bit = 0; Bit < Ranked.Num(); ++Bit)
+		{
+			if (Sets[Index].Key & (1u << Bit))
+				Proposal.Keywords.Add(OutStats[Ranked[Bit]].Keyword);
+		}
+	}
+
+	OutStats.Sort([](const FTextureKeywordStats& A, const FTextureKeywordStats& B) { return A.NumSharedStems > B.NumSharedStems; });
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,43 @@
+#pragma once
+#include "CoreMinimal.h"
+
+class UTextureMergeSettings;
+
+/** How often a name token is seen, as the last token of a name or inside it */
+struct FTextureKeywordStats
+{
+	FString Keyword;
+	int32 NumSuffix = 0;
+	int32 NumInfix = 0;
+	/** Stems the keyword shares with at least one other keyword */
+	int32 NumSharedStems = 0;
+};
+
+/** Channel keywords and the complete groups Match would find with them */
+struct FTextureKeywordProposal
+{
+	/** Two to four keywords, for R, G, B then A */
+	TArray<FString> Keywords;
+	int32 NumGroups = 0;
+
+	FText GetText() const;
+	/** Keywords into the first channels, the other channels and ReplaceTexture are left out */
+	void ApplyTo(UTextureMergeSettings* Settings) const;
+};
+
+/**
+ * Finds the channel keyword conventions of a directory. Every texture name is split once at underscores,
+ * each token is a candidate keyword and replacing it with *** the way Match does gives its stem.
+ * Keyword sets are counted over the stems of the most shared keywords, a set found complete on
+ * N stems gives N groups. Numeric tokens are variations, not channels, and are skipped.
+ */
+struct TEXTURETOOL_API FTextureKeywordMiner
+{
+	/** Keywords considered for sets, the most shared first */
+	static const int32 MaxKeywords = 16;
+	static const int32 MaxProposals = 8;
+
+	/** Proposals ranked by groups, then by channels, stats ranked by shared stems */
+	static void Mine(const FString& SrcPath, bool bRecursive, TArray<FTextureKeywordProposal>& OutProposals, TArray<FTextureKeywordStats>& OutStats);
+	static void Mine(const FString& SrcPath, const TArray<FString>& PackageNames, TArray<FTextureKeywordProposal>& OutProposals, TArray<FTextureKeywordStats>& OutStats);
+};
@@ -0,0 +1,235 @@
+#include "TextureMaterialRewriter.h"
+#include "Engine/Texture2D.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceConstant.h"
+#include "Materials/MaterialFunction.h"
+#include "Materials/MaterialExpressionTextureSample.h"
+#include "Materials/MaterialExpressionTextureSampleParameter.h"
+#include "MaterialShared.h"
+#include "MaterialEditingLibrary.h"
+#include "AssetRegistryModule.h"
+#include "Toolkits/AssetEditorManager.h"
+
+/** Texture sample pins are RGB, R, G, B, A then RGBA */
+static const int32 SampleOutputB = 3;
+
+static bool IsMaterialAsset(const FAssetData& Asset)
+{
+	return Asset.AssetClass == UMaterial::StaticClass()->GetFName() || Asset.AssetClass == UMaterialInstanceConstant::StaticClass()->GetFName();
+}
+
+/** Every instance inheriting from Parent, directly or through other instances */
+static void GatherInstances(UMaterialInterface* Parent, IAssetRegistry& AssetRegistry, TArray<UMaterialInstanceConstant*>& OutInstances)
+{
+	TArray<FName> Referencers;
+	AssetRegistry.GetReferencers(Parent->GetOutermost()->GetFName(), Referencers);
+	for (FName PackageName : Referencers)
+	{
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssetsByPackageName(PackageName, Assets);
+		for (const FAssetData& Asset : Assets)
+		{
+			if (Asset.AssetClass != UMaterialInstanceConstant::StaticClass()->GetFName())
+				continue;
+			UMaterialInstanceConstant* Instance = Cast<UMaterialInstanceConstant>(Asset.GetAsset());
+			if (Instance && Instance->Parent == Parent && !OutInstances.Contains(Instance))
+			{
+				OutInstances.Add(Instance);
+				GatherInstances(Instance, AssetRegistry, OutInstances);
+			}
+		}
+	}
+}
+
+static const FTextureParameterValue* FindOverride(UMaterialInstanceConstant* Instance, FName ParameterName)
+{
+	return Instance->TextureParameterValues.FindByPredicate([&](const FTextureParameterValue& Value) { return Value.ParameterInfo.Name == ParameterName; });
+}
+
+void FTextureMaterialRewriter::AddPacking(UTexture2D* Packed, UTexture2D* const Sources[4], const EChannel SourceChannels[4])
+{
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (Sources[i] && Sources[i] != Packed)
+			Remaps.Add(Sources[i], { Packed, i, (int32)SourceChannels[i] });
+	}
+}
+
+int32 FTextureMaterialRewriter::Apply()
+{
+	if (Remaps.Num() == 0)
+		return 0;
+
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	// Base materials of every material or instance referencing a source
+	TSet<UMaterial*> Materials;
+	for (auto& Pair : Remaps)
+	{
+		TArray<FName> Referencers;
+		AssetRegistry.GetReferencers(Pair.Key->GetOutermost()->GetFName(), Referencers);
+		for (FName PackageName : Referencers)
+		{
+			TArray<FAssetData> Assets;
+			AssetRegistry.GetAssetsByPackageName(PackageName, Assets);
+			for (const FAssetData& Asset : Assets)
+			{
+				// A function graph is shared by every material calling it, its samples are left to be packed by hand
+				if (Asset.AssetClass == UMaterialFunction::StaticClass()->GetFName())
+				{
+					UE_LOG(LogTemp, Warning, TEXT("Keep %s in material function %s, samples inside functions are not rewired"), *Pair.Key->GetName(), *Asset.ObjectPath.ToString());
+					continue;
+				}
+				if (!IsMaterialAsset(Asset))
+					continue;
+				UMaterialInterface* Material = Cast<UMaterialInterface>(Asset.GetAsset());
+				if (Material && Material->GetMaterial())
+					Materials.Add(Material->GetMaterial());
+			}
+		}
+	}
+
+	TArray<UMaterial*> ChangedMaterials;
+	TSet<UMaterialInstanceConstant*> ChangedInstances;
+	for (UMaterial* Material : Materials)
+	{
+		TArray<UMaterialInstanceConstant*> Instances;
+		GatherInstances(Material, AssetRegistry, Instances);
+		if (Rewire(Material, Instances, ChangedInstances))
+			ChangedMaterials.Add(Material);
+	}
+
+	// Every PreEditChange of Rewire gets its PostEditChange here, inside one update context so the scene is updated once for the whole batch
+	{
+		FMaterialUpdateContext UpdateContext;
+		for (UMaterial* Material : ChangedMaterials)
+		{
+			UpdateContext.AddMaterial(Material);
+			Material->PostEditChange();
+			Material->MarkPackageDirty();
+		}
+		for (UMaterialInstanceConstant* Instance : ChangedInstances)
+		{
+			UpdateContext.AddMaterialInstance(Instance);
+			Instance->PostEditChange();
+			Instance->MarkPackageDirty();
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Rewired %d materials and %d material instances to packed textures"), ChangedMaterials.Num(), ChangedInstances.Num());
+	Remaps.Reset();
+	return ChangedMaterials.Num() + ChangedInstances.Num();
+}
+
+bool FTextureMaterialRewriter::Rewire(UMaterial* Material, const TArray<UMaterialInstanceConstant*>& Instances, TSet<UMaterialInstanceConstant*>& OutChangedInstances)
+{
+	TArray<FExpressionInput*> Inputs;
+	for (UMaterialExpression* Expression : Material->Expressions)
+	{
+		if (Expression)
+			Inputs.Append(Expression->GetInputs());
+	}
+	for (int32 Property = 0; Property < MP_MAX; ++Property)
+	{
+		if (FExpressionInput* Input = Material->GetExpressionInputForProperty((EMaterialProperty)Property))
+			Inputs.Add(Input);
+	}
+
+	// Samples reading a source, grouped by packed texture and UVs, each group becomes a single sample
+	TMap<FString, TArray<UMaterialExpressionTextureSample*>> Groups;
+	for (UMaterialExpression* Expression : Material->Expressions)
+	{
+		UMaterialExpressionTextureSample* Sample = Cast<UMaterialExpressionTextureSample>(Expression);
+		UTexture2D* Source = Sample ? Cast<UTexture2D>(Sample->Texture) : nullptr;
+		const FSourceRemap* Remap = Source ? Remaps.Find(Source) : nullptr;
+		if (!Remap || Sample->TextureObject.Expression)
+			continue;
+
+		// Only the packed channel survives, a G8 source holds the same value in every color pin
+		const bool bSingleChannel = Source->Source.GetFormat() == TSF_G8;
+		bool bCanRewire = true;
+		for (FExpressionInput* Input : Inputs)
+		{
+			if (Input->Expression == Sample)
+				bCanRewire &= Input->OutputIndex == Remap->SourceChannel + 1 || (bSingleChannel && Input->OutputIndex <= SampleOutputB);
+		}
+		if (!bCanRewire)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Keep %s in %s, it reads channels which were not packed"), *Source->GetName(), *Material->GetPathName());
+			continue;
+		}
+
+		// Instances share the graph, they may only override the parameter with the same source
+		if (UMaterialExpressionTextureSampleParameter* Parameter = Cast<UMaterialExpressionTextureSampleParameter>(Sample))
+		{
+			for (UMaterialInstanceConstant* Instance : Instances)
+			{
+				const FTextureParameterValue* Override = FindOverride(Instance, Parameter->ParameterName);
+				if (Override && Override->ParameterValue != Source)
+				{
+					UE_LOG(LogTemp, Warning, TEXT("Keep parameter %s in %s, %s overrides it with another texture"), *Parameter->ParameterName.ToString(), *Material->GetPathName(), *Instance->GetPathName());
+					bCanRewire = false;
+					break;
+				}
+			}
+			if (!bCanRewire)
+				continue;
+		}
+
+		const FString Key = FString::Printf(TEXT("%p|%p|%d|%d|%d|%p|%d"), Remap->Packed, Sample->Coordinates.Expression, Sample->Coordinates.OutputIndex,
+			Sample->ConstCoordinate, (int32)Sample->MipValueMode, Sample->MipValue.Expression, (int32)Sample->SamplerSource);
+		Groups.FindOrAdd(Key).Add(Sample);
+	}
+	if (Groups.Num() == 0)
+		return false;
+
+	// Graph is edited directly, an open editor would write its own copy back
+	FAssetEditorManager::Get().CloseAllEditorsForAsset(Material);
+	Material->Modify();
+	Material->PreEditChange(nullptr);
+
+	for (auto& Pair : Groups)
+	{
+		TArray<UMaterialExpressionTextureSample*>& Samples = Pair.Value;
+		// Keep a parameter when there is one, so instances can still override the packed texture
+		const int32 ParameterIndex = Samples.IndexOfByPredicate([](UMaterialExpressionTextureSample* Sample) { return Sample->IsA<UMaterialExpressionTextureSampleParameter>(); });
+		UMaterialExpressionTextureSample* Keep = Samples[FMath::Max(ParameterIndex, 0)];
+		UMaterialExpressionTextureSampleParameter* KeepParameter = Cast<UMaterialExpressionTextureSampleParameter>(Keep);
+		UTexture2D* Packed = Remaps[Cast<UTexture2D>(Keep->Texture)].Packed;
+
+		for (UMaterialExpressionTextureSample* Sample : Samples)
+		{
+			const FSourceRemap& Remap = Remaps[Cast<UTexture2D>(Sample->Texture)];
+			for (FExpressionInput* Input : Inputs)
+			{
+				if (Input->Expression == Sample)
+					Input->Connect(Remap.OutputChannel + 1, Keep);
+			}
+
+			// Overrides of merged parameters move to the kept one
+			if (UMaterialExpressionTextureSampleParameter* Parameter = Cast<UMaterialExpressionTextureSampleParameter>(Sample))
+			{
+				for (UMaterialInstanceConstant* Instance : Instances)
+				{
+					if (!FindOverride(Instance, Parameter->ParameterName))
+						continue;
+					if (!OutChangedInstances.Contains(Instance))
+					{
+						Instance->Modify();
+						Instance->PreEditChange(nullptr);
+					}
+					Instance->TextureParameterValues.RemoveAll([&](const FTextureParameterValue& Value) { return Value.ParameterInfo.Name == Parameter->ParameterName; });
+					if (KeepParameter)
+						Instance->SetTextureParameterValueEditorOnly(FMaterialParameterInfo(KeepParameter->ParameterName), Packed);
+					OutChangedInstances.Add(Instance);
+				}
+			}
+
+			if (Sample != Keep)
+				UMaterialEditingLibrary::DeleteMaterialExpression(Material, Sample);
+		}
+		Keep->Texture = Packed;
+		Keep->SamplerType = UMaterialExpressionTextureBase::GetSamplerTypeForTexture(Packed);
+	}
+	return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "SettingObjects.h"
+
+class UTexture2D;
+class UMaterial;
+class UMaterialInstanceConstant;
+
+/** Redirects materials sampling channel sources to the texture they were packed into */
+class FTextureMaterialRewriter
+{
+public:
+	/** Sources in output channel order, null for unused channels, SourceChannels is the channel read from each source */
+	void AddPacking(UTexture2D* Packed, UTexture2D* const Sources[4], const EChannel SourceChannels[4]);
+	/** Rewire materials and instances using the sources and recompile them in one batch, returns the number of assets changed. Samples inside material functions are reported, not rewired */
+	int32 Apply();
+
+private:
+	struct FSourceRemap
+	{
+		UTexture2D* Packed;
+		int32 OutputChannel;
+		int32 SourceChannel;
+	};
+	/** Rewire one material graph, instances are the ones inheriting from it, returns true if the graph changed */
+	bool Rewire(UMaterial* Material, const TArray<UMaterialInstanceConstant*>& Instances, TSet<UMaterialInstanceConstant*>& OutChangedInstances);
+
+	TMap<UTexture2D*, FSourceRemap> Remaps;
+};
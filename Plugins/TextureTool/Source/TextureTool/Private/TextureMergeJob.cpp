@@ -0,0 +1,263 @@
+#include "TextureMergeJob.h"
+#include "TextureTiledMerge.h"
+#include "TextureToolStats.h"
+#include "Engine/Texture2D.h"
+#include "UObject/Package.h"
+#include "PackageTools.h"
+#include "AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#include "Misc/FeedbackContext.h"
+#include "Async/Async.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+DECLARE_CYCLE_STAT(TEXT("Merge Job"), STAT_TextureTool_MergeJob, STATGROUP_TextureTool);
+
+/** Time given to queued jobs at each tick, so the editor stays responsive while thousands are queued */
+static const double TickBudgetSeconds = 0.05;
+
+FTextureMergeQueue* FTextureMergeQueue::Instance = nullptr;
+
+FTextureMergeQueue& FTextureMergeQueue::Get()
+{
+	check(Instance);
+	return *Instance;
+}
+
+void FTextureMergeQueue::Startup()
+{
+	if (!Instance)
+		Instance = new FTextureMergeQueue();
+}
+
+void FTextureMergeQueue::Shutdown()
+{
+	delete Instance;
+	Instance = nullptr;
+}
+
+FTextureMergeQueue::FTextureMergeQueue()
+{
+	TickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FTextureMergeQueue::Tick));
+}
+
+FTextureMergeQueue::~FTextureMergeQueue()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickHandle);
+
+	// Nobody is left to call back, waiting futures still get their failure
+	FTextureMergeJobResult Dropped;
+	Dropped.FailReason = LOCTEXT("MergeJobShutdown", "Merge queue was shut down before the job ran!");
+	for (int32 Index = Next; Index < Running.Num(); ++Index)
+		Running[Index]->Promise.SetValue(Dropped);
+	for (TUniquePtr<FPendingJob>& Job : Pending)
+		Job->Promise.SetValue(Dropped);
+	if (Running.Num() - Next + Pending.Num() > 0)
+		UE_LOG(LogTemp, Warning, TEXT("Dropped %d queued merge jobs"), Running.Num() - Next + Pending.Num());
+}
+
+TArray<TFuture<FTextureMergeJobResult>> FTextureMergeQueue::Submit(const TArray<FTextureMergeJob>& Jobs)
+{
+	TArray<TFuture<FTextureMergeJobResult>> Futures;
+	Enqueue(Jobs, &Futures, nullptr);
+	return Futures;
+}
+
+void FTextureMergeQueue::Submit(const TArray<FTextureMergeJob>& Jobs, FOnJobsDone OnDone)
+{
+	if (Jobs.Num() == 0)
+	{
+		if (OnDone)
+			AsyncTask(ENamedThreads::GameThread, [OnDone]() { OnDone(TArray<FTextureMergeJobResult>()); });
+		return;
+	}
+	Enqueue(Jobs, nullptr, MoveTemp(OnDone));
+}
+
+void FTextureMergeQueue::Enqueue(const TArray<FTextureMergeJob>& Jobs, TArray<TFuture<FTextureMergeJobResult>>* OutFutures, FOnJobsDone OnDone)
+{
+	TSharedPtr<FSubmission> Submission;
+	if (OnDone)
+	{
+		Submission = MakeShared<FSubmission>();
+		Submission->Results.SetNum(Jobs.Num());
+		Submission->NumRemaining = Jobs.Num();
+		Submission->OnDone = MoveTemp(OnDone);
+	}
+
+	FScopeLock Lock(&PendingLock);
+	Pending.Reserve(Pending.Num() + Jobs.Num());
+	for (int32 Index = 0; Index < Jobs.Num(); ++Index)
+	{
+		TUniquePtr<FPendingJob> Job = MakeUnique<FPendingJob>();
+		Job->Job = Jobs[Index];
+		Job->Submission = Submission;
+		Job->Index = Index;
+		if (OutFutures)
+			OutFutures->Add(Job->Promise.GetFuture());
+		Pending.Add(MoveTemp(Job));
+	}
+}
+
+void FTextureMergeQueue::Flush()
+{
+	while (GetNumQueued() > 0)
+		RunJobs(MAX_dbl);
+}
+
+int32 FTextureMergeQueue::GetNumQueued() const
+{
+	FScopeLock Lock(&PendingLock);
+	return Pending.Num() + Running.Num() - Next;
+}
+
+bool FTextureMergeQueue::Tick(float DeltaTime)
+{
+	if (GetNumQueued() > 0)
+		RunJobs(TickBudgetSeconds);
+	return true;
+}
+
+void FTextureMergeQueue::RunJobs(double MaxSeconds)
+{
+	check(IsInGameThread());
+	{
+		FScopeLock Lock(&PendingLock);
+		for (TUniquePtr<FPendingJob>& Job : Pending)
+			Running.Add(MoveTemp(Job));
+		Pending.Reset();
+	}
+
+	// Sources shared by queued jobs stay decoded until the queue is empty
+	if (!DecodeCache)
+		DecodeCache = MakeUnique<FTextureSourceDecodeCache>();
+	const double StartTime = FPlatformTime::Seconds();
+	while (Next < Running.Num())
+	{
+		// Moved out first, a callback may submit more jobs or flush the queue
+		TUniquePtr<FPendingJob> Job;
+		{
+			FScopeLock Lock(&PendingLock);
+			Job = MoveTemp(Running[Next++]);
+		}
+		const FTextureMergeJobResult Result = Run(Job->Job, DecodeCache.Get());
+		bSaved |= Job->Job.bSave && Result.Texture;
+		Complete(*Job, Result);
+		if (FPlatformTime::Seconds() - StartTime >= MaxSeconds)
+			break;
+	}
+
+	if (GetNumQueued() == 0)
+	{
+		{
+			FScopeLock Lock(&PendingLock);
+			Running.Reset();
+			Next = 0;
+		}
+		DecodeCache.Reset();
+		if (bSaved)
+			UPackage::WaitForAsyncFileWrites();
+		bSaved = false;
+	}
+}
+
+void FTextureMergeQueue::Complete(FPendingJob& Job, const FTextureMergeJobResult& Result)
+{
+	Job.Promise.SetValue(Result);
+	if (!Job.Submission.IsValid())
+		return;
+	Job.Submission->Results[Job.Index] = Result;
+	if (--Job.Submission->NumRemaining == 0)
+		Job.Submission->OnDone(Job.Submission->Results);
+}
+
+FTextureMergeJobResult FTextureMergeQueue::Run(const FTextureMergeJob& Job, FTextureSourceDecodeCache* DecodeCache)
+{
+	check(IsInGameThread());
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_MergeJob);
+	FTextureMergeJobResult Result;
+	const FTextureChannelSrc* Channels[4] = { &Job.R, &Job.G, &Job.B, &Job.A };
+	UTexture2D* Sources[4];
+	for (int32 i = 0; i < 4; ++i)
+		Sources[i] = Channels[i]->Optional ? Channels[i]->Texture : nullptr;
+
+	if (Job.PackagePath.IsEmpty())
+	{
+		const FName Name = MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass(), Job.AssetName.IsEmpty() ? NAME_None : FName(*Job.AssetName));
+		Result.Texture = FTextureTiledMerge::Merge(GetTransientPackage(), Name.ToString(), RF_Transient, Sources, Channels, Result.FailReason, nullptr, DecodeCache, Job.CompressionSettings);
+		// Nothing else references a transient output, a future or a script may read it after any number of GCs
+		if (Result.Texture)
+		{
+			Result.TextureReference = MakeShareable(new TStrongObjectPtr<UTexture2D>(Result.Texture), [](TStrongObjectPtr<UTexture2D>* Reference)
+			{
+				if (IsInGameThread())
+					delete Reference;
+				else
+					AsyncTask(ENamedThreads::GameThread, [Reference]() { delete Reference; });
+			});
+		}
+		return Result;
+	}
+	if (Job.AssetName.IsEmpty())
+	{
+		Result.FailReason = LOCTEXT("MergeJobNoName", "Merge job has a package path but no asset name!");
+		return Result;
+	}
+
+	const FString PackageName = UPackageTools::SanitizePackageName(Job.PackagePath / Job.AssetName);
+	Result.Texture = FTextureTiledMerge::Merge(CreatePackage(NULL, *PackageName), FPaths::GetBaseFilename(PackageName), RF_Public | RF_Standalone, Sources, Channels, Result.FailReason,
+		nullptr, DecodeCache, Job.CompressionSettings);
+	if (!Result.Texture)
+		return Result;
+	Result.Texture->MarkPackageDirty();
+	FAssetRegistryModule::AssetCreated(Result.Texture);
+	if (Job.bSave)
+	{
+		UPackage* Package = Result.Texture->GetOutermost();
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		if (!UPackage::SavePackage(Package, Result.Texture, RF_Standalone, *Filename, GWarn, nullptr, false, true, SAVE_Async | SAVE_NoError))
+			Result.FailReason = FText::Format(LOCTEXT("MergeJobSave", "Fail to save {0}!"), FText::FromString(Package->GetName()));
+	}
+	return Result;
+}
+
+void FTextureMergeQueue::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	// Sources of queued jobs, outputs are kept by their results
+	FScopeLock Lock(&PendingLock);
+	auto AddJob = [&](FPendingJob& Job)
+	{
+		for (FTextureChannelSrc* Src : { &Job.Job.R, &Job.Job.G, &Job.Job.B, &Job.Job.A })
+			Collector.AddReferencedObject(Src->Texture);
+	};
+	for (int32 Index = Next; Index < Running.Num(); ++Index)
+		AddJob(*Running[Index]);
+	for (TUniquePtr<FPendingJob>& Job : Pending)
+		AddJob(*Job);
+}
+
+TArray<FTextureMergeJobResult> UTextureMergeLibrary::RunMergeJobs(const TArray<FTextureMergeJob>& Jobs)
+{
+	TArray<FTextureMergeJobResult> Results;
+	FTextureSourceDecodeCache DecodeCache;
+	bool bSaved = false;
+	for (const FTextureMergeJob& Job : Jobs)
+	{
+		Results.Add(FTextureMergeQueue::Run(Job, &DecodeCache));
+		bSaved |= Job.bSave && Results.Last().Texture;
+		if (!Results.Last().Texture)
+			UE_LOG(LogTemp, Error, TEXT("Merge job %s failed due to %s"), *Job.AssetName, *Results.Last().FailReason.ToString());
+	}
+	if (bSaved)
+		UPackage::WaitForAsyncFileWrites();
+	return Results;
+}
+
+void UTextureMergeLibrary::SubmitMergeJobs(const TArray<FTextureMergeJob>& Jobs, const FOnTextureMergeJobsDone& OnDone)
+{
+	FTextureMergeQueue::Get().Submit(Jobs, [OnDone](const TArray<FTextureMergeJobResult>& Results)
+	{
+		OnDone.ExecuteIfBound(Results);
+	});
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,55 @@
+#include "TextureMergeJournal.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+FTextureMergeJournal::FTextureMergeJournal(const FString& Fingerprint)
+{
+	Filename = FPaths::ProjectSavedDir() / TEXT("TextureTool") / FString::Printf(TEXT("Journal-%s.txt"), *Fingerprint);
+
+	TArray<FString> Lines;
+	FFileHelper::LoadFileToStringArray(Lines, *Filename);
+	for (const FString& Line : Lines)
+	{
+		// A line cut by a crash has no separator and is ignored
+		FString Name, OutputPackage;
+		if (Line.Split(TEXT("\t"), &Name, &OutputPackage) && !OutputPackage.IsEmpty())
+			Completed.Add(Name, OutputPackage);
+	}
+}
+
+FTextureMergeJournal::~FTextureMergeJournal()
+{
+	Handle.Reset();
+}
+
+void FTextureMergeJournal::Reset()
+{
+	Delete();
+	Completed.Reset();
+}
+
+void FTextureMergeJournal::Append(const FString& Name, const FString& OutputPackage)
+{
+	Completed.Add(Name, OutputPackage);
+	if (!Handle)
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+		Handle.Reset(PlatformFile.OpenWrite(*Filename, true));
+		if (!Handle)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Fail to open batch journal %s, the batch can not be resumed"), *Filename);
+			return;
+		}
+	}
+	const FTCHARToUTF8 Line(*FString::Printf(TEXT("%s\t%s\n"), *Name, *OutputPackage));
+	Handle->Write((const uint8*)Line.Get(), Line.Length());
+	Handle->Flush();
+}
+
+void FTextureMergeJournal::Delete()
+{
+	Handle.Reset();
+	IFileManager::Get().Delete(*Filename, false, false, true);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/**
+ * Append only record of the groups completed by a batch merge, in Saved/TextureTool/Journal-<Fingerprint>.txt.
+ * One line per group, the matched name and the package it was saved to, flushed as soon as it is written
+ * so a crashed or cancelled batch can be resumed.
+ */
+class FTextureMergeJournal
+{
+public:
+	explicit FTextureMergeJournal(const FString& Fingerprint);
+	~FTextureMergeJournal();
+
+	/** Output package by matched name, read when the journal is opened */
+	const TMap<FString, FString>& GetCompleted() const { return Completed; }
+	/** Forget every completed group and start a new journal */
+	void Reset();
+	void Append(const FString& Name, const FString& OutputPackage);
+	/** The batch completed, nothing to resume */
+	void Delete();
+
+private:
+	FString Filename;
+	TMap<FString, FString> Completed;
+	TUniquePtr<IFileHandle> Handle;
+};
@@ -0,0 +1,14 @@
+#include "TextureMergePresetFactory.h"
+#include "SettingObjects.h"
+
+UTextureMergePresetFactory::UTextureMergePresetFactory()
+{
+	SupportedClass = UTextureMergePreset::StaticClass();
+	bCreateNew = true;
+	bEditAfterNew = true;
+}
+
+UObject* UTextureMergePresetFactory::FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn)
+{
+	return NewObject<UTextureMergePreset>(InParent, InClass, InName, Flags);
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Factories/Factory.h"
+#include "TextureMergePresetFactory.generated.h"
+
+/** Lets merge presets be created from the content browser, not only saved from the merge settings */
+UCLASS()
+class UTextureMergePresetFactory : public UFactory
+{
+	GENERATED_BODY()
+public:
+	UTextureMergePresetFactory();
+	virtual UObject* FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn) override;
+};
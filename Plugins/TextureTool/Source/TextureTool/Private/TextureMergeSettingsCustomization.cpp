@@ -78,6 +78,13 @@ void FTextureChannelSourceCustomization::CustomizeHeader(TSharedRef<IPropertyHan
 	}
 }
 
+void FTextureChannelSourceCustomization::CustomizeChildren(TSharedRef<IPropertyHandle> PropertyHandle, IDetailChildrenBuilder& ChildBuilder, IPropertyTypeCustomizationUtils& CustomizationUtils)
+{
+	// Everything else is in the header
+	ChildBuilder.AddProperty(PropertyHandle->GetChildHandle(GET_MEMBER_NAME_CHECKED(FTextureChannelSrc, MipFilter)).ToSharedRef());
+	ChildBuilder.AddProperty(PropertyHandle->GetChildHandle(GET_MEMBER_NAME_CHECKED(FTextureChannelSrc, CoverageThreshold)).ToSharedRef());
+}
+
 bool FTextureChannelSourceCustomization::IsEnabled() const
 {
 	bool Value;
@@ -112,4 +119,5 @@ void FTextureMergeSettingDetail::CustomizeDetails(IDetailLayoutBuilder& DetailBu
 	Category.AddProperty(GET_MEMBER_NAME_CHECKED(UTextureMergeSettings, ReplaceTexture));
 	Category.AddProperty(GET_MEMBER_NAME_CHECKED(UTextureMergeSettings, InputDirectory));
 	Category.AddProperty(GET_MEMBER_NAME_CHECKED(UTextureMergeSettings, bRecursive));
+	Category.AddProperty(GET_MEMBER_NAME_CHECKED(UTextureMergeSettings, Presets));
 }
\ No newline at end of file
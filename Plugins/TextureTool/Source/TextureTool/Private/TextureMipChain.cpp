@@ -0,0 +1,300 @@
+#include "TextureMipChain.h"
+#include "Engine/Texture.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "Math/Float16.h"
+#include "TextureToolStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build Mip Chain"), STAT_TextureTool_BuildMipChain, STATGROUP_TextureTool);
+
+/** Destination rows filtered per task */
+static const int32 MipChainBandRows = 32;
+/** Coverage is matched on a histogram of the channel, exact for 8 bit and close enough for 16 bit */
+static const int32 CoverageBins = 1024;
+/** Kaiser kernel taps per axis, three source texels on each side of the destination texel center */
+static const int32 KaiserTaps = 6;
+
+template<ETextureSourceFormat Format> struct TMipPixel;
+
+template<> struct TMipPixel<TSF_BGRA8>
+{
+	static const int32 Bytes = 4;
+	static FORCEINLINE VectorRegister Load(const uint8* Pixel)
+	{
+		return VectorMultiply(VectorSwizzle(VectorLoadByte4(Pixel), 2, 1, 0, 3), VectorSetFloat1(1.f / 255.f));
+	}
+	static FORCEINLINE void Store(VectorRegister Value, uint8* Pixel)
+	{
+		// Byte stores truncate, so round first
+		Value = VectorMultiplyAdd(VectorMin(VectorMax(Value, VectorZero()), VectorOne()), VectorSetFloat1(255.f), VectorSetFloat1(0.5f));
+		VectorStoreByte4(VectorSwizzle(Value, 2, 1, 0, 3), Pixel);
+	}
+};
+
+template<> struct TMipPixel<TSF_RGBA16>
+{
+	static const int32 Bytes = 8;
+	static FORCEINLINE VectorRegister Load(const uint8* Pixel)
+	{
+		const uint16* P = (const uint16*)Pixel;
+		return VectorMultiply(MakeVectorRegister((float)P[0], (float)P[1], (float)P[2], (float)P[3]), VectorSetFloat1(1.f / 65535.f));
+	}
+	static FORCEINLINE void Store(VectorRegister Value, uint8* Pixel)
+	{
+		float V[4];
+		VectorStore(VectorMultiplyAdd(VectorMin(VectorMax(Value, VectorZero()), VectorOne()), VectorSetFloat1(65535.f), VectorSetFloat1(0.5f)), V);
+		uint16* P = (uint16*)Pixel;
+		for (int32 c = 0; c < 4; ++c)
+			P[c] = (uint16)V[c];
+	}
+};
+
+template<> struct TMipPixel<TSF_RGBA16F>
+{
+	static const int32 Bytes = 8;
+	static FORCEINLINE VectorRegister Load(const uint8* Pixel)
+	{
+		const FFloat16* P = (const FFloat16*)Pixel;
+		return MakeVectorRegister(P[0].GetFloat(), P[1].GetFloat(), P[2].GetFloat(), P[3].GetFloat());
+	}
+	static FORCEINLINE void Store(VectorRegister Value, uint8* Pixel)
+	{
+		float V[4];
+		VectorStore(Value, V);
+		FFloat16* P = (FFloat16*)Pixel;
+		for (int32 c = 0; c < 4; ++c)
+			P[c] = FFloat16(V[c]);
+	}
+};
+
+static float BesselI0(float X)
+{
+	float Sum = 1.f;
+	float Term = 1.f;
+	for (int32 k = 1; k < 16; ++k)
+	{
+		const float Half = X / (2.f * k);
+		Term *= Half * Half;
+		Sum += Term;
+	}
+	return Sum;
+}
+
+/** Normalized weights of a Kaiser windowed sinc halving the resolution, tap i reads source texel 2x - 2 + i */
+static void GetKaiserWeights(float Weights[KaiserTaps])
+{
+	const float Alpha = 4.f;
+	float Total = 0.f;
+	for (int32 i = 0; i < KaiserTaps; ++i)
+	{
+		const float Distance = i - (KaiserTaps / 2 - 0.5f);
+		const float X = Distance * 0.5f;
+		const float Sinc = FMath::Sin(PI * X) / (PI * X);
+		const float T = Distance / (KaiserTaps / 2);
+		Weights[i] = Sinc * BesselI0(Alpha * FMath::Sqrt(FMath::Max(1.f - T * T, 0.f))) / BesselI0(Alpha);
+		Total += Weights[i];
+	}
+	for (int32 i = 0; i < KaiserTaps; ++i)
+		Weights[i] /= Total;
+}
+
+struct FMipFilterMasks
+{
+	VectorRegister Max;
+	VectorRegister Kaiser;
+	bool bAnyMax = false;
+	bool bAnyKaiser = false;
+	float KaiserWeights[KaiserTaps];
+};
+
+template<ETextureSourceFormat Format>
+static void FilterRows(const uint8* Src, int32 SrcX, int32 SrcY, uint8* Dst, int32 DstX, int32 BeginRow, int32 EndRow, const FMipFilterMasks& Masks)
+{
+	typedef TMipPixel<Format> FPixel;
+	const VectorRegister Quarter = VectorSetFloat1(0.25f);
+	auto LoadAt = [&](int32 X, int32 Y) { return FPixel::Load(Src + ((int64)Y * SrcX + X) * FPixel::Bytes); };
+
+	for (int32 y = BeginRow; y < EndRow; ++y)
+	{
+		const int32 Y0 = FMath::Min(2 * y, SrcY - 1);
+		const int32 Y1 = FMath::Min(2 * y + 1, SrcY - 1);
+		uint8* Out = Dst + (int64)y * DstX * FPixel::Bytes;
+		for (int32 x = 0; x < DstX; ++x, Out += FPixel::Bytes)
+		{
+			const int32 X0 = FMath::Min(2 * x, SrcX - 1);
+			const int32 X1 = FMath::Min(2 * x + 1, SrcX - 1);
+			const VectorRegister A = LoadAt(X0, Y0);
+			const VectorRegister B = LoadAt(X1, Y0);
+			const VectorRegister C = LoadAt(X0, Y1);
+			const VectorRegister D = LoadAt(X1, Y1);
+			VectorRegister Result = VectorMultiply(VectorAdd(VectorAdd(A, B), VectorAdd(C, D)), Quarter);
+			if (Masks.bAnyMax)
+				Result = VectorSelect(Masks.Max, VectorMax(VectorMax(A, B), VectorMax(C, D)), Result);
+			if (Masks.bAnyKaiser)
+			{
+				// Sizes are powers of two, the kernel wraps around like a tiling texture
+				VectorRegister Sum = VectorZero();
+				for (int32 j = 0; j < KaiserTaps; ++j)
+				{
+					const int32 SY = (2 * y - KaiserTaps / 2 + 1 + j) & (SrcY - 1);
+					VectorRegister Row = VectorZero();
+					for (int32 i = 0; i < KaiserTaps; ++i)
+						Row = VectorMultiplyAdd(LoadAt((2 * x - KaiserTaps / 2 + 1 + i) & (SrcX - 1), SY), VectorSetFloat1(Masks.KaiserWeights[i]), Row);
+					Sum = VectorMultiplyAdd(Row, VectorSetFloat1(Masks.KaiserWeights[j]), Sum);
+				}
+				Result = VectorSelect(Masks.Kaiser, Sum, Result);
+			}
+			FPixel::Store(Result, Out);
+		}
+	}
+}
+
+template<ETextureSourceFormat Format>
+static void GetHistogram(const uint8* Mip, int64 NumPixels, int32 Channel, TArray<int64>& OutHistogram)
+{
+	typedef TMipPixel<Format> FPixel;
+	const int64 BandPixels = 64 * 1024;
+	const int32 NumBands = (int32)((NumPixels + BandPixels - 1) / BandPixels);
+	TArray<int32> Partials;
+	Partials.SetNumZeroed(NumBands * CoverageBins);
+	ParallelFor(NumBands, [&](int32 Band)
+	{
+		int32* Histogram = &Partials[Band * CoverageBins];
+		const int64 End = FMath::Min(Band * BandPixels + BandPixels, NumPixels);
+		for (int64 Pixel = Band * BandPixels; Pixel < End; ++Pixel)
+		{
+			float V[4];
+			VectorStore(FPixel::Load(Mip + Pixel * FPixel::Bytes), V);
+			++Histogram[FMath::Clamp((int32)(V[Channel] * CoverageBins), 0, CoverageBins - 1)];
+		}
+	});
+	OutHistogram.SetNumZeroed(CoverageBins);
+	for (int32 Band = 0; Band < NumBands; ++Band)
+	{
+		for (int32 Bin = 0; Bin < CoverageBins; ++Bin)
+			OutHistogram[Bin] += Partials[Band * CoverageBins + Bin];
+	}
+}
+
+/** Share of texels at or above the threshold */
+template<ETextureSourceFormat Format>
+static double GetCoverage(const uint8* Mip, int64 NumPixels, int32 Channel, float Threshold)
+{
+	TArray<int64> Histogram;
+	GetHistogram<Format>(Mip, NumPixels, Channel, Histogram);
+	int64 Above = 0;
+	for (int32 Bin = FMath::Clamp((int32)(Threshold * CoverageBins), 0, CoverageBins - 1); Bin < CoverageBins; ++Bin)
+		Above += Histogram[Bin];
+	return (double)Above / NumPixels;
+}
+
+/** Scale the channel so that the same share of texels as in mip 0 passes the threshold */
+template<ETextureSourceFormat Format>
+static void PreserveCoverage(uint8* Mip, int64 NumPixels, int32 Channel, float Threshold, double TargetCoverage)
+{
+	typedef TMipPixel<Format> FPixel;
+	TArray<int64> Histogram;
+	GetHistogram<Format>(Mip, NumPixels, Channel, Histogram);
+	const int64 TargetCount = FMath::Max<int64>((int64)(TargetCoverage * NumPixels + 0.5), 1);
+	int64 Above = 0;
+	int32 Bin = CoverageBins - 1;
+	for (; Bin > 0; --Bin)
+	{
+		Above += Histogram[Bin];
+		if (Above >= TargetCount)
+			break;
+	}
+	// Lowest value which must pass is moved onto the threshold
+	const float Scale = Threshold / (FMath::Max(Bin, 1) / (float)CoverageBins);
+	float Scales[4] = { 1.f, 1.f, 1.f, 1.f };
+	Scales[Channel] = Scale;
+	const VectorRegister ScaleVector = VectorLoad(Scales);
+	const int64 BandPixels = 64 * 1024;
+	ParallelFor((int32)((NumPixels + BandPixels - 1) / BandPixels), [&](int32 Band)
+	{
+		const int64 End = FMath::Min(Band * BandPixels + BandPixels, NumPixels);
+		for (int64 Pixel = Band * BandPixels; Pixel < End; ++Pixel)
+		{
+			uint8* P = Mip + Pixel * FPixel::Bytes;
+			FPixel::Store(VectorMultiply(FPixel::Load(P), ScaleVector), P);
+		}
+	});
+}
+
+template<ETextureSourceFormat Format>
+static void BuildChain(FTextureSource& Source, const EMipFilter Filters[4], const float CoverageThresholds[4])
+{
+	FMipFilterMasks Masks;
+	uint32 MaxMask[4], KaiserMask[4];
+	for (int32 c = 0; c < 4; ++c)
+	{
+		MaxMask[c] = Filters[c] == EMipFilter::Max ? 0xFFFFFFFF : 0;
+		KaiserMask[c] = Filters[c] == EMipFilter::Kaiser ? 0xFFFFFFFF : 0;
+		Masks.bAnyMax |= MaxMask[c] != 0;
+		Masks.bAnyKaiser |= KaiserMask[c] != 0;
+	}
+	Masks.Max = MakeVectorRegister(MaxMask[0], MaxMask[1], MaxMask[2], MaxMask[3]);
+	Masks.Kaiser = MakeVectorRegister(KaiserMask[0], KaiserMask[1], KaiserMask[2], KaiserMask[3]);
+	GetKaiserWeights(Masks.KaiserWeights);
+
+	const int32 NumMips = Source.GetNumMips();
+	TArray<uint8*> Mips;
+	for (int32 Mip = 0; Mip < NumMips; ++Mip)
+		Mips.Add(Source.LockMip(Mip));
+
+	double TargetCoverage[4] = { 0.0, 0.0, 0.0, 0.0 };
+	const int64 NumPixels0 = (int64)Source.GetSizeX() * Source.GetSizeY();
+	for (int32 c = 0; c < 4; ++c)
+	{
+		if (Filters[c] == EMipFilter::Coverage)
+			TargetCoverage[c] = GetCoverage<Format>(Mips[0], NumPixels0, c, CoverageThresholds[c]);
+	}
+
+	for (int32 Mip = 1; Mip < NumMips; ++Mip)
+	{
+		const int32 SrcX = FMath::Max(Source.GetSizeX() >> (Mip - 1), 1);
+		const int32 SrcY = FMath::Max(Source.GetSizeY() >> (Mip - 1), 1);
+		const int32 DstX = FMath::Max(SrcX >> 1, 1);
+		const int32 DstY = FMath::Max(SrcY >> 1, 1);
+		ParallelFor((DstY + MipChainBandRows - 1) / MipChainBandRows, [&](int32 Band)
+		{
+			FilterRows<Format>(Mips[Mip - 1], SrcX, SrcY, Mips[Mip], DstX, Band * MipChainBandRows, FMath::Min(Band * MipChainBandRows + MipChainBandRows, DstY), Masks);
+		});
+		for (int32 c = 0; c < 4; ++c)
+		{
+			// Nothing passed the test in mip 0, there is no coverage to keep
+			if (Filters[c] == EMipFilter::Coverage && TargetCoverage[c] > 0.0)
+				PreserveCoverage<Format>(Mips[Mip], (int64)DstX * DstY, c, CoverageThresholds[c], TargetCoverage[c]);
+		}
+	}
+
+	for (int32 Mip = 0; Mip < NumMips; ++Mip)
+		Source.UnlockMip(Mip);
+}
+
+int32 FTextureMipChain::GetNumMips(int32 SizeX, int32 SizeY)
+{
+	return FMath::FloorLog2(FMath::Max(FMath::Max(SizeX, SizeY), 1)) + 1;
+}
+
+bool FTextureMipChain::NeedsMipChain(const EMipFilter Filters[4])
+{
+	for (int32 c = 0; c < 4; ++c)
+	{
+		if (Filters[c] != EMipFilter::Default)
+			return true;
+	}
+	return false;
+}
+
+bool FTextureMipChain::Build(FTextureSource& Source, const EMipFilter Filters[4], const float CoverageThresholds[4])
+{
+	SCOPE_CYCLE_COUNTER(STAT_TextureTool_BuildMipChain);
+	switch (Source.GetFormat())
+	{
+	case TSF_BGRA8: BuildChain<TSF_BGRA8>(Source, Filters, CoverageThresholds); return true;
+	case TSF_RGBA16: BuildChain<TSF_RGBA16>(Source, Filters, CoverageThresholds); return true;
+	case TSF_RGBA16F: BuildChain<TSF_RGBA16F>(Source, Filters, CoverageThresholds); return true;
+	default: return false;
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "SettingObjects.h"
+
+class FTextureSource;
+
+/**
+ * Builds the mip chain of a merged texture source with one filter per channel.
+ * Each mip is filtered from the previous one, rows are split across tasks and
+ * the four channels of a texel are filtered together in one vector register.
+ */
+struct TEXTURETOOL_API FTextureMipChain
+{
+	/** Mips of a full chain for a source of this size */
+	static int32 GetNumMips(int32 SizeX, int32 SizeY);
+	/** True when a filter asks for a merge built chain instead of the texture build one */
+	static bool NeedsMipChain(const EMipFilter Filters[4]);
+	/** Source must be BGRA8, RGBA16 or RGBA16F with every mip allocated and mip 0 filled */
+	static bool Build(FTextureSource& Source, const EMipFilter Filters[4], const float CoverageThresholds[4]);
+};
@@ -0,0 +1,167 @@
+#include "TexturePackingPlanner.h"
+#include "TextureChannelAnalyzer.h"
+#include "TextureUtils.h"
+#include "TextureTiledMerge.h"
+#include "TextureMipChain.h"
+#include "TextureBatchEstimator.h"
+#include "SettingObjects.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInterface.h"
+#include "Materials/MaterialExpressionTextureSample.h"
+#include "Materials/MaterialExpressionTextureSampleParameter.h"
+
+void FTexturePackingProposal::ApplyTo(UTextureMergeSettings* Settings) const
+{
+	FTextureChannelSrc* Channels[] = { &Settings->R, &Settings->G, &Settings->B, &Settings->A };
+	for (int32 i = 0; i < 4; ++i)
+	{
+		UTexture2D* Texture = Textures.IsValidIndex(i) ? Textures[i].Get() : nullptr;
+		// Single channel sources hold their data in R
+		Channels[i]->Texture = Texture;
+		Channels[i]->Channel = EChannel::R;
+		Channels[i]->Optional = Texture != nullptr;
+	}
+	Settings->ReplaceTexture.Optional = false;
+}
+
+/** Format of the texture Merge makes from Sources with the current settings, ApplyTo reads every source from R */
+static EPixelFormat GetPackedPixelFormat(const UTextureMergeSettings* Settings, UTexture2D* const Sources[4])
+{
+	const FTextureChannelSrc* SettingsChannels[4] = { &Settings->R, &Settings->G, &Settings->B, &Settings->A };
+	EMipFilter MipFilters[4];
+	FTextureChannelSrc Channels[4];
+	const FTextureChannelSrc* ChannelPtrs[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		MipFilters[i] = SettingsChannels[i]->MipFilter;
+		Channels[i].Channel = EChannel::R;
+		ChannelPtrs[i] = &Channels[i];
+	}
+	// The GPU merge constructs its output from an RGBA16F render target
+	if (Settings->bMergeOnGPU && !FTextureMipChain::NeedsMipChain(MipFilters))
+		return PF_FloatRGBA;
+	const ETextureSourceFormat Format = FTextureTiledMerge::GetOutputFormat(Sources, ChannelPtrs);
+	return FTextureBatchEstimator::GetOutputPixelFormat(TC_Default, Format == TSF_RGBA16F, Format == TSF_RGBA16, Sources[3] != nullptr);
+}
+
+void FTexturePackingPlanner::Plan(UWorld* World, TArray<FTexturePackingProposal>& OutProposals)
+{
+	TSet<UMaterialInterface*> Materials;
+	for (AActor* Actor : FActorRange(World))
+	{
+		for (UMaterialInterface* Material : FTextureToolUtils::FindMaterials(Actor))
+			Materials.Add(Material);
+	}
+	Plan(Materials.Array(), OutProposals);
+}
+
+void FTexturePackingPlanner::Plan(const TArray<UMaterialInterface*>& Materials, TArray<FTexturePackingProposal>& OutProposals)
+{
+	// A sampling site is a material sampling with a given UV input, textures sharing all their sites can share a sampler
+	TMap<FString, int32> SiteIndices;
+	TMap<UTexture2D*, TArray<int32>> SitesByTexture;
+	for (UMaterialInterface* Material : Materials)
+	{
+		UMaterial* BaseMaterial = Material->GetMaterial();
+		if (!BaseMaterial)
+			continue;
+
+		// Only textures the compiled material really uses, unconnected expressions don't count
+		TArray<UTexture*> UsedTextures;
+		Material->GetUsedTextures(UsedTextures, EMaterialQualityLevel::Num, false, GMaxRHIFeatureLevel, false);
+
+		for (UMaterialExpression* Expression : BaseMaterial->Expressions)
+		{
+			UMaterialExpressionTextureSample* Sample = Cast<UMaterialExpressionTextureSample>(Expression);
+			if (!Sample)
+				continue;
+
+			UTexture* Texture = Sample->Texture;
+			if (UMaterialExpressionTextureSampleParameter* Parameter = Cast<UMaterialExpressionTextureSampleParameter>(Sample))
+				Material->GetTextureParameterValue(FMaterialParameterInfo(Parameter->ParameterName), Texture);
+			UTexture2D* Texture2D = Cast<UTexture2D>(Texture);
+			if (!Texture2D || !UsedTextures.Contains(Texture2D))
+				continue;
+
+			const FString Site = FString::Printf(TEXT("%s|%p|%d|%d"), *Material->GetPathName(), Sample->Coordinates.Expression, Sample->Coordinates.OutputIndex, Sample->ConstCoordinate);
+			int32 SiteIndex = SiteIndices.FindOrAdd(Site, SiteIndices.Num());
+			SitesByTexture.FindOrAdd(Texture2D).AddUnique(SiteIndex);
+		}
+	}
+
+	// Single channel candidates, the cheap format checks first and channel analysis for the rest
+	TArray<UTexture2D*> Candidates;
+	TArray<UTexture2D*> ToAnalyze;
+	for (auto& Pair : SitesByTexture)
+	{
+		UTexture2D* Texture = Pair.Key;
+		if (Texture->Source.GetFormat() == TSF_G8 || Texture->CompressionSettings == TC_Grayscale
+			|| Texture->CompressionSettings == TC_Alpha || Texture->CompressionSettings == TC_Displacementmap)
+			Candidates.Add(Texture);
+		else
+			ToAnalyze.Add(Texture);
+	}
+	TArray<FTextureChannelReport> Reports;
+	TArray<bool> Valid;
+	FTextureChannelAnalyzer::Analyze(ToAnalyze, Reports, Valid);
+	for (int32 i = 0; i < ToAnalyze.Num(); ++i)
+	{
+		// Identical RGB and nothing meaningful in alpha
+		if (Valid[i] && Reports[i].bGrayscale && (Reports[i].bUnusedAlpha || !ToAnalyze[i]->HasAlphaChannel()))
+			Candidates.Add(ToAnalyze[i]);
+	}
+
+	const UTextureMergeSettings* Settings = UTextureMergeSettings::Get();
+	// Textures sampled at exactly the same sites, and of the same size so MergeTextures accepts them
+	TMap<FString, TArray<UTexture2D*>> Buckets;
+	for (UTexture2D* Texture : Candidates)
+	{
+		TArray<int32>& Sites = SitesByTexture[Texture];
+		Sites.Sort();
+		FString Key = FString::Printf(TEXT("%dx%d"), Texture->Source.GetSizeX(), Texture->Source.GetSizeY());
+		for (int32 Site : Sites)
+			Key += FString::Printf(TEXT(",%d"), Site);
+		Buckets.FindOrAdd(Key).Add(Texture);
+	}
+
+	for (auto& Pair : Buckets)
+	{
+		TArray<UTexture2D*>& Group = Pair.Value;
+		if (Group.Num() < 2)
+			continue;
+		Group.Sort([](const UTexture2D& A, const UTexture2D& B) { return A.GetName() < B.GetName(); });
+		const int32 NumSites = SitesByTexture[Group[0]].Num();
+
+		for (int32 Start = 0; Start + 1 < Group.Num(); Start += 4)
+		{
+			const int32 Num = FMath::Min(4, Group.Num() - Start);
+			if (Num < 2)
+				break;
+			FTexturePackingProposal& Proposal = OutProposals.AddDefaulted_GetRef();
+			Proposal.NumSamplingSites = NumSites;
+			Proposal.SamplersSaved = (Num - 1) * NumSites;
+
+			int64 CurrentBytes = 0;
+			UTexture2D* Sources[4] = { nullptr, nullptr, nullptr, nullptr };
+			for (int32 i = Start; i < Start + Num; ++i)
+			{
+				Proposal.Textures.Add(Group[i]);
+				Sources[i - Start] = Group[i];
+				CurrentBytes += Group[i]->CalcTextureMemorySizeEnum(TMC_AllMips);
+			}
+			// Full mip chain in the format the merge really produces, an RGBA16F output can cost more than the sources
+			const FIntPoint Size(Group[Start]->Source.GetSizeX(), Group[Start]->Source.GetSizeY());
+			Proposal.BytesSaved = CurrentBytes - FTextureToolUtils::EstimateBytes(Size, GetPackedPixelFormat(Settings, Sources));
+		}
+	}
+
+	OutProposals.Sort([](const FTexturePackingProposal& A, const FTexturePackingProposal& B)
+	{
+		if (A.SamplersSaved != B.SamplersSaved)
+			return A.SamplersSaved > B.SamplersSaved;
+		return A.BytesSaved > B.BytesSaved;
+	});
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UTexture2D;
+class UWorld;
+class UMaterialInterface;
+class UTextureMergeSettings;
+
+/** Single channel textures always sampled together with the same UVs, which can be packed into one texture */
+struct FTexturePackingProposal
+{
+	/** At most four textures, in R, G, B, A order */
+	TArray<TWeakObjectPtr<UTexture2D>> Textures;
+	/** Material and UV combinations sampling the whole group */
+	int32 NumSamplingSites = 0;
+	int32 SamplersSaved = 0;
+	/** Negative when the packed output, in the format Merge produces, is larger than the sources */
+	int64 BytesSaved = 0;
+
+	/** Fill merge settings with the group, so it can be run with Merge */
+	void ApplyTo(UTextureMergeSettings* Settings) const;
+};
+
+/** Proposes channel packing groups from how materials sample their textures */
+struct FTexturePackingPlanner
+{
+	/** Plan from the materials used by every actor of the world, same discovery as the Finder */
+	static void Plan(UWorld* World, TArray<FTexturePackingProposal>& OutProposals);
+	/** Proposals ranked by samplers saved, then by memory saved */
+	static void Plan(const TArray<UMaterialInterface*>& Materials, TArray<FTexturePackingProposal>& OutProposals);
+};
@@ -0,0 +1,159 @@
+#include "TextureSelectionTracker.h"
+#include "TextureUtils.h"
+#include "Editor.h"
+#include "Engine/Selection.h"
+#include "Engine/Texture2D.h"
+#include "GameFramework/Actor.h"
+#include "Components/MeshComponent.h"
+#include "Components/DecalComponent.h"
+#include "UObject/UObjectGlobals.h"
+
+FTextureSelectionTracker& FTextureSelectionTracker::Get()
+{
+	static FTextureSelectionTracker Tracker;
+	return Tracker;
+}
+
+void FTextureSelectionTracker::InstallHooks()
+{
+	SelectionChangedHandle = USelection::SelectionChangedEvent.AddRaw(this, &FTextureSelectionTracker::OnSelectionChanged);
+	SelectObjectHandle = USelection::SelectObjectEvent.AddRaw(this, &FTextureSelectionTracker::OnSelectObject);
+	SelectNoneHandle = USelection::SelectNoneEvent.AddRaw(this, &FTextureSelectionTracker::OnSelectNone);
+	PropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddRaw(this, &FTextureSelectionTracker::OnObjectPropertyChanged);
+	SyncWithSelection();
+}
+
+void FTextureSelectionTracker::RemoveHooks()
+{
+	USelection::SelectionChangedEvent.Remove(SelectionChangedHandle);
+	USelection::SelectObjectEvent.Remove(SelectObjectHandle);
+	USelection::SelectNoneEvent.Remove(SelectNoneHandle);
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PropertyChangedHandle);
+	Reset();
+}
+
+TArray<UTexture2D*> FTextureSelectionTracker::GetTextures() const
+{
+	TArray<UTexture2D*> Textures;
+	Textures.Reserve(TextureRefCounts.Num());
+	for (auto& Pair : TextureRefCounts)
+	{
+		if (UTexture2D* Texture = Pair.Key.Get())
+			Textures.Add(Texture);
+	}
+	return Textures;
+}
+
+void FTextureSelectionTracker::OnSelectionChanged(UObject* Object)
+{
+	// Batched operations don't notify per object, and may swap the selection for as many other actors
+	USelection* Selection = GEditor ? GEditor->GetSelectedActors() : nullptr;
+	if (Object == Selection)
+		SyncWithSelection();
+}
+
+void FTextureSelectionTracker::OnSelectObject(UObject* Object)
+{
+	AActor* Actor = Cast<AActor>(Object);
+	if (!Actor)
+		return;
+	if (Actor->IsSelected())
+		AddActor(Actor);
+	else
+		RemoveActor(Actor);
+}
+
+void FTextureSelectionTracker::OnSelectNone()
+{
+	Reset();
+}
+
+void FTextureSelectionTracker::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& Event)
+{
+	// Material changes on a selected actor or its components invalidate that actor only
+	AActor* Actor = Cast<AActor>(Object);
+	if (!Actor)
+	{
+		if (UActorComponent* Component = Cast<UActorComponent>(Object))
+			Actor = Component->GetOwner();
+	}
+	if (Actor && Actors.Contains(Actor))
+	{
+		RemoveActor(Actor);
+		AddActor(Actor);
+	}
+}
+
+void FTextureSelectionTracker::AddActor(AActor* Actor)
+{
+	if (Actors.Contains(Actor))
+		return;
+
+	FActorEntry& Entry = Actors.Add(Actor);
+	for (UActorComponent* Component : Actor->GetComponents())
+	{
+		if (Component && (Component->IsA(UMeshComponent::StaticClass()) || Component->IsA(UDecalComponent::StaticClass())))
+		{
+			Entry.bHasMaterial = true;
+			break;
+		}
+	}
+	if (Entry.bHasMaterial)
+	{
+		++NumActorsWithMaterial;
+		for (UTexture2D* Texture : FTextureToolUtils::FindTextures(Actor))
+		{
+			// FindTextures reports a texture once per material using it
+			if (Entry.Textures.Contains(Texture))
+				continue;
+			Entry.Textures.Add(Texture);
+			++TextureRefCounts.FindOrAdd(Texture);
+		}
+	}
+}
+
+void FTextureSelectionTracker::RemoveActor(const TWeakObjectPtr<AActor>& Actor)
+{
+	FActorEntry Entry;
+	if (!Actors.RemoveAndCopyValue(Actor, Entry))
+		return;
+
+	if (Entry.bHasMaterial)
+		--NumActorsWithMaterial;
+	for (auto& Texture : Entry.Textures)
+	{
+		int32* Count = TextureRefCounts.Find(Texture);
+		if (Count && --(*Count) <= 0)
+			TextureRefCounts.Remove(Texture);
+	}
+}
+
+void FTextureSelectionTracker::SyncWithSelection()
+{
+	if (!GEditor)
+		return;
+
+	// Destroyed actors leave stale keys, they are removed like deselected ones
+	TArray<TWeakObjectPtr<AActor>> ToRemove;
+	for (auto& Pair : Actors)
+	{
+		AActor* Actor = Pair.Key.Get();
+		if (!Actor || !Actor->IsSelected())
+			ToRemove.Add(Pair.Key);
+	}
+	for (const TWeakObjectPtr<AActor>& Actor : ToRemove)
+		RemoveActor(Actor);
+
+	for (FSelectionIterator It(*GEditor->GetSelectedActors()); It; ++It)
+	{
+		if (AActor* Actor = Cast<AActor>(*It))
+			AddActor(Actor);
+	}
+}
+
+void FTextureSelectionTracker::Reset()
+{
+	Actors.Reset();
+	TextureRefCounts.Reset();
+	NumActorsWithMaterial = 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class AActor;
+class UTexture2D;
+class UObject;
+struct FPropertyChangedEvent;
+
+/**
+ * Keeps the textures used by the selected actors up to date as the editor selection changes.
+ * Only actors entering or leaving the selection are processed, so the level editor menu and
+ * the Finder can query the current selection without walking every component again.
+ */
+class FTextureSelectionTracker
+{
+public:
+	static FTextureSelectionTracker& Get();
+
+	void InstallHooks();
+	void RemoveHooks();
+
+	/** Any selected actor has a mesh or decal component */
+	bool HasActorWithMaterial() const { return NumActorsWithMaterial > 0; }
+	/** Textures used by the selected actors, each texture once */
+	TArray<UTexture2D*> GetTextures() const;
+
+private:
+	struct FActorEntry
+	{
+		TArray<TWeakObjectPtr<UTexture2D>> Textures;
+		bool bHasMaterial = false;
+	};
+
+	void OnSelectionChanged(UObject* Object);
+	void OnSelectObject(UObject* Object);
+	void OnSelectNone();
+	void OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& Event);
+	void AddActor(AActor* Actor);
+	/** Takes the tracked key so destroyed actors can be removed too */
+	void RemoveActor(const TWeakObjectPtr<AActor>& Actor);
+	/** Diff the tracked actors against the whole selection, only actors that entered or left it are processed */
+	void SyncWithSelection();
+	void Reset();
+
+	TMap<TWeakObjectPtr<AActor>, FActorEntry> Actors;
+	TMap<TWeakObjectPtr<UTexture2D>, int32> TextureRefCounts;
+	int32 NumActorsWithMaterial = 0;
+
+	FDelegateHandle SelectionChangedHandle;
+	FDelegateHandle SelectObjectHandle;
+	FDelegateHandle SelectNoneHandle;
+	FDelegateHandle PropertyChangedHandle;
+};
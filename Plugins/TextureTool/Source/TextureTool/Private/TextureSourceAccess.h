@@ -0,0 +1,77 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Math/Float16.h"
+#include "Engine/Texture.h"
+
+/** Format agnostic helpers to read FTextureSource mip data */
+struct FTextureSourceAccess
+{
+	static FIntPoint GetMipSize(const FTextureSource& Source, int32 MipIndex)
+	{
+		return FIntPoint(FMath::Max(Source.GetSizeX() >> MipIndex, 1), FMath::Max(Source.GetSizeY() >> MipIndex, 1));
+	}
+
+	/** Smallest mip whose largest side is still at least MinSize, or the last mip if all are smaller */
+	static int32 GetSmallestMipAtLeast(const FTextureSource& Source, int32 MinSize)
+	{
+		int32 MipIndex = 0;
+		while (MipIndex + 1 < Source.GetNumMips())
+		{
+			FIntPoint Next = GetMipSize(Source, MipIndex + 1);
+			if (FMath::Max(Next.X, Next.Y) < MinSize)
+				break;
+			++MipIndex;
+		}
+		return MipIndex;
+	}
+
+	static bool IsSupportedFormat(ETextureSourceFormat Format)
+	{
+		switch (Format)
+		{
+		case TSF_G8:
+		case TSF_BGRA8:
+		case TSF_BGRE8:
+		case TSF_RGBA16:
+		case TSF_RGBA16F:
+		case TSF_RGBA8:
+		case TSF_RGBE8:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	/** Decode one pixel to RGBA, 8 and 16 bit integer formats are normalized to [0, 1] */
+	static FLinearColor DecodePixel(const uint8* Pixel, ETextureSourceFormat Format)
+	{
+		switch (Format)
+		{
+		case TSF_G8:
+		{
+			float V = Pixel[0] / 255.f;
+			return FLinearColor(V, V, V, 1.f);
+		}
+		case TSF_BGRA8:
+			return FLinearColor(Pixel[2] / 255.f, Pixel[1] / 255.f, Pixel[0] / 255.f, Pixel[3] / 255.f);
+		case TSF_RGBA8:
+			return FLinearColor(Pixel[0] / 255.f, Pixel[1] / 255.f, Pixel[2] / 255.f, Pixel[3] / 255.f);
+		case TSF_BGRE8:
+			return FColor(Pixel[2], Pixel[1], Pixel[0], Pixel[3]).FromRGBE();
+		case TSF_RGBE8:
+			return FColor(Pixel[0], Pixel[1], Pixel[2], Pixel[3]).FromRGBE();
+		case TSF_RGBA16:
+		{
+			const uint16* P = (const uint16*)Pixel;
+			return FLinearColor(P[0] / 65535.f, P[1] / 65535.f, P[2] / 65535.f, P[3] / 65535.f);
+		}
+		case TSF_RGBA16F:
+		{
+			const FFloat16* P = (const FFloat16*)Pixel;
+			return FLinearColor(P[0].GetFloat(), P[1].GetFloat(), P[2].GetFloat(), P[3].GetFloat());
+		}
+		default:
+			return FLinearColor::Black;
+		}
+	}
+};
@@ -0,0 +1,222 @@
+#include "TextureThumbnailCache.h"
+#include "TextureSourceAccess.h"
+#include "Engine/Texture2D.h"
+#include "Brushes/SlateDynamicImageBrush.h"
+#include "EditorStyleSet.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+
+/** Thumbnails rendered concurrently, keeps the thread pool free for texture builds */
+static const int32 MaxRunningThumbnailJobs = 4;
+
+FTextureThumbnailCache::FTextureThumbnailCache(int32 InThumbnailSize, int32 InCapacity)
+	: ThumbnailSize(InThumbnailSize)
+	, Capacity(InCapacity)
+{
+	// Must be loaded on game thread, workers only receive the pointer
+	ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	PlaceholderBrush = FEditorStyle::GetBrush("ClassThumbnail.Texture2D");
+}
+
+FTextureThumbnailCache::~FTextureThumbnailCache()
+{
+	Empty();
+}
+
+const FSlateBrush* FTextureThumbnailCache::GetBrush(const TSoftObjectPtr<UTexture2D>& Texture)
+{
+	const FSoftObjectPath& Path = Texture.ToSoftObjectPath();
+	FEntry& Entry = Touch(Path);
+	if (Entry.Brush.IsValid())
+		return Entry.Brush.Get();
+	if (!Entry.Job.IsValid() && !Entry.bQueued && !Entry.bFailed)
+		Request(Path, true);
+	return PlaceholderBrush;
+}
+
+void FTextureThumbnailCache::Prefetch(const TSoftObjectPtr<UTexture2D>& Texture)
+{
+	const FSoftObjectPath& Path = Texture.ToSoftObjectPath();
+	FEntry& Entry = Touch(Path);
+	if (!Entry.Brush.IsValid() && !Entry.Job.IsValid() && !Entry.bQueued && !Entry.bFailed)
+		Request(Path, false);
+}
+
+void FTextureThumbnailCache::SetCapacity(int32 InCapacity)
+{
+	Capacity = FMath::Max(InCapacity, 1);
+}
+
+FTextureThumbnailCache::FEntry& FTextureThumbnailCache::Touch(const FSoftObjectPath& Path)
+{
+	FEntry& Entry = Entries.FindOrAdd(Path);
+	Entry.LastUsed = ++UseCounter;
+	return Entry;
+}
+
+void FTextureThumbnailCache::Request(const FSoftObjectPath& Path, bool bHighPriority)
+{
+	Entries[Path].bQueued = true;
+	if (bHighPriority)
+		VisibleQueue.Add(Path);
+	else
+		PrefetchQueue.Add(Path);
+}
+
+void FTextureThumbnailCache::Tick()
+{
+	for (auto& Pair : Entries)
+	{
+		FEntry& Entry = Pair.Value;
+		if (!Entry.Job.IsValid() || !Entry.Job->bDone)
+			continue;
+
+		if (Entry.Job->Pixels.Num() > 0)
+		{
+			FName BrushName(*FString::Printf(TEXT("TextureToolThumbnail_%u"), ++BrushCounter));
+			Entry.Brush = FSlateDynamicImageBrush::CreateWithImageData(BrushName, FVector2D(Entry.Job->Size), Entry.Job->Pixels);
+		}
+		Entry.bFailed = !Entry.Brush.IsValid();
+		Entry.Job.Reset();
+		--RunningJobs;
+	}
+
+	while (RunningJobs < MaxRunningThumbnailJobs && (VisibleQueue.Num() > 0 || PrefetchQueue.Num() > 0))
+	{
+		FSoftObjectPath Path = VisibleQueue.Num() > 0 ? VisibleQueue.Pop(false) : PrefetchQueue.Pop(false);
+		FEntry* Entry = Entries.Find(Path);
+		if (!Entry)
+			continue;
+		Entry->bQueued = false;
+		if (!Entry->Brush.IsValid() && !Entry->Job.IsValid())
+			StartJob(Path, *Entry);
+	}
+
+	Evict();
+}
+
+void FTextureThumbnailCache::StartJob(const FSoftObjectPath& Path, FEntry& Entry)
+{
+	// Finder only lists textures referenced by the level, never load anything here
+	UTexture2D* Texture = Cast<UTexture2D>(Path.ResolveObject());
+	if (!Texture || !FTextureSourceAccess::IsSupportedFormat(Texture->Source.GetFormat()))
+	{
+		Entry.bFailed = true;
+		return;
+	}
+
+	// The source may be edited or collected while the job runs, so the worker only sees a copy.
+	// A PNG source is copied compressed, the worker picks its mip and decodes it. An uncompressed mip is copied from the bulk data
+	FTextureSource& Source = Texture->Source;
+	const ETextureSourceFormat Format = Source.GetFormat();
+	const int32 BytesPerPixel = Source.GetBytesPerPixel();
+	TSharedPtr<FTextureSource, ESPMode::ThreadSafe> CompressedSource;
+	TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> CopiedMip = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+	FIntPoint CopiedMipSize = FIntPoint::ZeroValue;
+	if (Source.IsPNGCompressed())
+	{
+		CompressedSource = MakeShared<FTextureSource, ESPMode::ThreadSafe>(Source);
+	}
+	else
+	{
+		const int32 MipIndex = FTextureSourceAccess::GetSmallestMipAtLeast(Source, ThumbnailSize);
+		CopiedMipSize = FTextureSourceAccess::GetMipSize(Source, MipIndex);
+		if (const uint8* Locked = Source.LockMip(MipIndex))
+			CopiedMip->Append(Locked, CopiedMipSize.X * CopiedMipSize.Y * BytesPerPixel);
+		Source.UnlockMip(MipIndex);
+		if (CopiedMip->Num() == 0)
+		{
+			Entry.bFailed = true;
+			return;
+		}
+	}
+
+	Entry.Job = MakeShared<FThumbnailJob, ESPMode::ThreadSafe>();
+	++RunningJobs;
+
+	TSharedPtr<FThumbnailJob, ESPMode::ThreadSafe> Job = Entry.Job;
+	const int32 TargetSize = ThumbnailSize;
+	IImageWrapperModule* ImageWrapper = ImageWrapperModule;
+	Job->Task = FFunctionGraphTask::CreateAndDispatchWhenReady([Job, CompressedSource, CopiedMip, CopiedMipSize, Format, BytesPerPixel, TargetSize, ImageWrapper]()
+	{
+		TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> MipData = CopiedMip;
+		FIntPoint MipSize = CopiedMipSize;
+		if (CompressedSource.IsValid())
+		{
+			const int32 MipIndex = FTextureSourceAccess::GetSmallestMipAtLeast(*CompressedSource, TargetSize);
+			MipSize = FTextureSourceAccess::GetMipSize(*CompressedSource, MipIndex);
+			CompressedSource->GetMipData(*MipData, MipIndex, ImageWrapper);
+		}
+		// Left without pixels, Tick marks the entry failed
+		if (MipData->Num() < MipSize.X * MipSize.Y * BytesPerPixel)
+		{
+			Job->bDone = true;
+			return;
+		}
+
+		// Fit into the thumbnail keeping aspect ratio
+		const float Scale = FMath::Min(1.f, (float)TargetSize / FMath::Max(MipSize.X, MipSize.Y));
+		const FIntPoint Size(FMath::Max(FMath::RoundToInt(MipSize.X * Scale), 1), FMath::Max(FMath::RoundToInt(MipSize.Y * Scale), 1));
+		const bool bHDR = Format == TSF_RGBA16F || Format == TSF_BGRE8 || Format == TSF_RGBE8;
+		// Up to 4x4 samples per thumbnail pixel is plenty and keeps huge single mip sources cheap
+		const int32 SamplesX = FMath::Clamp(MipSize.X / Size.X, 1, 4);
+		const int32 SamplesY = FMath::Clamp(MipSize.Y / Size.Y, 1, 4);
+
+		Job->Pixels.SetNumUninitialized(Size.X * Size.Y * 4);
+		FColor* Dest = (FColor*)Job->Pixels.GetData();
+		for (int32 Y = 0; Y < Size.Y; ++Y)
+		{
+			for (int32 X = 0; X < Size.X; ++X)
+			{
+				FLinearColor Sum = FLinearColor::Transparent;
+				for (int32 SY = 0; SY < SamplesY; ++SY)
+				{
+					for (int32 SX = 0; SX < SamplesX; ++SX)
+					{
+						int32 PX = FMath::Min(((X * SamplesX + SX) * MipSize.X) / (Size.X * SamplesX), MipSize.X - 1);
+						int32 PY = FMath::Min(((Y * SamplesY + SY) * MipSize.Y) / (Size.Y * SamplesY), MipSize.Y - 1);
+						Sum += FTextureSourceAccess::DecodePixel(&(*MipData)[(PY * MipSize.X + PX) * BytesPerPixel], Format);
+					}
+				}
+				Sum /= (float)(SamplesX * SamplesY);
+				// Slate brushes are BGRA which is FColor's memory layout
+				Dest[Y * Size.X + X] = Sum.ToFColor(bHDR);
+			}
+		}
+		Job->Size = Size;
+		Job->bDone = true;
+	}, TStatId(), nullptr, ENamedThreads::AnyBackgroundThreadNormalTask);
+}
+
+void FTextureThumbnailCache::Evict()
+{
+	if (Entries.Num() <= Capacity)
+		return;
+
+	TArray<TPair<uint64, FSoftObjectPath>> Candidates;
+	for (auto& Pair : Entries)
+	{
+		// In flight jobs are collected first, their brush would be lost
+		if (!Pair.Value.Job.IsValid())
+			Candidates.Emplace(Pair.Value.LastUsed, Pair.Key);
+	}
+	Candidates.Sort([](const TPair<uint64, FSoftObjectPath>& A, const TPair<uint64, FSoftObjectPath>& B) { return A.Key < B.Key; });
+
+	int32 ToEvict = FMath::Min(Entries.Num() - Capacity, Candidates.Num());
+	for (int32 i = 0; i < ToEvict; ++i)
+		Entries.Remove(Candidates[i].Value);
+}
+
+void FTextureThumbnailCache::Empty()
+{
+	// Jobs only touch their own copy, but must not outlive the module their code lives in
+	for (auto& Pair : Entries)
+	{
+		if (Pair.Value.Job.IsValid() && Pair.Value.Job->Task.IsValid())
+			FTaskGraphInterface::Get().WaitUntilTaskCompletes(Pair.Value.Job->Task);
+	}
+	Entries.Empty();
+	VisibleQueue.Empty();
+	PrefetchQueue.Empty();
+	RunningJobs = 0;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPtr.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Async/TaskGraphInterfaces.h"
+
+class UTexture2D;
+class IImageWrapperModule;
+struct FSlateBrush;
+struct FSlateDynamicImageBrush;
+
+/**
+ * LRU cache of Finder thumbnails.
+ * Source data is copied on game thread, compressed for PNG sources, and the smallest mip that still covers the
+ * thumbnail size is decoded and downsampled on a background thread. A placeholder brush is returned until they are ready.
+ */
+class FTextureThumbnailCache
+{
+public:
+	FTextureThumbnailCache(int32 InThumbnailSize, int32 InCapacity);
+	~FTextureThumbnailCache();
+
+	/** Brush to draw for the texture, requests the thumbnail with high priority if it is not cached */
+	const FSlateBrush* GetBrush(const TSoftObjectPtr<UTexture2D>& Texture);
+	/** Request the thumbnail of a texture that is about to be visible */
+	void Prefetch(const TSoftObjectPtr<UTexture2D>& Texture);
+	/** Number of thumbnails kept alive, should cover the visible window plus the prefetch margin */
+	void SetCapacity(int32 InCapacity);
+	/** Collect finished thumbnails, start pending ones and evict least recently used, game thread only */
+	void Tick();
+	void Empty();
+
+private:
+	struct FThumbnailJob
+	{
+		TArray<uint8> Pixels;
+		FIntPoint Size = FIntPoint::ZeroValue;
+		FThreadSafeBool bDone;
+		FGraphEventRef Task;
+	};
+
+	struct FEntry
+	{
+		TSharedPtr<FSlateDynamicImageBrush> Brush;
+		TSharedPtr<FThumbnailJob, ESPMode::ThreadSafe> Job;
+		uint64 LastUsed = 0;
+		bool bQueued = false;
+		bool bFailed = false;
+	};
+
+	FEntry& Touch(const FSoftObjectPath& Path);
+	void Request(const FSoftObjectPath& Path, bool bHighPriority);
+	void StartJob(const FSoftObjectPath& Path, FEntry& Entry);
+	void Evict();
+
+	TMap<FSoftObjectPath, FEntry> Entries;
+	/** Both popped from the back, visible thumbnails before prefetched ones */
+	TArray<FSoftObjectPath> VisibleQueue;
+	TArray<FSoftObjectPath> PrefetchQueue;
+	IImageWrapperModule* ImageWrapperModule;
+	const FSlateBrush* PlaceholderBrush;
+	int32 ThumbnailSize;
+	int32 Capacity;
+	int32 RunningJobs = 0;
+	uint64 UseCounter = 0;
+	uint32 BrushCounter = 0;
+};
@@ -0,0 +1,270 @@
+#include "TextureTiledMerge.h"
+#include "TextureSourceAccess.h"
+#include "TextureMipChain.h"
+#include "TextureToolStats.h"
+#include "Engine/Texture2D.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+#include "Async/ParallelFor.h"
+#define LOCTEXT_NAMESPACE "TextureToolUI"
+
+DECLARE_CYCLE_STAT(TEXT("Tiled Merge Decode"), STAT_TextureTool_TiledMergeDecode, STATGROUP_TextureTool);
+DECLARE_CYCLE_STAT(TEXT("Tiled Merge Copy"), STAT_TextureTool_TiledMergeCopy, STATGROUP_TextureTool);
+
+/** Output channels are RGBA, BGRA8 stores them in another order */
+static const int32 BGRA8Offsets[4] = { 2, 1, 0, 3 };
+
+static bool Is8Bit(ETextureSourceFormat Format)
+{
+	return Format == TSF_G8 || Format == TSF_BGRA8 || Format == TSF_RGBA8;
+}
+
+/** Byte holding Channel in an 8 bit source, G8 has no alpha */
+static int32 Get8BitOffset(ETextureSourceFormat Format, int32 Channel)
+{
+	if (Format == TSF_G8)
+		return Channel == 3 ? INDEX_NONE : 0;
+	return Format == TSF_BGRA8 ? BGRA8Offsets[Channel] : Channel;
+}
+
+/** Merged channels are data, sRGB sources are linearized as sampling them on the GPU does */
+static bool IsLinearized(const UTexture2D* Source, int32 SourceChannel)
+{
+	const ETextureSourceFormat Format = Source->Source.GetFormat();
+	return Source->SRGB && SourceChannel != 3 && Format != TSF_RGBA16F && Format != TSF_BGRE8 && Format != TSF_RGBE8;
+}
+
+static float SRGBToLinear(float Value)
+{
+	return Value <= 0.04045f ? Value / 12.92f : FMath::Pow((Value + 0.055f) / 1.055f, 2.4f);
+}
+
+static void WriteValue(uint8* Pixel, ETextureSourceFormat Format, int32 Channel, float Value)
+{
+	switch (Format)
+	{
+	case TSF_BGRA8:
+		Pixel[BGRA8Offsets[Channel]] = (uint8)FMath::Clamp(FMath::RoundToInt(Value * 255.f), 0, 255);
+		break;
+	case TSF_RGBA16:
+		((uint16*)Pixel)[Channel] = (uint16)FMath::Clamp(FMath::RoundToInt(Value * 65535.f), 0, 65535);
+		break;
+	case TSF_RGBA16F:
+		((FFloat16*)Pixel)[Channel] = FFloat16(Value);
+		break;
+	default:
+		break;
+	}
+}
+
+FTextureSourceDecodeCache::~FTextureSourceDecodeCache()
+{
+	if (NumDecoded > 0)
+		UE_LOG(LogTemp, Log, TEXT("Decoded %d sources, %d decodes saved by sharing them"), NumDecoded, NumHits);
+}
+
+void FTextureSourceDecodeCache::Reset()
+{
+	Entries.Reset();
+	UsedBytes = 0;
+}
+
+TSharedPtr<const TArray<uint8>> FTextureSourceDecodeCache::Get(UTexture2D* Texture, IImageWrapperModule* ImageWrapperModule)
+{
+	const FGuid SourceId = Texture->Source.GetId();
+	const int32 Index = Entries.IndexOfByPredicate([&](const FEntry& Entry) { return Entry.SourceId == SourceId; });
+	if (Index != INDEX_NONE)
+	{
+		FEntry Entry = Entries[Index];
+		Entries.RemoveAt(Index, 1, false);
+		Entries.Add(Entry);
+		++NumHits;
+		return Entry.Data;
+	}
+
+	TSharedPtr<TArray<uint8>> Data = MakeShared<TArray<uint8>>();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_TiledMergeDecode);
+		LLM_SCOPE(ELLMTag::Textures);
+		Texture->Source.GetMipData(*Data, 0, ImageWrapperModule);
+	}
+	++NumDecoded;
+	UsedBytes += Data->Num();
+	Entries.Add({ SourceId, Data });
+	// The entry just added stays even alone over budget, the caller is about to read it
+	while (UsedBytes > BudgetBytes && Entries.Num() > 1)
+	{
+		UsedBytes -= Entries[0].Data->Num();
+		Entries.RemoveAt(0, 1, false);
+	}
+	return Data;
+}
+
+ETextureSourceFormat FTextureTiledMerge::GetOutputFormat(UTexture2D* const Sources[4], const FTextureChannelSrc* const Channels[4])
+{
+	ETextureSourceFormat Format = TSF_BGRA8;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (!Sources[i])
+			continue;
+		const ETextureSourceFormat SourceFormat = Sources[i]->Source.GetFormat();
+		if (SourceFormat == TSF_RGBA16F || SourceFormat == TSF_BGRE8 || SourceFormat == TSF_RGBE8)
+			return TSF_RGBA16F;
+		// Linear values of 8 bit sRGB darks need more than 8 bits, they would band
+		if (SourceFormat == TSF_RGBA16 || IsLinearized(Sources[i], (int32)Channels[i]->Channel))
+			Format = TSF_RGBA16;
+	}
+	return Format;
+}
+
+UTexture2D* FTextureTiledMerge::Merge(UObject* Outer, const FString& Name, EObjectFlags Flags, UTexture2D* const Sources[4], const FTextureChannelSrc* const Channels[4], FText& FailReason,
+	FTextureToolMemoryTracker* Memory, FTextureSourceDecodeCache* DecodeCache, TextureCompressionSettings CompressionSettings)
+{
+	FIntPoint Size = FIntPoint::ZeroValue;
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (!Sources[i])
+			continue;
+		const FTextureSource& Source = Sources[i]->Source;
+		if (!FTextureSourceAccess::IsSupportedFormat(Source.GetFormat()))
+		{
+			FailReason = FText::Format(LOCTEXT("TiledMergeFormat", "Source format of {0} is not supported!"), FText::FromString(Sources[i]->GetName()));
+			return nullptr;
+		}
+		const FIntPoint SourceSize(Source.GetSizeX(), Source.GetSizeY());
+		if (Size != FIntPoint::ZeroValue && Size != SourceSize)
+		{
+			FailReason = LOCTEXT("SizeNotMatch", "Source textures' size does not match!");
+			return nullptr;
+		}
+		Size = SourceSize;
+	}
+	if (Size == FIntPoint::ZeroValue || !FMath::IsPowerOfTwo(Size.X) || !FMath::IsPowerOfTwo(Size.Y))
+	{
+		FailReason = LOCTEXT("SizeNotValid", "Source textures' size is not valid, must be power of two!");
+		return nullptr;
+	}
+
+	const ETextureSourceFormat Format = GetOutputFormat(Sources, Channels);
+	EMipFilter MipFilters[4];
+	float CoverageThresholds[4];
+	for (int32 i = 0; i < 4; ++i)
+	{
+		MipFilters[i] = Channels[i]->MipFilter;
+		CoverageThresholds[i] = Channels[i]->CoverageThreshold;
+	}
+	const bool bBuildMips = FTextureMipChain::NeedsMipChain(MipFilters);
+	UTexture2D* Texture = NewObject<UTexture2D>(Outer, *Name, Flags);
+	Texture->SRGB = false;
+	Texture->CompressionSettings = Format == TSF_RGBA16F ? TC_HDR : CompressionSettings;
+	{
+		LLM_SCOPE(ELLMTag::Textures);
+		Texture->Source.Init(Size.X, Size.Y, 1, bBuildMips ? FTextureMipChain::GetNumMips(Size.X, Size.Y) : 1, Format);
+	}
+
+	const int32 OutBytesPerPixel = Texture->Source.GetBytesPerPixel();
+	const int32 NumBands = (Size.Y + BandRows - 1) / BandRows;
+	const int64 BandPixels = (int64)BandRows * Size.X;
+	const int64 NumPixels = (int64)Size.X * Size.Y;
+	uint8* Output = Texture->Source.LockMip(0);
+	IImageWrapperModule* ImageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	for (int32 Channel = 0; Channel < 4; ++Channel)
+	{
+		UTexture2D* Source = Sources[Channel];
+		if (!Source)
+		{
+			// Missing channels are black, a missing alpha is opaque
+			const float Value = Channel == 3 ? 1.f : 0.f;
+			ParallelFor(NumBands, [&](int32 Band)
+			{
+				const int64 End = FMath::Min(Band * BandPixels + BandPixels, NumPixels);
+				for (int64 Pixel = Band * BandPixels; Pixel < End; ++Pixel)
+					WriteValue(Output + Pixel * OutBytesPerPixel, Format, Channel, Value);
+			});
+			continue;
+		}
+
+		const ETextureSourceFormat SourceFormat = Source->Source.GetFormat();
+		const int32 SourceChannel = (int32)Channels[Channel]->Channel;
+		const int32 SourceBytesPerPixel = Source->Source.GetBytesPerPixel();
+		const bool bLinearize = IsLinearized(Source, SourceChannel);
+		// Uncompressed sources are read in place, locking a PNG compressed one would decompress it for good
+		const bool bInPlace = !Source->Source.IsPNGCompressed();
+		TSharedPtr<const TArray<uint8>> MipData;
+		const uint8* Input = nullptr;
+		if (bInPlace)
+		{
+			Input = Source->Source.LockMip(0);
+		}
+		else
+		{
+			if (DecodeCache)
+			{
+				MipData = DecodeCache->Get(Source, ImageWrapperModule);
+			}
+			else
+			{
+				SCOPE_CYCLE_COUNTER(STAT_TextureTool_TiledMergeDecode);
+				LLM_SCOPE(ELLMTag::Textures);
+				TSharedPtr<TArray<uint8>> Data = MakeShared<TArray<uint8>>();
+				Source->Source.GetMipData(*Data, 0, ImageWrapperModule);
+				MipData = Data;
+			}
+			if (MipData->Num() >= NumPixels * SourceBytesPerPixel)
+				Input = MipData->GetData();
+		}
+		if (!Input)
+		{
+			if (bInPlace)
+				Source->Source.UnlockMip(0);
+			Texture->Source.UnlockMip(0);
+			Texture->MarkPendingKill();
+			FailReason = FText::Format(LOCTEXT("TiledMergeDecode", "Fail to read source data of {0}!"), FText::FromString(Source->GetName()));
+			return nullptr;
+		}
+
+		SCOPE_CYCLE_COUNTER(STAT_TextureTool_TiledMergeCopy);
+		if (Format == TSF_BGRA8 && Is8Bit(SourceFormat))
+		{
+			// Byte to byte, a linearized source would have made the output 16 bit
+			const int32 InOffset = Get8BitOffset(SourceFormat, SourceChannel);
+			const int32 OutOffset = BGRA8Offsets[Channel];
+			ParallelFor(NumBands, [&](int32 Band)
+			{
+				const int64 End = FMath::Min(Band * BandPixels + BandPixels, NumPixels);
+				for (int64 Pixel = Band * BandPixels; Pixel < End; ++Pixel)
+					Output[Pixel * 4 + OutOffset] = InOffset == INDEX_NONE ? 255 : Input[Pixel * SourceBytesPerPixel + InOffset];
+			});
+		}
+		else
+		{
+			ParallelFor(NumBands, [&](int32 Band)
+			{
+				const int64 End = FMath::Min(Band * BandPixels + BandPixels, NumPixels);
+				for (int64 Pixel = Band * BandPixels; Pixel < End; ++Pixel)
+				{
+					float Value = FTextureSourceAccess::DecodePixel(Input + Pixel * SourceBytesPerPixel, SourceFormat).Component(SourceChannel);
+					if (bLinearize)
+						Value = SRGBToLinear(Value);
+					WriteValue(Output + Pixel * OutBytesPerPixel, Format, Channel, Value);
+				}
+			});
+		}
+		if (bInPlace)
+			Source->Source.UnlockMip(0);
+	}
+
+	Texture->Source.UnlockMip(0);
+	if (bBuildMips)
+	{
+		FTextureMipChain::Build(Texture->Source, MipFilters, CoverageThresholds);
+		Texture->MipGenSettings = TMGS_LeaveExistingMips;
+	}
+	Texture->PostEditChange();
+	if (Memory)
+		Memory->Track(ETextureToolMemory::Outputs, Texture);
+	return Texture;
+}
+
+#undef LOCTEXT_NAMESPACE
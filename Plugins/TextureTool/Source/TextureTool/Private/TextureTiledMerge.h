@@ -0,0 +1,57 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "SettingObjects.h"
+#include "Engine/Texture.h"
+
+class UTexture2D;
+class FTextureToolMemoryTracker;
+class IImageWrapperModule;
+
+/** Decoded mip 0 of PNG compressed sources merged by several groups of a batch, least recently used sources are dropped past the budget */
+class FTextureSourceDecodeCache
+{
+public:
+	/** Enough for the channels of one 4k group, sources are only shared by the presets of a group */
+	explicit FTextureSourceDecodeCache(int64 InBudgetBytes = 256ll * 1024 * 1024) : BudgetBytes(InBudgetBytes) {}
+	~FTextureSourceDecodeCache();
+	TSharedPtr<const TArray<uint8>> Get(UTexture2D* Texture, IImageWrapperModule* ImageWrapperModule);
+	/** Drop every decoded source, once the groups using them are merged */
+	void Reset();
+
+private:
+	struct FEntry
+	{
+		FGuid SourceId;
+		TSharedPtr<const TArray<uint8>> Data;
+	};
+	/** Most recently used last */
+	TArray<FEntry> Entries;
+	int64 BudgetBytes;
+	int64 UsedBytes = 0;
+	int32 NumDecoded = 0;
+	int32 NumHits = 0;
+};
+
+/**
+ * Merge from texture source data on the CPU, without render target or GPU readback.
+ * Uncompressed sources are locked and their rows copied band by band straight into the output source.
+ * PNG compressed sources can only be decoded whole, one at a time, and the decoded copy is dropped
+ * once its channel is copied unless the decode cache keeps it. Memory is the output, the sources'
+ * own bulk data, which stays resident with their texture, and at most one decoded PNG source.
+ * Values are read from the sources, not from their compressed platform data. When a channel asks
+ * for its own mip filter the whole chain is built here and stored in the source, the texture build keeps it.
+ */
+struct TEXTURETOOL_API FTextureTiledMerge
+{
+	/** Rows copied per task */
+	static const int32 BandRows = 64;
+
+	/** Output is BGRA8, RGBA16 when a source has 16 bit channels or an sRGB color channel is linearized, RGBA16F when one is HDR */
+	static ETextureSourceFormat GetOutputFormat(UTexture2D* const Sources[4], const FTextureChannelSrc* const Channels[4]);
+	/**
+	 * Create the merged texture Name in Outer, returns null with the reason on failure, sources are decoded through DecodeCache when given.
+	 * CompressionSettings is set before the texture is built, an HDR output is always TC_HDR.
+	 */
+	static UTexture2D* Merge(UObject* Outer, const FString& Name, EObjectFlags Flags, UTexture2D* const Sources[4], const FTextureChannelSrc* const Channels[4], FText& FailReason,
+		FTextureToolMemoryTracker* Memory = nullptr, FTextureSourceDecodeCache* DecodeCache = nullptr, TextureCompressionSettings CompressionSettings = TC_Default);
+};
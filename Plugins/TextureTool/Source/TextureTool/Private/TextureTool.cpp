@@ -12,6 +12,8 @@
 #include "STextureToolUI.h"
 #include "PropertyEditorModule.h"
 #include "TextureMergeSettingsCustomization.h"
+#include "TextureAnalysisCache.h"
+#include "TextureMergeJob.h"
 #include "Editor/DetailCustomizations/Public/DetailCustomizations.h"
 #define LOCTEXT_NAMESPACE "FTextureToolModule"
 
@@ -31,6 +33,7 @@ TSharedRef<SDockTab> SpawnTextureToolTab(const FSpawnTabArgs& SpawnTabArgs)
 
 void FTextureToolModule::StartupModule()
 {
+	FTextureMergeQueue::Startup();
 	FCoreDelegates::OnPostEngineInit.AddRaw(this, &FTextureToolModule::OnPostEngineInit);
 
 	FLevelEditorModule& LevelEditorModule = FModuleManager::LoadModuleChecked<FLevelEditorModule>(TEXT("LevelEditor"));
@@ -71,6 +74,8 @@ void FTextureToolModule::OnPostEngineInit()
 
 void FTextureToolModule::ShutdownModule()
 {
+	FTextureMergeQueue::Shutdown();
+	FTextureAnalysisCache::Get().Flush();
 	FCoreDelegates::OnPostEngineInit.RemoveAll(this);
 	if (!IsRunningCommandlet())
 	{
@@ -0,0 +1,220 @@
+#include "TextureToolAuditCommandlet.h"
+#include "TextureUtils.h"
+#include "TextureAnalysisCache.h"
+#include "TextureChannelAnalyzer.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "GameFramework/Actor.h"
+#include "AssetRegistryModule.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/DateTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+
+struct FTextureAuditRow
+{
+	FAssetData Asset;
+	/** In game size, only known for textures loaded by a map */
+	FIntPoint Size = FIntPoint::ZeroValue;
+	FIntPoint SourceSize = FIntPoint::ZeroValue;
+	FString Format;
+	FString CompressionSettings;
+	FString LODGroup;
+	FString SRGB;
+	int64 EstimatedBytes = 0;
+	int32 NumReferencers = 0;
+	int32 NumActors = 0;
+	/** Yes, No, or Unknown when the power of two mode of a non power of two source can only be read by loading it */
+	FString CanDownScale;
+	/** From the texture analysis cache, empty when the texture was never analyzed */
+	FString ChannelIssue;
+};
+
+static FString GetTag(const FAssetData& Asset, const TCHAR* Name)
+{
+	FString Value;
+	Asset.GetTagValue(FName(Name), Value);
+	return Value;
+}
+
+static FTextureAuditRow MakeRow(const FAssetData& Asset, IAssetRegistry& AssetRegistry)
+{
+	FTextureAuditRow Row;
+	Row.Asset = Asset;
+	FTextureToolUtils::GetSourceSize(Asset, Row.SourceSize);
+	Row.Format = GetTag(Asset, TEXT("Format"));
+	Row.CompressionSettings = GetTag(Asset, TEXT("CompressionSettings"));
+	Row.LODGroup = GetTag(Asset, TEXT("LODGroup"));
+	Row.SRGB = GetTag(Asset, TEXT("SRGB"));
+
+	if (UTexture2D* Texture = Asset.IsAssetLoaded() ? Cast<UTexture2D>(Asset.GetAsset()) : nullptr)
+		Row.Size = FIntPoint(Texture->GetSizeX(), Texture->GetSizeY());
+	Row.EstimatedBytes = FTextureToolUtils::EstimateBytes(Row.Size.X > 0 ? Row.Size : Row.SourceSize, FTextureToolUtils::GetPixelFormat(Asset));
+
+	TArray<FName> Referencers;
+	AssetRegistry.GetReferencers(Asset.PackageName, Referencers);
+	Row.NumReferencers = Referencers.Num();
+
+	bool bDecided;
+	const bool bCanDownScale = FTextureToolUtils::CanDownScaleTexture(Asset, bDecided);
+	Row.CanDownScale = !bDecided ? TEXT("Unknown") : bCanDownScale ? TEXT("Yes") : TEXT("No");
+
+	FTextureChannelReport Report;
+	if (FTextureAnalysisCache::Get().FindForAsset(Asset, ETextureAnalysis::Channels, FTextureChannelAnalyzer::CacheVersion, Report) && Report.HasIssue())
+		Row.ChannelIssue = Report.GetIssueText().ToString();
+	return Row;
+}
+
+static FString EscapeCsv(const FString& Value)
+{
+	if (!Value.Contains(TEXT(",")) && !Value.Contains(TEXT("\"")) && !Value.Contains(TEXT("\n")))
+		return Value;
+	return TEXT("\"") + Value.Replace(TEXT("\""), TEXT("\"\"")) + TEXT("\"");
+}
+
+static bool WriteCsv(const TArray<FTextureAuditRow>& Rows, const FString& Path)
+{
+	TArray<FString> Lines;
+	Lines.Add(TEXT("Texture,SizeX,SizeY,SourceSizeX,SourceSizeY,Format,CompressionSettings,LODGroup,SRGB,EstimatedBytes,Referencers,Actors,CanDownScale,ChannelIssue"));
+	for (const FTextureAuditRow& Row : Rows)
+	{
+		Lines.Add(FString::Printf(TEXT("%s,%d,%d,%d,%d,%s,%s,%s,%s,%lld,%d,%d,%s,%s"), *EscapeCsv(Row.Asset.ObjectPath.ToString()),
+			Row.Size.X, Row.Size.Y, Row.SourceSize.X, Row.SourceSize.Y, *EscapeCsv(Row.Format), *EscapeCsv(Row.CompressionSettings), *EscapeCsv(Row.LODGroup),
+			*EscapeCsv(Row.SRGB), Row.EstimatedBytes, Row.NumReferencers, Row.NumActors, *Row.CanDownScale, *EscapeCsv(Row.ChannelIssue)));
+	}
+	return FFileHelper::SaveStringArrayToFile(Lines, *Path);
+}
+
+static bool WriteJson(const TArray<FTextureAuditRow>& Rows, const FString& Path)
+{
+	TArray<TSharedPtr<FJsonValue>> Values;
+	for (const FTextureAuditRow& Row : Rows)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetStringField(TEXT("Texture"), Row.Asset.ObjectPath.ToString());
+		Object->SetNumberField(TEXT("SizeX"), Row.Size.X);
+		Object->SetNumberField(TEXT("SizeY"), Row.Size.Y);
+		Object->SetNumberField(TEXT("SourceSizeX"), Row.SourceSize.X);
+		Object->SetNumberField(TEXT("SourceSizeY"), Row.SourceSize.Y);
+		Object->SetStringField(TEXT("Format"), Row.Format);
+		Object->SetStringField(TEXT("CompressionSettings"), Row.CompressionSettings);
+		Object->SetStringField(TEXT("LODGroup"), Row.LODGroup);
+		Object->SetStringField(TEXT("SRGB"), Row.SRGB);
+		Object->SetNumberField(TEXT("EstimatedBytes"), (double)Row.EstimatedBytes);
+		Object->SetNumberField(TEXT("Referencers"), Row.NumReferencers);
+		Object->SetNumberField(TEXT("Actors"), Row.NumActors);
+		Object->SetStringField(TEXT("CanDownScale"), Row.CanDownScale);
+		Object->SetStringField(TEXT("ChannelIssue"), Row.ChannelIssue);
+		Values.Add(MakeShared<FJsonValueObject>(Object));
+	}
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("Date"), FDateTime::Now().ToIso8601());
+	Root->SetArrayField(TEXT("Textures"), Values);
+
+	FString Text;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Text);
+	FJsonSerializer::Serialize(Root, Writer);
+	return FFileHelper::SaveStringToFile(Text, *Path);
+}
+
+UTextureToolAuditCommandlet::UTextureToolAuditCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UTextureToolAuditCommandlet::Main(const FString& Params)
+{
+	FString PathsString, MapsString;
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("TextureTool/Audit");
+	FParse::Value(*Params, TEXT("Paths="), PathsString, false);
+	FParse::Value(*Params, TEXT("Maps="), MapsString, false);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	bool bCsv = FParse::Param(*Params, TEXT("CSV"));
+	bool bJson = FParse::Param(*Params, TEXT("JSON"));
+	if (!bCsv && !bJson)
+		bCsv = bJson = true;
+
+	TArray<FString> Paths, Maps;
+	PathsString.ParseIntoArray(Paths, TEXT("+"));
+	MapsString.ParseIntoArray(Maps, TEXT("+"));
+	if (Paths.Num() == 0 && Maps.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=TextureToolAudit [-Paths=/Game/A+/Game/B] [-Maps=/Game/Maps/Map+...] [-Output=Saved/TextureTool/Audit] [-CSV] [-JSON]"));
+		return 1;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	// Textures of maps are loaded with them anyway, textures under paths stay on disk
+	TMap<FName, int32> ActorsByTexture;
+	TArray<FAssetData> Assets;
+	for (const FString& Map : Maps)
+	{
+		UPackage* Package = LoadPackage(nullptr, *Map, LOAD_None);
+		UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+		if (!World)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Fail to load map %s"), *Map);
+			continue;
+		}
+		for (ULevel* Level : World->GetLevels())
+		{
+			for (AActor* Actor : Level->Actors)
+			{
+				if (!Actor)
+					continue;
+				TArray<UTexture2D*> Textures;
+				for (UTexture2D* Texture : FTextureToolUtils::FindTextures(Actor))
+					Textures.AddUnique(Texture);
+				for (UTexture2D* Texture : Textures)
+				{
+					if (!Texture->IsAsset())
+						continue;
+					int32& NumActors = ActorsByTexture.FindOrAdd(FName(*Texture->GetPathName()));
+					if (NumActors++ == 0)
+						Assets.Add(FAssetData(Texture));
+				}
+			}
+		}
+	}
+	for (const FString& Path : Paths)
+	{
+		for (const FAssetData& Asset : FTextureToolUtils::GetTexturesInDirectory(Path, true))
+		{
+			if (!ActorsByTexture.Contains(Asset.ObjectPath))
+				Assets.Add(Asset);
+		}
+	}
+
+	TArray<FTextureAuditRow> Rows;
+	Rows.Reserve(Assets.Num());
+	int64 TotalBytes = 0;
+	for (const FAssetData& Asset : Assets)
+	{
+		FTextureAuditRow& Row = Rows.Add_GetRef(MakeRow(Asset, AssetRegistry));
+		if (const int32* NumActors = ActorsByTexture.Find(Asset.ObjectPath))
+			Row.NumActors = *NumActors;
+		TotalBytes += Row.EstimatedBytes;
+	}
+	Rows.Sort([](const FTextureAuditRow& A, const FTextureAuditRow& B) { return A.EstimatedBytes > B.EstimatedBytes; });
+
+	bool bWritten = true;
+	if (bCsv)
+		bWritten &= WriteCsv(Rows, OutputPath + TEXT(".csv"));
+	if (bJson)
+		bWritten &= WriteJson(Rows, OutputPath + TEXT(".json"));
+	if (!bWritten)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Fail to write audit to %s"), *OutputPath);
+		return 1;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Audited %d textures, %.1f MB estimated, in %.1f s, written to %s"), Rows.Num(), TotalBytes / (1024.0 * 1024.0), FPlatformTime::Seconds() - StartTime, *OutputPath);
+	return 0;
+}
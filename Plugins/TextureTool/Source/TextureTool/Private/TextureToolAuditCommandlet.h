@@ -0,0 +1,19 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TextureToolAuditCommandlet.generated.h"
+
+/**
+ * Texture audit without the editor UI, for dashboards.
+ * -run=TextureToolAudit [-Paths=/Game/A+/Game/B] [-Maps=/Game/Maps/Map+...] [-Output=Saved/TextureTool/Audit] [-CSV] [-JSON]
+ * Textures under Paths are read from asset registry tags only, textures used by actors of Maps are the ones the Finder lists.
+ * Writes Output.csv and Output.json, both when neither -CSV nor -JSON is given. Runs with -nullrhi.
+ */
+UCLASS()
+class UTextureToolAuditCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UTextureToolAuditCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,138 @@
+#include "TextureToolBatchCommandlet.h"
+#include "SettingObjects.h"
+#include "TextureMergeJournal.h"
+#include "FileHelpers.h"
+#include "TextureBatchEstimator.h"
+#include "Misc/App.h"
+
+/** Keyword[:Channel], a channel without a keyword argument is left out of the merge */
+static void ParseChannel(const FString& Params, const TCHAR* Name, FTextureChannelSrc& Src)
+{
+	FString Value;
+	Src.Texture = nullptr;
+	Src.Optional = FParse::Value(*Params, Name, Value, false);
+	if (!Src.Optional)
+		return;
+	FString Keyword, Channel;
+	if (!Value.Split(TEXT(":"), &Keyword, &Channel, ESearchCase::IgnoreCase, ESearchDir::FromEnd))
+		Keyword = Value;
+	Src.Keyword = Keyword;
+	Src.Channel = EChannel::R;
+	if (Channel == TEXT("G"))
+		Src.Channel = EChannel::G;
+	else if (Channel == TEXT("B"))
+		Src.Channel = EChannel::B;
+	else if (Channel == TEXT("A"))
+		Src.Channel = EChannel::A;
+}
+
+UTextureToolBatchCommandlet::UTextureToolBatchCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UTextureToolBatchCommandlet::Main(const FString& Params)
+{
+	FString SavePackagePath;
+	FString SaveKeyword = TEXT("_Merged");
+	UTextureMergeSettings* Settings = UTextureMergeSettings::Get();
+	Settings->bMergeOnGPU = FParse::Param(*Params, TEXT("GPU"));
+	if (Settings->bMergeOnGPU && !FApp::CanEverRender())
+	{
+		UE_LOG(LogTemp, Error, TEXT("-GPU needs a renderer, run without -nullrhi"));
+		return 1;
+	}
+	FParse::Value(*Params, TEXT("Input="), Settings->InputDirectory.Path);
+	FParse::Value(*Params, TEXT("Output="), SavePackagePath);
+	FParse::Value(*Params, TEXT("SaveKeyword="), SaveKeyword);
+	FParse::Value(*Params, TEXT("ChunkSize="), Settings->SaveChunkSize);
+	Settings->bRecursive = FParse::Param(*Params, TEXT("Recursive"));
+	Settings->bRewireMaterials = FParse::Param(*Params, TEXT("RewireMaterials"));
+	Settings->bSaveOutputs = true;
+	Settings->SaveChunkSize = FMath::Max(Settings->SaveChunkSize, 1);
+	ParseChannel(Params, TEXT("R="), Settings->R);
+	ParseChannel(Params, TEXT("G="), Settings->G);
+	ParseChannel(Params, TEXT("B="), Settings->B);
+	ParseChannel(Params, TEXT("A="), Settings->A);
+	ParseChannel(Params, TEXT("Replace="), Settings->ReplaceTexture);
+	if (Settings->InputDirectory.Path.IsEmpty() || SavePackagePath.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=TextureToolBatch -Input=/Game/Path -Output=/Game/Path [-SaveKeyword=_Merged] [-Recursive] [-R=Keyword[:Channel]] [-G=...] [-B=...] [-A=...] [-Replace=Keyword] [-Presets=/Game/A+/Game/B] [-Compression=TC_Masks] [-RewireMaterials] [-ChunkSize=32] [-NoResume] [-GPU] [-DryRun]"));
+		return 1;
+	}
+
+	FString CompressionString;
+	if (FParse::Value(*Params, TEXT("Compression="), CompressionString))
+	{
+		const UEnum* Enum = FindObject<UEnum>(ANY_PACKAGE, TEXT("TextureCompressionSettings"));
+		const int64 Value = Enum ? Enum->GetValueByNameString(CompressionString) : INDEX_NONE;
+		if (Value == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Unknown compression %s"), *CompressionString);
+			return 1;
+		}
+		Settings->OutputCompression = (TextureCompressionSettings)Value;
+	}
+
+	FString PresetsString;
+	FParse::Value(*Params, TEXT("Presets="), PresetsString, false);
+	TArray<FString> PresetPaths;
+	PresetsString.ParseIntoArray(PresetPaths, TEXT("+"));
+	Settings->Presets.Reset();
+	for (const FString& Path : PresetPaths)
+	{
+		UTextureMergePreset* Preset = LoadObject<UTextureMergePreset>(nullptr, *Path);
+		if (!Preset)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Fail to load merge preset %s"), *Path);
+			return 1;
+		}
+		Settings->Presets.Add(Preset);
+	}
+
+	TArray<FString> MatchedNames;
+	if (!Settings->Match(MatchedNames) || MatchedNames.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("No texture group matched under %s"), *Settings->InputDirectory.Path);
+		return 1;
+	}
+
+	FText CollisionReason;
+	if (!Settings->CheckOutputNames(MatchedNames, SaveKeyword, CollisionReason))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s"), *CollisionReason.ToString());
+		return 1;
+	}
+
+	if (FParse::Param(*Params, TEXT("DryRun")))
+	{
+		FTextureBatchEstimate Estimate;
+		FTextureBatchEstimator::Estimate(Settings, MatchedNames, Estimate);
+		for (const FString& Name : MatchedNames)
+		{
+			const FTextureBatchGroupEstimate& Group = Estimate.Groups[Name];
+			if (Group.WillFail())
+				UE_LOG(LogTemp, Warning, TEXT("%s: %s"), *Name, *Group.Problem.ToString());
+			else
+				UE_LOG(LogTemp, Display, TEXT("%s: %dx%d, source %lld bytes, cooked %lld bytes"), *Name, Group.Size.X, Group.Size.Y, Group.SourceBytes, Group.CookedBytes);
+		}
+		UE_LOG(LogTemp, Display, TEXT("%s"), *Estimate.GetSummaryText().ToString());
+		return Estimate.NumFailing > 0 ? 1 : 0;
+	}
+
+	FTextureMergeJournal Journal(Settings->GetBatchFingerprint(SavePackagePath, SaveKeyword));
+	if (FParse::Param(*Params, TEXT("NoResume")))
+		Journal.Reset();
+	else if (Journal.GetCompleted().Num() > 0)
+		UE_LOG(LogTemp, Display, TEXT("Resuming batch, %d of %d groups already merged"), Journal.GetCompleted().Num(), MatchedNames.Num());
+
+	TArray<UObject*> Results;
+	const bool bCompleted = Settings->ExecuteBatch(MatchedNames, SavePackagePath, SaveKeyword, Journal, Results);
+	// Outputs are saved by the batch, what is left are rewired materials and consolidated referencers
+	UEditorLoadingAndSavingUtils::SaveDirtyPackages(false, true);
+	UE_LOG(LogTemp, Display, TEXT("Batch %s, %d textures"), bCompleted ? TEXT("completed") : TEXT("stopped"), Results.Num());
+	return bCompleted ? 0 : 1;
+}
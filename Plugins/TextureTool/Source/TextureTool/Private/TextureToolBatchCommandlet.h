@@ -0,0 +1,23 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TextureToolBatchCommandlet.generated.h"
+
+/**
+ * Batch merge without the editor UI, outputs are always saved.
+ * -run=TextureToolBatch -Input=/Game/Path -Output=/Game/Path [-SaveKeyword=_Merged] [-Recursive]
+ * [-R=Keyword[:Channel]] [-G=...] [-B=...] [-A=...] [-Replace=Keyword] [-Presets=/Game/A+/Game/B] [-Compression=TC_Masks]
+ * [-RewireMaterials] [-ChunkSize=32] [-NoResume] [-GPU] [-DryRun]
+ * With -Presets the channels of every preset are merged in the same run instead of -R, -G, -B, -A and -Replace.
+ * Merges on the CPU and runs with -nullrhi, -GPU draws with the merge material instead.
+ * -DryRun only logs the expected size of every group, the groups which would fail and the expected time, from registry tags.
+ * A run stopped before the end is resumed by running it again with the same arguments, unless -NoResume.
+ */
+UCLASS()
+class UTextureToolBatchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UTextureToolBatchCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
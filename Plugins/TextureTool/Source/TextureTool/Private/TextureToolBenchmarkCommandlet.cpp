@@ -0,0 +1,340 @@
+#include "TextureToolBenchmarkCommandlet.h"
+#include "SettingObjects.h"
+#include "TextureUtils.h"
+#include "WorldReferenceGenerator.h"
+#include "TextureTiledMerge.h"
+#include "Engine/Engine.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Components/StaticMeshComponent.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "AssetRegistryModule.h"
+#include "Misc/App.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Math/RandomStream.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+static const TCHAR* BenchmarkRoot = TEXT("/Temp/TextureToolBenchmark");
+static const TCHAR* ChannelKeywords[] = { TEXT("_Roughness"), TEXT("_Metallic"), TEXT("_AO"), TEXT("_Height") };
+/** Differences below this are timer noise, never reported as regressions */
+static const double BenchmarkNoiseMs = 0.5;
+
+struct FBenchmarkResult
+{
+	FString Name;
+	int32 Iterations = 0;
+	double MinMs = 0.0;
+	double MeanMs = 0.0;
+};
+
+template<typename FunctionType>
+static FBenchmarkResult Measure(const FString& Name, int32 Iterations, FunctionType Body)
+{
+	FBenchmarkResult Result;
+	Result.Name = Name;
+	Result.Iterations = Iterations;
+	Result.MinMs = DBL_MAX;
+	double TotalMs = 0.0;
+	for (int32 i = 0; i < Iterations; ++i)
+	{
+		const double Start = FPlatformTime::Seconds();
+		Body();
+		const double Ms = (FPlatformTime::Seconds() - Start) * 1000.0;
+		Result.MinMs = FMath::Min(Result.MinMs, Ms);
+		TotalMs += Ms;
+	}
+	Result.MeanMs = TotalMs / FMath::Max(Iterations, 1);
+	UE_LOG(LogTemp, Display, TEXT("%-32s min %10.3f ms, mean %10.3f ms"), *Name, Result.MinMs, Result.MeanMs);
+	return Result;
+}
+
+/** Tiny textures only registered in memory, enough for registry queries and name matching */
+static TArray<UTexture2D*> CreateSyntheticRegistry(int32 NumGroups)
+{
+	TArray<UTexture2D*> Textures;
+	for (int32 Group = 0; Group < NumGroups; ++Group)
+	{
+		for (const TCHAR* Keyword : ChannelKeywords)
+		{
+			const FString AssetName = FString::Printf(TEXT("T_Benchmark_%05d%s"), Group, Keyword);
+			const FString PackageName = FString::Printf(TEXT("%s/Registry/Folder%02d/%s"), BenchmarkRoot, Group / 100, *AssetName);
+			UTexture2D* Texture = NewObject<UTexture2D>(CreatePackage(nullptr, *PackageName), *AssetName, RF_Public | RF_Standalone);
+			Texture->Source.Init(4, 4, 1, 1, TSF_G8);
+			FAssetRegistryModule::AssetCreated(Texture);
+			Textures.Add(Texture);
+		}
+	}
+	return Textures;
+}
+
+/** Noise texture, uncompressed and without mips so building it stays out of the timings */
+static UTexture2D* CreateSyntheticTexture(int32 Size, bool b16Bit)
+{
+	UTexture2D* Texture = NewObject<UTexture2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	Texture->Source.Init(Size, Size, 1, 1, b16Bit ? TSF_RGBA16 : TSF_BGRA8);
+	uint32* Data = (uint32*)Texture->Source.LockMip(0);
+	FRandomStream Random(Size);
+	const int64 NumWords = (int64)Size * Size * (b16Bit ? 2 : 1);
+	for (int64 i = 0; i < NumWords; ++i)
+		Data[i] = Random.GetUnsignedInt();
+	Texture->Source.UnlockMip(0);
+	Texture->CompressionSettings = b16Bit ? TC_HDR : TC_VectorDisplacementmap;
+	Texture->MipGenSettings = TMGS_NoMipmaps;
+	Texture->SRGB = false;
+	Texture->PostEditChange();
+	return Texture;
+}
+
+/** Actors sharing a few materials which sample the registry textures, like a level would */
+static UWorld* CreateSyntheticWorld(int32 NumActors, const TArray<UTexture2D*>& Textures)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Editor, false, TEXT("TextureToolBenchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Editor);
+	WorldContext.SetCurrentWorld(World);
+
+	UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	UMaterialInterface* Parent = LoadObject<UMaterialInterface>(nullptr, TEXT("Material'/TextureTool/Shader/MergeTexture.MergeTexture'"));
+	if (!Parent)
+		Parent = UMaterial::GetDefaultMaterial(MD_Surface);
+	static const FName Parameters[] = { "TextureR", "TextureG", "TextureB", "TextureA" };
+
+	TArray<UMaterialInstanceDynamic*> Materials;
+	for (int32 i = 0; i + 4 <= Textures.Num() && Materials.Num() < 64; i += 4)
+	{
+		UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(Parent, World);
+		for (int32 Channel = 0; Channel < 4; ++Channel)
+			Material->SetTextureParameterValue(Parameters[Channel], Textures[i + Channel]);
+		Materials.Add(Material);
+	}
+
+	for (int32 i = 0; i < NumActors; ++i)
+	{
+		AStaticMeshActor* Actor = World->SpawnActor<AStaticMeshActor>(FVector(i * 100.f, 0.f, 0.f), FRotator::ZeroRotator);
+		Actor->GetStaticMeshComponent()->SetStaticMesh(Mesh);
+		if (Materials.Num() > 0)
+			Actor->GetStaticMeshComponent()->SetMaterial(0, Materials[i % Materials.Num()]);
+	}
+	return World;
+}
+
+static void WriteResults(const FString& Path, const TArray<FBenchmarkResult>& Results)
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("Platform"), FPlatformProperties::PlatformName());
+	Root->SetBoolField(TEXT("Rendering"), FApp::CanEverRender());
+	TArray<TSharedPtr<FJsonValue>> Values;
+	for (const FBenchmarkResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetStringField(TEXT("Name"), Result.Name);
+		Object->SetNumberField(TEXT("Iterations"), Result.Iterations);
+		Object->SetNumberField(TEXT("MinMs"), Result.MinMs);
+		Object->SetNumberField(TEXT("MeanMs"), Result.MeanMs);
+		Values.Add(MakeShared<FJsonValueObject>(Object));
+	}
+	Root->SetArrayField(TEXT("Results"), Values);
+
+	FString Text;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Text);
+	FJsonSerializer::Serialize(Root, Writer);
+	if (FFileHelper::SaveStringToFile(Text, *Path))
+		UE_LOG(LogTemp, Display, TEXT("Benchmark results written to %s"), *Path);
+	else
+		UE_LOG(LogTemp, Error, TEXT("Fail to write benchmark results to %s"), *Path);
+}
+
+/** Best times against a previous run, results missing from the baseline are ignored */
+static bool CompareToBaseline(const FString& Path, const TArray<FBenchmarkResult>& Results, float Tolerance)
+{
+	FString Text;
+	TSharedPtr<FJsonObject> Root;
+	if (!FFileHelper::LoadFileToString(Text, *Path) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Text), Root) || !Root.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Fail to read benchmark baseline %s"), *Path);
+		return false;
+	}
+
+	TMap<FString, double> BaselineMs;
+	for (const TSharedPtr<FJsonValue>& Value : Root->GetArrayField(TEXT("Results")))
+	{
+		const TSharedPtr<FJsonObject>& Object = Value->AsObject();
+		BaselineMs.Add(Object->GetStringField(TEXT("Name")), Object->GetNumberField(TEXT("MinMs")));
+	}
+
+	bool bPassed = true;
+	for (const FBenchmarkResult& Result : Results)
+	{
+		const double* Baseline = BaselineMs.Find(Result.Name);
+		if (!Baseline)
+			continue;
+		if (Result.MinMs > *Baseline * (1.0 + Tolerance) && Result.MinMs - *Baseline > BenchmarkNoiseMs)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Regression in %s, %.3f ms against %.3f ms"), *Result.Name, Result.MinMs, *Baseline);
+			bPassed = false;
+		}
+	}
+	return bPassed;
+}
+
+UTextureToolBenchmarkCommandlet::UTextureToolBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UTextureToolBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString OutputPath = FPaths::ProjectSavedDir() / TEXT("TextureTool/Benchmark.json");
+	FString BaselinePath;
+	FString SizesString = TEXT("256,1024,4096,8192");
+	float Tolerance = 0.15f;
+	int32 Iterations = 5;
+	int32 NumGroups = 2000;
+	int32 NumActors = 2000;
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("Sizes="), SizesString);
+	FParse::Value(*Params, TEXT("Tolerance="), Tolerance);
+	FParse::Value(*Params, TEXT("Iterations="), Iterations);
+	FParse::Value(*Params, TEXT("Groups="), NumGroups);
+	FParse::Value(*Params, TEXT("Actors="), NumActors);
+	NumGroups = FMath::Max(NumGroups, 1);
+	NumActors = FMath::Max(NumActors, 1);
+
+	TArray<FBenchmarkResult> Results;
+	TArray<UTexture2D*> RegistryTextures = CreateSyntheticRegistry(NumGroups);
+
+	UTextureMergeSettings* Settings = UTextureMergeSettings::Get();
+	FTextureChannelSrc* Channels[] = { &Settings->R, &Settings->G, &Settings->B, &Settings->A };
+	for (int32 i = 0; i < 4; ++i)
+	{
+		Channels[i]->Texture = RegistryTextures[i];
+		Channels[i]->Channel = EChannel::R;
+		Channels[i]->Optional = true;
+		Channels[i]->Keyword = ChannelKeywords[i];
+	}
+	Settings->ReplaceTexture.Optional = false;
+	Settings->InputDirectory.Path = FString(BenchmarkRoot) / TEXT("Registry");
+	Settings->bRecursive = true;
+
+	int32 NumMatched = 0;
+	Results.Add(Measure(FString::Printf(TEXT("Match/%d"), NumGroups), Iterations, [&]()
+	{
+		TArray<FString> Names;
+		Settings->Match(Names);
+		NumMatched = Names.Num();
+	}));
+	if (NumMatched != NumGroups)
+		UE_LOG(LogTemp, Error, TEXT("Match found %d groups out of %d"), NumMatched, NumGroups);
+
+	Results.Add(Measure(TEXT("AutoKeyword/1000"), Iterations, [&]()
+	{
+		for (int32 i = 0; i < 1000; ++i)
+			Settings->AutoKeyword();
+	}));
+
+	UWorld* World = CreateSyntheticWorld(NumActors, RegistryTextures);
+	Results.Add(Measure(FString::Printf(TEXT("FindTextures/%d"), NumActors), Iterations, [&]()
+	{
+		for (AActor* Actor : FActorRange(World))
+			FTextureToolUtils::FindTextures(Actor);
+	}));
+	Results.Add(Measure(FString::Printf(TEXT("FindActors/%d"), NumActors), Iterations, [&]()
+	{
+		WorldReferenceGenerator Generator;
+		Generator.BuildReferencingData(World);
+		TSet<const UObject*> Actors;
+		for (int32 i = 0; i < 4; ++i)
+		{
+			Generator.MarkAllObjects();
+			Generator.Generate(RegistryTextures[i], Actors);
+		}
+	}));
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	TArray<FString> Sizes;
+	SizesString.ParseIntoArray(Sizes, TEXT(","));
+	for (const FString& SizeString : Sizes)
+	{
+		const int32 Size = FCString::Atoi(*SizeString);
+		for (int32 BitDepth : { 8, 16 })
+		{
+			UTexture2D* Source = CreateSyntheticTexture(Size, BitDepth == 16);
+			UTexture2D* Sources[4] = { Source, Source, Source, Source };
+			FTextureChannelSrc Channels[4];
+			const FTextureChannelSrc* ChannelPtrs[4] = { &Channels[0], &Channels[1], &Channels[2], &Channels[3] };
+			for (int32 i = 0; i < 4; ++i)
+				Channels[i].Channel = (EChannel)i;
+			auto MeasureMerge = [&](const TCHAR* Label)
+			{
+				Results.Add(Measure(FString::Printf(TEXT("%s/%d/%d"), Label, Size, BitDepth), Iterations, [&]()
+				{
+					FText FailReason;
+					const FString Name = MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass()).ToString();
+					UTexture2D* Merged = FTextureTiledMerge::Merge(GetTransientPackage(), Name, RF_Transient, Sources, ChannelPtrs, FailReason);
+					if (!Merged)
+						UE_LOG(LogTemp, Error, TEXT("Tiled merge failed due to %s"), *FailReason.ToString());
+					else
+						Merged->MarkPendingKill();
+				}));
+			};
+			MeasureMerge(TEXT("TiledMerge"));
+			// Every filter once, the build keeps the chain instead of generating one
+			const EMipFilter Filters[4] = { EMipFilter::Box, EMipFilter::Kaiser, EMipFilter::Max, EMipFilter::Coverage };
+			for (int32 i = 0; i < 4; ++i)
+				Channels[i].MipFilter = Filters[i];
+			MeasureMerge(TEXT("TiledMergeMips"));
+			Source->MarkPendingKill();
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+	}
+
+	// GPU merge draws and reads the result back, there is nothing to time under -nullrhi
+	if (FApp::CanEverRender())
+	{
+		UTextureRenderTarget2D* RT = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+		RT->RenderTargetFormat = RTF_RGBA16f;
+		RT->AddToRoot();
+		for (const FString& SizeString : Sizes)
+		{
+			const int32 Size = FCString::Atoi(*SizeString);
+			for (int32 BitDepth : { 8, 16 })
+			{
+				UTexture2D* Source = CreateSyntheticTexture(Size, BitDepth == 16);
+				Results.Add(Measure(FString::Printf(TEXT("Merge/%d/%d"), Size, BitDepth), Iterations, [&]()
+				{
+					FText FailReason;
+					const EChannel Channels[4] = { EChannel::R, EChannel::G, EChannel::B, EChannel::A };
+					if (!MergeTextures(RT, Source, Source, Source, Source, Channels, FailReason))
+					{
+						UE_LOG(LogTemp, Error, TEXT("Merge failed due to %s"), *FailReason.ToString());
+						return;
+					}
+					const FString Name = MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass()).ToString();
+					RT->ConstructTexture2D(GetTransientPackage(), Name, RF_Transient, CTF_Default, nullptr);
+				}));
+				Source->MarkPendingKill();
+				CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+			}
+		}
+		RT->RemoveFromRoot();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Display, TEXT("No renderer, GPU merge benchmarks skipped"));
+	}
+
+	WriteResults(OutputPath, Results);
+	if (!BaselinePath.IsEmpty() && !CompareToBaseline(BaselinePath, Results, Tolerance))
+		return 1;
+	return 0;
+}
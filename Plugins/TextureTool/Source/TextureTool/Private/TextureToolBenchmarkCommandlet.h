@@ -0,0 +1,20 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "TextureToolBenchmarkCommandlet.generated.h"
+
+/**
+ * Times Match, AutoKeyword, the merge path, FindTextures and the actor reference lookup on synthetic data.
+ * -run=TextureToolBenchmark [-Output=File.json] [-Baseline=File.json] [-Tolerance=0.15] [-Iterations=5]
+ * [-Groups=2000] [-Actors=2000] [-Sizes=256,1024,4096,8192]
+ * Returns non zero when a result is slower than the baseline by more than the tolerance.
+ * Runs with -nullrhi, the GPU merge path needs a renderer and is skipped there.
+ */
+UCLASS()
+class UTextureToolBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+public:
+	UTextureToolBenchmarkCommandlet();
+	virtual int32 Main(const FString& Params) override;
+};
@@ -10,6 +10,9 @@
 #include "Framework/MultiBox/MultiBoxBuilder.h"
 #include "ContentBrowserModule.h"
 #include "EditorStyleSet.h"
+#include "Misc/ScopedSlowTask.h"
+#include "UObject/UObjectGlobals.h"
+#include "TextureToolStats.h"
 #define LOCTEXT_NAMESPACE "FTextureUtils"
 
 struct FContentBrowserSelectedAssetExtensionBase
@@ -22,45 +25,145 @@ public:
 	virtual ~FContentBrowserSelectedAssetExtensionBase() {}
 };
 
+/** Packages loaded per step, bounds memory and keeps the progress dialog responsive */
+static const int32 DownScaleLoadBatchSize = 32;
+
 struct FDownScaleTextureExtension : public FContentBrowserSelectedAssetExtensionBase
 {
 	void Execute() override
 	{
-		// Create sprites for any selected textures
-		TArray<UTexture2D*> Textures;
-		for (auto AssetIt = SelectedAssets.CreateConstIterator(); AssetIt; ++AssetIt)
+		// Validate from registry tags, only textures that can't be decided without loading are loaded here
+		TArray<FAssetData> Textures;
+		TArray<FAssetData> Undecided;
+		TArray<FString> NamesNotAllowed;
+		for (const FAssetData& AssetData : SelectedAssets)
 		{
-			const FAssetData& AssetData = *AssetIt;
-			if (UTexture2D* Texture = Cast<UTexture2D>(AssetData.GetAsset()))
-				Textures.Add(Texture);
+			if (AssetData.AssetClass != UTexture2D::StaticClass()->GetFName())
+				continue;
+			bool bDecided;
+			bool bAllowed = FTextureToolUtils::CanDownScaleTexture(AssetData, bDecided);
+			if (!bDecided)
+				Undecided.Add(AssetData);
+			else if (bAllowed)
+				Textures.Add(AssetData);
+			else
+				NamesNotAllowed.Add(AssetData.AssetName.ToString());
 		}
 
-		TArray<UTexture2D*> TexturesNotAllowed;
-		for (auto TextureIt = Textures.CreateConstIterator(); TextureIt; ++TextureIt)
+		// Undecided textures are visited twice, once to validate and once to modify
+		FScopedSlowTask SlowTask(Undecided.Num() * 2 + Textures.Num(), LOCTEXT("DownScaleTextures", "DownScaling textures..."));
+		SlowTask.MakeDialog(true);
+
+		// Validation only reads, whatever it loaded is unloaded again and the allowed ones are reloaded to be modified
+		if (!LoadInBatches(Undecided, SlowTask, true, [&](UTexture2D* Texture)
+			{
+				if (FTextureToolUtils::CanDownScaleTexture(Texture))
+					Textures.Add(FAssetData(Texture));
+				else
+					NamesNotAllowed.Add(Texture->GetName());
+			}))
 		{
-			if (!FTextureToolUtils::CanDownScaleTexture(*TextureIt))
-				TexturesNotAllowed.Add(*TextureIt);
+			return;
 		}
 
-		if (TexturesNotAllowed.Num() != 0)
+		if (NamesNotAllowed.Num() != 0)
 		{
 			FString Names;
-			for (UTexture2D* Texture : TexturesNotAllowed)
+			for (const FString& Name : NamesNotAllowed)
 			{
-				Names.Append(Texture->GetName());
+				Names.Append(Name);
 				Names.AppendChar('\n');
 			}
 			auto ErrorText = FText::Format(FTextFormat::FromString("Maximum Texture Size cannot be changed for this texture as it is a non power of two size. Change the Power of Two Mode to allow it to be padded to a power of two.\n {0}"), FText::FromString(Names));
 			FMessageDialog::Open(EAppMsgType::Ok, ErrorText);
 			return;
 		}
-		else
+
+		LoadInBatches(Textures, SlowTask, false, [](UTexture2D* Texture)
+		{
+			FTextureToolUtils::DownScaleTexture(Texture);
+		});
+	}
+
+	/** Describe what Execute will do, from registry tags only */
+	FText GetPreviewText() const
+	{
+		int32 NumTextures = 0;
+		int32 NumNotAllowed = 0;
+		FIntPoint Largest = FIntPoint::ZeroValue;
+		for (const FAssetData& AssetData : SelectedAssets)
+		{
+			if (AssetData.AssetClass != UTexture2D::StaticClass()->GetFName())
+				continue;
+			++NumTextures;
+			bool bDecided;
+			if (!FTextureToolUtils::CanDownScaleTexture(AssetData, bDecided) && bDecided)
+				++NumNotAllowed;
+			FIntPoint Size;
+			if (FTextureToolUtils::GetSourceSize(AssetData, Size) && Size.X * Size.Y > Largest.X * Largest.Y)
+				Largest = Size;
+		}
+		return FText::Format(LOCTEXT("CB_Extension_Texture_DownScale_Preview", "Set texture half the texture size\n{0} texture(s), largest source {1} x {2}, {3} can't be downscaled"),
+			NumTextures, Largest.X, Largest.Y, NumNotAllowed);
+	}
+
+private:
+	/**
+	 * Load textures a batch at a time through the async loader, returns false if user cancelled.
+	 * Garbage is collected between batches, with bUnload the textures loaded by a batch and left clean are collected too.
+	 */
+	template<typename FuncType>
+	static bool LoadInBatches(const TArray<FAssetData>& Assets, FScopedSlowTask& SlowTask, bool bUnload, FuncType Func)
+	{
+		FTextureToolMemoryTracker Memory;
+		for (int32 Start = 0; Start < Assets.Num(); Start += DownScaleLoadBatchSize)
 		{
-			for (UTexture2D* Texture : Textures)
+			if (SlowTask.ShouldCancel())
+				return false;
+
+			const int32 End = FMath::Min(Start + DownScaleLoadBatchSize, Assets.Num());
+			TArray<int32> Requested;
+			for (int32 i = Start; i < End; ++i)
+			{
+				if (!Assets[i].IsAssetLoaded())
+				{
+					LoadPackageAsync(Assets[i].PackageName.ToString());
+					Requested.Add(i);
+				}
+			}
+			if (Requested.Num() > 0)
+			{
+				LLM_SCOPE(ELLMTag::Textures);
+				FlushAsyncLoading();
+			}
+
+			for (int32 i = Start; i < End; ++i)
+			{
+				SlowTask.EnterProgressFrame(1.f, FText::FromName(Assets[i].AssetName));
+				if (UTexture2D* Texture = Cast<UTexture2D>(Assets[i].GetAsset()))
+				{
+					Memory.Track(ETextureToolMemory::Sources, Texture);
+					Func(Texture);
+				}
+			}
+			Memory.Sample();
+
+			if (Requested.Num() == 0)
+				continue;
+			if (bUnload)
 			{
-				FTextureToolUtils::DownScaleTexture(Texture);
+				// Textures that were loaded before the batch or got modified by it are left alone
+				for (int32 i : Requested)
+				{
+					UObject* Asset = Assets[i].FastGetAsset();
+					if (Asset && !Asset->GetOutermost()->IsDirty())
+						Asset->ClearFlags(RF_Standalone);
+				}
 			}
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
 		}
+		Memory.Finish(TEXT("DownScale"));
+		return true;
 	}
 };
 
@@ -96,7 +199,7 @@ public:
 
 		MenuBuilder.AddMenuEntry(
 			LOCTEXT("CB_Extension_Texture_DownScale", "DownScale texture"),
-			LOCTEXT("CB_Extension_Texture_DownScale_Tooltip", "Set texture half the texture size"),
+			TextureConfigFunctor->GetPreviewText(),
 			FSlateIcon(PaperStyleSetName, "ClassIcon.Texture2D"),
 			Action_DownScaleTexture,
 			NAME_None,
@@ -17,6 +17,7 @@
 #include "TextureTool.h"
 #include "STextureToolUI.h"
 #include "Widgets/Docking/SDockTab.h"
+#include "TextureSelectionTracker.h"
 #define LOCTEXT_NAMESPACE "FTextureUtils"
 
 class FTextureToolLevelEditorExtentions_Impl
@@ -50,23 +51,8 @@ public:
 	{
 		TSharedRef<FExtender> Extender(new FExtender());
 
-		// Run thru the actors to determine if any meet our criteria
-		bool bWithMaterial = false;
-
-		for (AActor* Actor : SelectedActors)
-		{
-			for (UActorComponent* Component : Actor->GetComponents())
-			{
-				if (Component)
-				{
-					if (Component->IsA(UMeshComponent::StaticClass()) || Component->IsA(UDecalComponent::StaticClass()))
-					{
-						bWithMaterial = true;
-					}
-				}
-			}
-
-		}
+		// Selection tracker already knows whether any selected actor has materials
+		bool bWithMaterial = FTextureSelectionTracker::Get().HasActorWithMaterial();
 
 		if (bWithMaterial)
 		{
@@ -98,10 +84,14 @@ void FTextureToolLevelEditorExtentions::InstallHooks()
 	auto& MenuExtenders = LevelEditorModule.GetAllLevelViewportContextMenuExtenders();
 	MenuExtenders.Add(LevelEditorMenuExtenderDelegate);
 	LevelEditorExtenderDelegateHandle = MenuExtenders.Last().GetHandle();
+
+	FTextureSelectionTracker::Get().InstallHooks();
 }
 
 void FTextureToolLevelEditorExtentions::RemoveHooks()
 {
+	FTextureSelectionTracker::Get().RemoveHooks();
+
 	// Remove level viewport context menu extenders
 	if (FModuleManager::Get().IsModuleLoaded("LevelEditor"))
 	{
@@ -0,0 +1,190 @@
+#include "TextureToolStats.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Misc/DateTime.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "HAL/PlatformMemory.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectHash.h"
+#include "UObject/UObjectGlobals.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+static const TCHAR* MemoryCategoryNames[] = { TEXT("Sources"), TEXT("RenderTargets"), TEXT("TransientMaterials"), TEXT("Outputs") };
+static_assert(ARRAY_COUNT(MemoryCategoryNames) == (int32)ETextureToolMemory::Num, "Missing memory category name");
+
+FTextureToolMemoryTracker::FTextureToolMemoryTracker()
+{
+	StartUsedPhysical = UsedPhysical = PeakUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddLambda([this]() { bCollected = true; });
+}
+
+FTextureToolMemoryTracker::~FTextureToolMemoryTracker()
+{
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+}
+
+void FTextureToolMemoryTracker::Track(ETextureToolMemory Category, UObject* Object)
+{
+	if (!Object)
+		return;
+	FCategory& Tracked = Categories[(int32)Category];
+	const int64 Bytes = Object->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	if (int64* Known = Tracked.Objects.Find(Object))
+	{
+		Tracked.Bytes += Bytes - *Known;
+		*Known = Bytes;
+		return;
+	}
+	Tracked.Objects.Add(Object, Bytes);
+	++Tracked.Count;
+	Tracked.Bytes += Bytes;
+}
+
+void FTextureToolMemoryTracker::RemoveCollected()
+{
+	for (FCategory& Category : Categories)
+	{
+		for (auto It = Category.Objects.CreateIterator(); It; ++It)
+		{
+			if (It->Key.IsValid())
+				continue;
+			--Category.Count;
+			Category.Bytes -= It->Value;
+			It.RemoveCurrent();
+		}
+	}
+	bCollected = false;
+}
+
+void FTextureToolMemoryTracker::Sample()
+{
+	if (bCollected)
+		RemoveCollected();
+	for (FCategory& Category : Categories)
+		Category.PeakBytes = FMath::Max(Category.PeakBytes, Category.Bytes);
+
+	UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	PeakUsedPhysical = FMath::Max(PeakUsedPhysical, UsedPhysical);
+}
+
+void FTextureToolMemoryTracker::Finish(const FString& Name)
+{
+	// Garbage still waiting for a collection is not retained
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	// Leaked instances are the point, so they are found rather than tracked, once at the end as it walks the transient package
+	ForEachObjectWithOuter(GetTransientPackage(), [&](UObject* Object)
+	{
+		if (Object->IsA<UMaterialInstanceDynamic>() && !Object->IsPendingKill())
+			Track(ETextureToolMemory::TransientMaterials, Object);
+	}, false);
+	RemoveCollected();
+	Sample();
+
+	UE_LOG(LogTemp, Log, TEXT("%s: process memory peak %+.1f MB, retained %+.1f MB"), *Name,
+		((int64)PeakUsedPhysical - (int64)StartUsedPhysical) / (1024.0 * 1024.0), ((int64)UsedPhysical - (int64)StartUsedPhysical) / (1024.0 * 1024.0));
+	for (int32 Index = 0; Index < (int32)ETextureToolMemory::Num; ++Index)
+	{
+		const FCategory& Category = Categories[Index];
+		UE_LOG(LogTemp, Log, TEXT("%s: %-18s peak %8.1f MB, retained %8.1f MB in %lld objects"), *Name, MemoryCategoryNames[Index],
+			Category.PeakBytes / (1024.0 * 1024.0), Category.Bytes / (1024.0 * 1024.0), Category.Count);
+	}
+}
+
+TSharedRef<FJsonObject> FTextureToolMemoryTracker::ToJson() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("ProcessPeakBytes"), (double)((int64)PeakUsedPhysical - (int64)StartUsedPhysical));
+	Root->SetNumberField(TEXT("ProcessRetainedBytes"), (double)((int64)UsedPhysical - (int64)StartUsedPhysical));
+	for (int32 Index = 0; Index < (int32)ETextureToolMemory::Num; ++Index)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetNumberField(TEXT("PeakBytes"), (double)Categories[Index].PeakBytes);
+		Object->SetNumberField(TEXT("RetainedBytes"), (double)Categories[Index].Bytes);
+		Object->SetNumberField(TEXT("RetainedObjects"), (double)Categories[Index].Count);
+		Root->SetObjectField(MemoryCategoryNames[Index], Object);
+	}
+	return Root;
+}
+
+void FTextureToolBatchReport::AddStage(const TCHAR* Stage, double Seconds)
+{
+	for (auto& Pair : StageSeconds)
+	{
+		if (Pair.Key == Stage)
+		{
+			Pair.Value += Seconds;
+			return;
+		}
+	}
+	StageSeconds.Emplace(Stage, Seconds);
+}
+
+void FTextureToolBatchReport::AddGroup(double Seconds, int64 NumPixels)
+{
+	GroupSeconds.Add(Seconds);
+	TotalPixels += NumPixels;
+}
+
+void FTextureToolBatchReport::AddSaved(int32 NumPackages, int64 Bytes)
+{
+	SavedPackages += NumPackages;
+	SavedBytes += Bytes;
+}
+
+/** Nearest rank percentile of sorted values */
+static double GetPercentile(const TArray<double>& Sorted, double Percentile)
+{
+	if (Sorted.Num() == 0)
+		return 0.0;
+	const int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+	return Sorted[Index];
+}
+
+void FTextureToolBatchReport::Finish(const FString& Name, double TotalSeconds, const FTextureToolMemoryTracker* Memory)
+{
+	TArray<double> Sorted = GroupSeconds;
+	Sorted.Sort();
+	const double P50 = GetPercentile(Sorted, 0.5);
+	const double P95 = GetPercentile(Sorted, 0.95);
+	const double Max = Sorted.Num() > 0 ? Sorted.Last() : 0.0;
+	const double Megapixels = TotalPixels / 1000000.0;
+	const double Throughput = TotalSeconds > 0.0 ? Megapixels / TotalSeconds : 0.0;
+
+	UE_LOG(LogTemp, Log, TEXT("%s: %d groups in %.2f s, %.1f MP at %.2f MP/s"), *Name, GroupSeconds.Num(), TotalSeconds, Megapixels, Throughput);
+	UE_LOG(LogTemp, Log, TEXT("%s: group latency p50 %.1f ms, p95 %.1f ms, max %.1f ms"), *Name, P50 * 1000.0, P95 * 1000.0, Max * 1000.0);
+	for (const auto& Pair : StageSeconds)
+		UE_LOG(LogTemp, Log, TEXT("%s: %-16s %8.2f s (%4.1f%%)"), *Name, *Pair.Key, Pair.Value, TotalSeconds > 0.0 ? Pair.Value * 100.0 / TotalSeconds : 0.0);
+
+	const TPair<FString, double>* SaveStage = StageSeconds.FindByPredicate([](const TPair<FString, double>& Pair) { return Pair.Key == TEXT("Save"); });
+	const double SavedMegabytes = SavedBytes / (1024.0 * 1024.0);
+	const double SaveThroughput = SaveStage && SaveStage->Value > 0.0 ? SavedMegabytes / SaveStage->Value : 0.0;
+	if (SavedPackages > 0)
+		UE_LOG(LogTemp, Log, TEXT("%s: saved %d packages, %.1f MB at %.1f MB/s"), *Name, SavedPackages, SavedMegabytes, SaveThroughput);
+
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("Name"), Name);
+	Root->SetNumberField(TEXT("Groups"), GroupSeconds.Num());
+	Root->SetNumberField(TEXT("TotalSeconds"), TotalSeconds);
+	Root->SetNumberField(TEXT("Megapixels"), Megapixels);
+	Root->SetNumberField(TEXT("MegapixelsPerSecond"), Throughput);
+	Root->SetNumberField(TEXT("GroupP50Ms"), P50 * 1000.0);
+	Root->SetNumberField(TEXT("GroupP95Ms"), P95 * 1000.0);
+	Root->SetNumberField(TEXT("GroupMaxMs"), Max * 1000.0);
+	Root->SetNumberField(TEXT("SavedPackages"), SavedPackages);
+	Root->SetNumberField(TEXT("SavedBytes"), (double)SavedBytes);
+	Root->SetNumberField(TEXT("SaveMegabytesPerSecond"), SaveThroughput);
+	TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+	for (const auto& Pair : StageSeconds)
+		Stages->SetNumberField(Pair.Key, Pair.Value);
+	Root->SetObjectField(TEXT("StageSeconds"), Stages);
+	if (Memory)
+		Root->SetObjectField(TEXT("Memory"), Memory->ToJson());
+
+	FString Text;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Text);
+	FJsonSerializer::Serialize(Root, Writer);
+	const FString Path = FPaths::ProjectSavedDir() / TEXT("TextureTool") / FString::Printf(TEXT("%s-%s.json"), *Name, *FDateTime::Now().ToString());
+	if (!FFileHelper::SaveStringToFile(Text, *Path))
+		UE_LOG(LogTemp, Error, TEXT("Fail to write batch report %s"), *Path);
+}
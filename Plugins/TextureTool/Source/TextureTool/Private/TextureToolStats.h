@@ -0,0 +1,96 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "UObject/WeakObjectPtr.h"
+#include "HAL/LowLevelMemTracker.h"
+
+class FJsonObject;
+
+DECLARE_STATS_GROUP(TEXT("TextureTool"), STATGROUP_TextureTool, STATCAT_Advanced);
+
+enum class ETextureToolMemory : uint8
+{
+	/** Source textures loaded by the operation */
+	Sources,
+	RenderTargets,
+	/** Dynamic material instances living in the transient package, whoever created them, counted when the tracker finishes */
+	TransientMaterials,
+	/** Textures created by the operation */
+	Outputs,
+	Num,
+};
+
+/**
+ * Resource bytes per category and process memory, sampled at stage boundaries to find the peak.
+ * Sizes are taken when objects are tracked and summed as they go, so sampling costs the same whatever
+ * the number of objects. Collected objects are only dropped from the sums after a garbage collection.
+ */
+class FTextureToolMemoryTracker
+{
+public:
+	FTextureToolMemoryTracker();
+	~FTextureToolMemoryTracker();
+	/** Tracking an object again updates its size, outputs grow once they are built */
+	void Track(ETextureToolMemory Category, UObject* Object);
+	void Sample();
+	/** Collect garbage and sample once more, what is still alive is retained, then log peak and retained bytes */
+	void Finish(const FString& Name);
+	TSharedRef<FJsonObject> ToJson() const;
+
+private:
+	/** Drop objects collected since the last sample from the sums */
+	void RemoveCollected();
+
+	struct FCategory
+	{
+		TMap<TWeakObjectPtr<UObject>, int64> Objects;
+		int64 Count = 0;
+		int64 Bytes = 0;
+		int64 PeakBytes = 0;
+	};
+	FCategory Categories[(int32)ETextureToolMemory::Num];
+	uint64 StartUsedPhysical;
+	uint64 UsedPhysical;
+	uint64 PeakUsedPhysical;
+	bool bCollected = false;
+	FDelegateHandle PostGarbageCollectHandle;
+};
+
+/** Per stage totals and per group latencies of a batch merge, summarized at the end of the batch */
+class FTextureToolBatchReport
+{
+public:
+	void AddStage(const TCHAR* Stage, double Seconds);
+	/** One merged group, NumPixels is the size of the output texture */
+	void AddGroup(double Seconds, int64 NumPixels);
+	/** Packages written by the batch, throughput is taken against the "Save" stage */
+	void AddSaved(int32 NumPackages, int64 Bytes);
+	/** Log the summary and write it as JSON to Saved/TextureTool, with the memory report when given */
+	void Finish(const FString& Name, double TotalSeconds, const FTextureToolMemoryTracker* Memory = nullptr);
+
+private:
+	TArray<TPair<FString, double>> StageSeconds;
+	TArray<double> GroupSeconds;
+	int64 TotalPixels = 0;
+	int32 SavedPackages = 0;
+	int64 SavedBytes = 0;
+};
+
+/** Adds the time spent in its scope to a stage of a batch report, the report may be null */
+struct FTextureToolStageTimer
+{
+	FTextureToolStageTimer(FTextureToolBatchReport* InReport, const TCHAR* InStage)
+		: Report(InReport), Stage(InStage), StartTime(FPlatformTime::Seconds())
+	{
+	}
+	~FTextureToolStageTimer()
+	{
+		if (Report)
+			Report->AddStage(Stage, FPlatformTime::Seconds() - StartTime);
+	}
+
+private:
+	FTextureToolBatchReport* Report;
+	const TCHAR* Stage;
+	double StartTime;
+};
@@ -3,6 +3,9 @@
 #include "GameFramework/Actor.h"
 #include "Components/MeshComponent.h"
 #include "Components/DecalComponent.h"
+#include "AssetData.h"
+#include "AssetRegistryModule.h"
+#include "RHI.h"
 
 bool FTextureToolUtils::CanDownScaleTexture(UTexture2D* Texture2D)
 {
@@ -11,6 +14,61 @@ bool FTextureToolUtils::CanDownScaleTexture(UTexture2D* Texture2D)
 	return true;
 }
 
+bool FTextureToolUtils::GetSourceSize(const FAssetData& AssetData, FIntPoint& OutSize)
+{
+	static const FName DimensionsTag("Dimensions");
+	FString Dimensions, SizeX, SizeY;
+	if (!AssetData.GetTagValue(DimensionsTag, Dimensions) || !Dimensions.Split(TEXT("x"), &SizeX, &SizeY))
+		return false;
+	OutSize = FIntPoint(FCString::Atoi(*SizeX), FCString::Atoi(*SizeY));
+	return OutSize.X > 0 && OutSize.Y > 0;
+}
+
+EPixelFormat FTextureToolUtils::GetPixelFormat(const FAssetData& AssetData)
+{
+	static const FName FormatTag("Format");
+	FString FormatName;
+	if (!AssetData.GetTagValue(FormatTag, FormatName))
+		return PF_Unknown;
+	for (int32 Format = 0; Format < PF_MAX; ++Format)
+	{
+		if (FormatName == GPixelFormats[Format].Name)
+			return (EPixelFormat)Format;
+	}
+	return PF_Unknown;
+}
+
+int64 FTextureToolUtils::EstimateBytes(FIntPoint Size, EPixelFormat Format)
+{
+	const FPixelFormatInfo& Info = GPixelFormats[Format];
+	if (Format == PF_Unknown || Info.BlockBytes == 0 || Size.X <= 0 || Size.Y <= 0)
+		return 0;
+
+	int64 Bytes = 0;
+	for (;;)
+	{
+		Bytes += (int64)FMath::DivideAndRoundUp(Size.X, Info.BlockSizeX) * FMath::DivideAndRoundUp(Size.Y, Info.BlockSizeY) * Info.BlockBytes;
+		if (Size.X == 1 && Size.Y == 1)
+			break;
+		Size = FIntPoint(FMath::Max(Size.X / 2, 1), FMath::Max(Size.Y / 2, 1));
+	}
+	return Bytes;
+}
+
+bool FTextureToolUtils::CanDownScaleTexture(const FAssetData& AssetData, bool& bOutDecided)
+{
+	if (AssetData.IsAssetLoaded())
+	{
+		bOutDecided = true;
+		return CanDownScaleTexture(Cast<UTexture2D>(AssetData.GetAsset()));
+	}
+
+	// Power of two mode is not a registry tag, only non power of two sources need a load to decide
+	FIntPoint Size;
+	bOutDecided = GetSourceSize(AssetData, Size) && FMath::IsPowerOfTwo(Size.X) && FMath::IsPowerOfTwo(Size.Y);
+	return bOutDecided;
+}
+
 void FTextureToolUtils::DownScaleTexture(UTexture2D* Texture2D)
 {
 	auto OldSize = Texture2D->MaxTextureSize == 0 ? Texture2D->GetSizeX() : Texture2D->MaxTextureSize;
@@ -28,6 +86,15 @@ void FTextureToolUtils::ResetTextureSize(UTexture2D* Texture2D)
 	Texture2D->Modify();
 }
 
+void FTextureToolUtils::SetMaxTextureSize(UTexture2D* Texture2D, int32 Size)
+{
+	const int32 SourceSize = FMath::Max(Texture2D->Source.GetSizeX(), Texture2D->Source.GetSizeY());
+	FPropertyChangedEvent EditMaxSizeEvent(UTexture2D::StaticClass()->FindPropertyByName(GET_MEMBER_NAME_CHECKED(UTexture2D, MaxTextureSize)));
+	Texture2D->MaxTextureSize = Size < SourceSize ? Size : 0;
+	Texture2D->PostEditChangeProperty(EditMaxSizeEvent);
+	Texture2D->Modify();
+}
+
 TArray<UTexture2D*> FTextureToolUtils::FindTextures(AActor* Actor)
 {
 	TArray<UTexture2D*> Textures;
@@ -50,22 +117,43 @@ TArray<UTexture2D*> FTextureToolUtils::FindTextures(AActor* Actor)
 		}
 	};
 
+	for (UMaterialInterface* Material : FindMaterials(Actor))
+		GetTexture2Ds(Material);
+	return Textures;
+}
+
+TArray<UMaterialInterface*> FTextureToolUtils::FindMaterials(AActor* Actor)
+{
+	TArray<UMaterialInterface*> Materials;
 	for (UActorComponent* Component : Actor->GetComponents())
 	{
 		if (Component)
 		{
 			if (auto MeshComponent = Cast<UMeshComponent>(Component))
 			{
-				TArray<UMaterialInterface*> Materials = MeshComponent->GetMaterials();
-				for (auto Material : Materials)
-					GetTexture2Ds(Material);
+				for (auto Material : MeshComponent->GetMaterials())
+				{
+					if (Material)
+						Materials.Add(Material);
+				}
 			}
 			if (auto DecalComponent = Cast<UDecalComponent>(Component))
 			{
 				UMaterialInterface* Material = DecalComponent->GetDecalMaterial();
-				GetTexture2Ds(Material);
+				if (Material)
+					Materials.Add(Material);
 			}
 		}
 	}
-	return Textures;
+	return Materials;
+}
+
+TArray<FAssetData> FTextureToolUtils::GetTexturesInDirectory(const FString& Path, bool bRecursive)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::Get().LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssetsByPath(FName(*Path), Assets, bRecursive);
+	static const FName Texture2DClass("Texture2D");
+	Assets.RemoveAll([](const FAssetData& Asset) { return Asset.AssetClass != Texture2DClass; });
+	return Assets;
 }
@@ -0,0 +1,90 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "ReferencedAssetsUtils.h"
+#include "Engine/World.h"
+#include "Engine/LevelStreaming.h"
+#include "EngineUtils.h"
+#include "TextureToolStats.h"
+
+/** Reverse reference graph of a world, used to find the actors using an asset */
+struct WorldReferenceGenerator : public FFindReferencedAssets
+{
+	void BuildReferencingData(UWorld* World = GWorld)
+	{
+		DECLARE_SCOPE_CYCLE_COUNTER(TEXT("Build Referencing Data"), STAT_TextureTool_BuildReferencingData, STATGROUP_TextureTool);
+		MarkAllObjects();
+
+		const int32 MaxRecursionDepth = 0;
+		const bool bIncludeClasses = true;
+		const bool bIncludeDefaults = false;
+		const bool bReverseReferenceGraph = true;
+
+		// Generate the reference graph for the world
+		FReferencedAssets* WorldReferencer = new(Referencers)FReferencedAssets(World);
+		FFindAssetsArchive(World, WorldReferencer->AssetList, &ReferenceGraph, MaxRecursionDepth, bIncludeClasses, bIncludeDefaults, bReverseReferenceGraph);
+
+		// Also include all the streaming levels in the results
+		for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+		{
+			if (StreamingLevel)
+			{
+				if (ULevel* Level = StreamingLevel->GetLoadedLevel())
+				{
+					// Generate the reference graph for each streamed in level
+					FReferencedAssets* LevelReferencer = new(Referencers) FReferencedAssets(Level);
+					FFindAssetsArchive(Level, LevelReferencer->AssetList, &ReferenceGraph, MaxRecursionDepth, bIncludeClasses, bIncludeDefaults, bReverseReferenceGraph);
+				}
+			}
+		}
+
+		TArray<UObject*> ReferencedObjects;
+		// Special case for blueprints
+		for (AActor* Actor : FActorRange(World))
+		{
+			ReferencedObjects.Reset();
+			Actor->GetReferencedContentObjects(ReferencedObjects);
+			for (UObject* Reference : ReferencedObjects)
+			{
+				TSet<UObject*>& Objects = ReferenceGraph.FindOrAdd(Reference);
+				Objects.Add(Actor);
+			}
+		}
+	}
+
+	void MarkAllObjects()
+	{
+		// Mark all objects so we don't get into an endless recursion
+		for (FObjectIterator It; It; ++It)
+		{
+			It->Mark(OBJECTMARK_TagExp);
+		}
+	}
+
+	void Generate(const UObject* AssetToFind, TSet<const UObject*>& OutObjects)
+	{
+		// Don't examine visited objects
+		if (!AssetToFind->HasAnyMarks(OBJECTMARK_TagExp))
+		{
+			return;
+		}
+
+		AssetToFind->UnMark(OBJECTMARK_TagExp);
+
+		// Return once we find a parent object that is an actor
+		if (AssetToFind->IsA(AActor::StaticClass()))
+		{
+			OutObjects.Add(AssetToFind);
+			return;
+		}
+
+		// Traverse the reference graph looking for actor objects
+		TSet<UObject*>* ReferencingObjects = ReferenceGraph.Find(AssetToFind);
+		if (ReferencingObjects)
+		{
+			for (TSet<UObject*>::TConstIterator SetIt(*ReferencingObjects); SetIt; ++SetIt)
+			{
+				Generate(*SetIt, OutObjects);
+			}
+		}
+	}
+};
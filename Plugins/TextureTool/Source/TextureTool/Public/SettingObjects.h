@@ -1,34 +1,57 @@
 #pragma once
 #include "CoreMinimal.h"
 #include "Engine/EngineTypes.h"
+#include "Engine/Texture.h"
 #include "SettingObjects.generated.h"
 
-UENUM()
-enum class EChannel
+UENUM(BlueprintType)
+enum class EChannel : uint8
 {
 	R,G,B,A
 };
 
+/** How mips of a merged channel are filtered, Default leaves the mip chain to the texture build */
+UENUM(BlueprintType)
+enum class EMipFilter : uint8
+{
+	Default,
+	Box,
+	/** Kaiser windowed sinc, sharper than box */
+	Kaiser,
+	/** Largest texel, for heights and masks which must not shrink */
+	Max,
+	/** Box, then scaled so the share of texels above the coverage threshold matches mip 0, for alpha test */
+	Coverage,
+};
+
 class UTexture2D;
+class UTextureRenderTarget2D;
+class FTextureMergeJournal;
+class UTextureMergePreset;
 
-USTRUCT()
+USTRUCT(BlueprintType)
 struct FTextureChannelSrc
 {
 	GENERATED_BODY()
 public:
-	UPROPERTY(EditAnywhere, Category = Source, meta = (NoResetToDefault))
-	UTexture2D* Texture;
-	UPROPERTY(EditAnywhere, Category = Source)
-	EChannel Channel;
-	UPROPERTY(EditAnywhere, Category = Source)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Source, meta = (NoResetToDefault))
+	UTexture2D* Texture = nullptr;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Source)
+	EChannel Channel = EChannel::R;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Source)
 	bool Optional = true;
-	UPROPERTY(EditAnywhere, Category = Source)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Source)
 	FString Keyword;
+	/** Used by the CPU merge, when a channel is not Default the merge builds the whole mip chain */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Source)
+	EMipFilter MipFilter = EMipFilter::Default;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Source, meta = (ClampMin = 0, ClampMax = 1))
+	float CoverageThreshold = 0.5f;
 };
 
 
 UCLASS()
-class UTextureMergeSettings : public UObject
+class TEXTURETOOL_API UTextureMergeSettings : public UObject
 {
 	GENERATED_BODY()
 public:
@@ -56,11 +79,107 @@ public:
 	UPROPERTY(EditAnywhere, Category = Merge)
 	FTextureChannelSrc ReplaceTexture;
 
+	/** After merging, make materials sampling the sources sample the merged texture once with the matching channel */
+	UPROPERTY(EditAnywhere, Category = Merge)
+	bool bRewireMaterials;
+
+	/** Save batch outputs as they are merged instead of leaving thousands of dirty packages */
+	UPROPERTY(EditAnywhere, Category = Merge)
+	bool bSaveOutputs;
+
+	/** Outputs saved together, files of a chunk are written in the background while the next chunk is merged */
+	UPROPERTY(EditAnywhere, Category = Merge, meta = (EditCondition = "bSaveOutputs", ClampMin = 1))
+	int32 SaveChunkSize;
+
+	/**
+	 * Draw with the merge material into a full size RGBA16f render target, instead of copying source data band by band on the CPU.
+	 * Channels with their own mip filter are always merged on the CPU.
+	 */
+	UPROPERTY(EditAnywhere, Category = Merge, AdvancedDisplay)
+	bool bMergeOnGPU;
+
+	/** Compression of batch outputs merged on the CPU, HDR outputs and GPU merges are always TC_HDR */
+	UPROPERTY(EditAnywhere, Category = Merge, AdvancedDisplay)
+	TEnumAsByte<TextureCompressionSettings> OutputCompression;
+
+	/** Batch runs every preset in one pass over the input directory instead of the channels above, sources shared by presets are loaded and decoded once */
+	UPROPERTY(EditAnywhere, Category = Merge)
+	TArray<UTextureMergePreset*> Presets;
+
 	bool CanMerge() const;
 	bool CanBatch() const;
 	bool CanAutoKeyword() const;
+	/** Names of matched groups, prefixed by the preset path and "|" when batching presets */
 	bool Match(TArray<FString>& Names);
+	/** Preset and group of a matched name, the preset is null for the settings' own channels */
+	const UTextureMergePreset* SplitMatchedName(const FString& Name, FString& OutGroupName) const;
+	/** R, G, B, A then ReplaceTexture of the preset, or of the settings when it is null */
+	void GetChannels(const UTextureMergePreset* Preset, const FTextureChannelSrc* OutChannels[5]) const;
+	/** Object path of the source of a channel for a group */
+	FString GetSourceObjectPath(const FString& GroupName, const FTextureChannelSrc& Src) const;
+	/** Output asset name of a group, the preset's output keyword or else SaveKeyword replaces the matched keyword */
+	FString GetOutputName(const UTextureMergePreset* Preset, const FString& GroupName, const FString& SaveKeyword) const;
+	/** False if two matched names would write the same output, OutReason lists them */
+	bool CheckOutputNames(const TArray<FString>& MatchedNames, const FString& SaveKeyword, FText& OutReason) const;
 	void Merge();
+	/** Save the channels above as a preset asset, asks where */
+	void SaveAsPreset();
 	void Batch(const TArray<FString>& MatchedNames);
+	/** Merge every matched group not completed in the journal, returns false if cancelled, the journal is kept to resume */
+	bool ExecuteBatch(const TArray<FString>& MatchedNames, const FString& SavePackagePath, const FString& SaveKeyword, FTextureMergeJournal& Journal, TArray<UObject*>& Results);
+	/** Identifies the batch in the journal, a run with other settings starts over */
+	FString GetBatchFingerprint(const FString& SavePackagePath, const FString& SaveKeyword) const;
 	void AutoKeyword();
+};
+
+/** Named channel setup saved as an asset, several of them are batched together by UTextureMergeSettings::Presets */
+UCLASS(BlueprintType)
+class TEXTURETOOL_API UTextureMergePreset : public UObject
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, Category = Preset)
+	FTextureChannelSrc R;
+
+	UPROPERTY(EditAnywhere, Category = Preset)
+	FTextureChannelSrc G;
+
+	UPROPERTY(EditAnywhere, Category = Preset)
+	FTextureChannelSrc B;
+
+	UPROPERTY(EditAnywhere, Category = Preset)
+	FTextureChannelSrc A;
+
+	UPROPERTY(EditAnywhere, Category = Preset)
+	FTextureChannelSrc ReplaceTexture;
+
+	/** Replaces the matched keyword in output names, empty uses the name chosen when the batch starts */
+	UPROPERTY(EditAnywhere, Category = Preset)
+	FString OutputKeyword;
+
+	/** Channels of the settings, without their example textures */
+	void CopyFrom(const UTextureMergeSettings* Settings);
+};
+
+/** Draw channel Channels[i] of each source into channel i of RT, sources must share a power of two size, game thread only */
+TEXTURETOOL_API bool MergeTextures(UTextureRenderTarget2D* RT, UTexture2D* R, UTexture2D* G, UTexture2D* B, UTexture2D* A, const EChannel Channels[4], FText& FailReason);
+
+UCLASS()
+class UTextureAuditSettings : public UObject
+{
+	GENERATED_BODY()
+public:
+	static UTextureAuditSettings* Get();
+
+	UPROPERTY(EditAnywhere, Category = Audit, meta = (ContentDir))
+	FDirectoryPath Directory;
+
+	UPROPERTY(EditAnywhere, Category = Audit)
+	bool bRecursive = true;
+
+	/** Texel density "Analyze Texel Density" aims for, in texels per world unit (cm) */
+	UPROPERTY(EditAnywhere, Category = Audit, meta = (ClampMin = "0.01"))
+	float TargetTexelDensity = 5.12f;
+
+	bool CanScan() const;
 };
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/DataTable.h"
+#include "TextureAtlas.generated.h"
+
+class UTexture2D;
+
+/** Where a texture landed in an atlas, a material samples it at UV * UVScale + UVOffset */
+USTRUCT(BlueprintType)
+struct FTextureAtlasRect : public FTableRowBase
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Atlas)
+	TSoftObjectPtr<UTexture2D> Texture;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Atlas)
+	FVector2D UVOffset = FVector2D::ZeroVector;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Atlas)
+	FVector2D UVScale = FVector2D::UnitVector;
+	/** Texel rect of the texture in the atlas, padding excluded */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Atlas)
+	FIntPoint Position = FIntPoint::ZeroValue;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Atlas)
+	FIntPoint Size = FIntPoint::ZeroValue;
+};
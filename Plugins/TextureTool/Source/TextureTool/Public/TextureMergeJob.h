@@ -0,0 +1,140 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/Texture.h"
+#include "Async/Future.h"
+#include "UObject/GCObject.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Containers/Ticker.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "SettingObjects.h"
+#include "TextureMergeJob.generated.h"
+
+class UTexture2D;
+class FTextureSourceDecodeCache;
+
+/** One merge, independent of the merge settings, channel i of the output is channel Channel of source i */
+USTRUCT(BlueprintType)
+struct FTextureMergeJob
+{
+	GENERATED_BODY()
+public:
+	/** Texture and channel of each output channel, a channel without texture or not Optional is black, opaque for alpha */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	FTextureChannelSrc R;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	FTextureChannelSrc G;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	FTextureChannelSrc B;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	FTextureChannelSrc A;
+
+	/** Compression of the output, an HDR output is always TC_HDR */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	TEnumAsByte<TextureCompressionSettings> CompressionSettings = TC_Default;
+
+	/** Content path of the output package, empty creates a transient texture */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	FString PackagePath;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	FString AssetName;
+
+	/** Write the output package, files are written in the background */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Merge)
+	bool bSave = false;
+};
+
+USTRUCT(BlueprintType)
+struct FTextureMergeJobResult
+{
+	GENERATED_BODY()
+public:
+	/** Null when the merge failed */
+	UPROPERTY(BlueprintReadOnly, Category = Merge)
+	UTexture2D* Texture = nullptr;
+
+	UPROPERTY(BlueprintReadOnly, Category = Merge)
+	FText FailReason;
+
+	/** Keeps a transient Texture alive while a copy of the result does, released on the game thread. Outputs in packages are kept by their package */
+	TSharedPtr<TStrongObjectPtr<UTexture2D>, ESPMode::ThreadSafe> TextureReference;
+};
+
+/**
+ * Merges jobs on the CPU from texture source data. Jobs may be submitted from any thread, they run on the game thread
+ * as UObjects are created, a few at each tick or all at once with Flush. Sources shared by queued jobs are decoded once.
+ */
+class TEXTURETOOL_API FTextureMergeQueue : public FGCObject
+{
+public:
+	typedef TFunction<void(const TArray<FTextureMergeJobResult>&)> FOnJobsDone;
+
+	static FTextureMergeQueue& Get();
+	/** Called by the module, jobs still queued at shutdown are dropped with a failure */
+	static void Startup();
+	static void Shutdown();
+
+	/** One future per job, on the game thread they are only fulfilled by a later tick or by Flush */
+	TArray<TFuture<FTextureMergeJobResult>> Submit(const TArray<FTextureMergeJob>& Jobs);
+	/** OnDone runs on the game thread with the results in job order, once every job is done */
+	void Submit(const TArray<FTextureMergeJob>& Jobs, FOnJobsDone OnDone);
+	/** Run every queued job now, game thread only */
+	void Flush();
+	int32 GetNumQueued() const;
+
+	/** Run a single job right away, game thread only */
+	static FTextureMergeJobResult Run(const FTextureMergeJob& Job, FTextureSourceDecodeCache* DecodeCache = nullptr);
+
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+
+private:
+	struct FSubmission
+	{
+		TArray<FTextureMergeJobResult> Results;
+		int32 NumRemaining = 0;
+		FOnJobsDone OnDone;
+	};
+	struct FPendingJob
+	{
+		FTextureMergeJob Job;
+		TPromise<FTextureMergeJobResult> Promise;
+		TSharedPtr<FSubmission> Submission;
+		int32 Index = 0;
+	};
+
+	FTextureMergeQueue();
+	~FTextureMergeQueue();
+	void Enqueue(const TArray<FTextureMergeJob>& Jobs, TArray<TFuture<FTextureMergeJobResult>>* OutFutures, FOnJobsDone OnDone);
+	bool Tick(float DeltaTime);
+	/** Run jobs taken from Pending until the time runs out, at least one */
+	void RunJobs(double MaxSeconds);
+	void Complete(FPendingJob& Pending, const FTextureMergeJobResult& Result);
+
+	static FTextureMergeQueue* Instance;
+	/** Written by any thread */
+	mutable FCriticalSection PendingLock;
+	TArray<TUniquePtr<FPendingJob>> Pending;
+	/** Taken from Pending by the game thread, run from Next on */
+	TArray<TUniquePtr<FPendingJob>> Running;
+	int32 Next = 0;
+	TUniquePtr<FTextureSourceDecodeCache> DecodeCache;
+	bool bSaved = false;
+	FDelegateHandle TickHandle;
+};
+
+DECLARE_DYNAMIC_DELEGATE_OneParam(FOnTextureMergeJobsDone, const TArray<FTextureMergeJobResult>&, Results);
+
+/** Merge jobs for Blueprint and editor Python, unreal.TextureMergeLibrary.run_merge_jobs(jobs) */
+UCLASS()
+class TEXTURETOOL_API UTextureMergeLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+public:
+	/** Merge every job before returning, results are in job order */
+	UFUNCTION(BlueprintCallable, Category = "TextureTool|Merge")
+	static TArray<FTextureMergeJobResult> RunMergeJobs(const TArray<FTextureMergeJob>& Jobs);
+
+	/** Queue the jobs and return, OnDone is called once they are all merged */
+	UFUNCTION(BlueprintCallable, Category = "TextureTool|Merge")
+	static void SubmitMergeJobs(const TArray<FTextureMergeJob>& Jobs, const FOnTextureMergeJobsDone& OnDone);
+};
@@ -1,14 +1,31 @@
 #pragma once
 #include "CoreMinimal.h"
+#include "PixelFormat.h"
 
 class UTexture2D;
 class AActor;
 class UTexture2D;
+class UMaterialInterface;
+struct FAssetData;
 
 struct FTextureToolUtils
 {
 	static bool CanDownScaleTexture(UTexture2D* Texture);
+	/** Read source size from the asset registry "Dimensions" tag, never loads the texture */
+	static bool GetSourceSize(const FAssetData& AssetData, FIntPoint& OutSize);
+	/** Pixel format named by the asset registry "Format" tag, PF_Unknown when there is none */
+	static EPixelFormat GetPixelFormat(const FAssetData& AssetData);
+	/** Full mip chain of a Size texture in Format, 0 for unknown formats */
+	static int64 EstimateBytes(FIntPoint Size, EPixelFormat Format);
+	/** CanDownScaleTexture from registry tags, bOutDecided is false when the texture must be loaded to tell */
+	static bool CanDownScaleTexture(const FAssetData& AssetData, bool& bOutDecided);
 	static void DownScaleTexture(UTexture2D* Texture);
 	static void ResetTextureSize(UTexture2D* Texture);
+	/** MaxTextureSize is left at 0 when Size is not smaller than the texture */
+	static void SetMaxTextureSize(UTexture2D* Texture, int32 Size);
 	static TArray<UTexture2D*> FindTextures(AActor* Actor);
+	/** Materials of the actor's mesh and decal components, the ones FindTextures looks into */
+	static TArray<UMaterialInterface*> FindMaterials(AActor* Actor);
+	/** Texture2D assets under a content path, from the asset registry */
+	static TArray<FAssetData> GetTexturesInDirectory(const FString& Path, bool bRecursive);
 };
\ No newline at end of file
@@ -46,6 +46,9 @@ public class TextureTool : ModuleRules
 				"PropertyEditor",
 				"RHI",
 				"InputCore",
+				"ImageWrapper",
+				"MaterialEditor",
+				"Json",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
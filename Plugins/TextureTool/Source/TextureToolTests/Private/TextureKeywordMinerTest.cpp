@@ -0,0 +1,44 @@
+#include "TextureToolTestUtils.h"
+#include "TextureKeywordMiner.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureKeywordMinerTest, "TextureTool.Merge.KeywordMiner", TextureToolTestFlags)
+
+bool FTextureKeywordMinerTest::RunTest(const FString& Parameters)
+{
+	// Each material in its own folder, so material names never share a stem
+	const FString SrcPath = TEXT("/Game/Textures");
+	TArray<FString> PackageNames;
+	for (const TCHAR* Stem : { TEXT("Rock"), TEXT("Wood"), TEXT("Brick") })
+	{
+		for (const TCHAR* Keyword : { TEXT("_R"), TEXT("_M"), TEXT("_AO") })
+			PackageNames.Add(FString::Printf(TEXT("%s/%s/T_%s%s"), *SrcPath, Stem, Stem, Keyword));
+	}
+	PackageNames.Add(SrcPath / TEXT("Grass/T_Grass_R"));
+	PackageNames.Add(SrcPath / TEXT("Grass/T_Grass_M"));
+	// Numbered variations are not channels
+	PackageNames.Add(SrcPath / TEXT("Rock/T_Rock_02_R"));
+
+	TArray<FTextureKeywordProposal> Proposals;
+	TArray<FTextureKeywordStats> Stats;
+	FTextureKeywordMiner::Mine(SrcPath, PackageNames, Proposals, Stats);
+
+	const FTextureKeywordStats* R = Stats.FindByPredicate([](const FTextureKeywordStats& S) { return S.Keyword == TEXT("_R"); });
+	if (TestNotNull(TEXT("_R is a keyword"), R))
+	{
+		TestEqual(TEXT("_R suffixes"), R->NumSuffix, 5);
+		TestEqual(TEXT("_R shared stems"), R->NumSharedStems, 4);
+	}
+	TestFalse(TEXT("Numeric tokens are skipped"), Stats.ContainsByPredicate([](const FTextureKeywordStats& S) { return S.Keyword == TEXT("_02"); }));
+	TestEqual(TEXT("Stats are ranked by shared stems"), Stats.Num() > 0 ? Stats[0].NumSharedStems : 0, 4);
+
+	// R and M complete four groups, adding AO keeps three of them, no other set is closed
+	if (!TestEqual(TEXT("Proposals"), Proposals.Num(), 2))
+		return false;
+	TestEqual(TEXT("Most groups first"), Proposals[0].NumGroups, 4);
+	TestEqual(TEXT("Two channels"), Proposals[0].Keywords.Num(), 2);
+	TestTrue(TEXT("R and M"), Proposals[0].Keywords.Contains(TEXT("_R")) && Proposals[0].Keywords.Contains(TEXT("_M")));
+	TestEqual(TEXT("Then the larger set"), Proposals[1].NumGroups, 3);
+	TestEqual(TEXT("Three channels"), Proposals[1].Keywords.Num(), 3);
+	TestTrue(TEXT("AO"), Proposals[1].Keywords.Contains(TEXT("_AO")));
+	return true;
+}
@@ -0,0 +1,120 @@
+#include "TextureToolTestUtils.h"
+#include "SettingObjects.h"
+
+static void SetKeywords(FTextureChannelSrc* const Channels[5], const TCHAR* R, const TCHAR* G, const TCHAR* B)
+{
+	const TCHAR* Keywords[] = { R, G, B };
+	for (int32 i = 0; i < 3; ++i)
+	{
+		Channels[i]->Optional = Keywords[i] != nullptr;
+		Channels[i]->Keyword = Keywords[i] ? Keywords[i] : TEXT("");
+	}
+	Channels[3]->Optional = false;
+	Channels[4]->Optional = false;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureMergeMatchTest, "TextureTool.Merge.Match", TextureToolTestFlags)
+
+bool FTextureMergeMatchTest::RunTest(const FString& Parameters)
+{
+	FTextureToolTestRegistry Registry(TEXT("/Temp/TextureToolTests/Match"));
+	for (const TCHAR* Stem : { TEXT("Rock"), TEXT("Wood") })
+	{
+		for (const TCHAR* Keyword : { TEXT("_R"), TEXT("_M"), TEXT("_AO") })
+			Registry.Add(FString::Printf(TEXT("%s/T_%s%s"), Stem, Stem, Keyword));
+	}
+	// Incomplete group, and a keyword of the wrong case
+	Registry.Add(TEXT("Grass/T_Grass_R"));
+	Registry.Add(TEXT("Grass/T_Grass_m"));
+
+	UTextureMergeSettings* Settings = NewObject<UTextureMergeSettings>();
+	Settings->InputDirectory.Path = Registry.Root;
+	Settings->bRecursive = true;
+	FTextureChannelSrc* Channels[5] = { &Settings->R, &Settings->G, &Settings->B, &Settings->A, &Settings->ReplaceTexture };
+	SetKeywords(Channels, TEXT("_R"), TEXT("_M"), TEXT("_AO"));
+
+	TArray<FString> Names;
+	TestTrue(TEXT("Match finds groups"), Settings->Match(Names));
+	Names.Sort();
+	TestEqual(TEXT("Complete groups only"), Names.Num(), 2);
+	if (Names.Num() == 2)
+	{
+		TestEqual(TEXT("Group name"), Names[0], FString(TEXT("Rock/T_Rock***")));
+		TestEqual(TEXT("Group name"), Names[1], FString(TEXT("Wood/T_Wood***")));
+	}
+
+	// Without the AO channel the grass group is still incomplete, keywords are case sensitive
+	SetKeywords(Channels, TEXT("_R"), TEXT("_M"), nullptr);
+	Names.Reset();
+	Settings->Match(Names);
+	TestEqual(TEXT("Case sensitive keywords"), Names.Num(), 2);
+
+	// Presets of the same name in two folders are told apart by their path
+	UTextureMergePreset* Presets[2] = {
+		NewObject<UTextureMergePreset>(CreatePackage(nullptr, TEXT("/Temp/TextureToolTests/PresetsA/P_Pack")), TEXT("P_Pack"), RF_Transient),
+		NewObject<UTextureMergePreset>(CreatePackage(nullptr, TEXT("/Temp/TextureToolTests/PresetsB/P_Pack")), TEXT("P_Pack"), RF_Transient) };
+	for (UTextureMergePreset* Preset : Presets)
+	{
+		FTextureChannelSrc* PresetChannels[5] = { &Preset->R, &Preset->G, &Preset->B, &Preset->A, &Preset->ReplaceTexture };
+		SetKeywords(PresetChannels, TEXT("_R"), TEXT("_M"), nullptr);
+		Settings->Presets.Add(Preset);
+	}
+	Names.Reset();
+	Settings->Match(Names);
+	TestEqual(TEXT("Every preset matches"), Names.Num(), 4);
+	for (const FString& Name : Names)
+	{
+		FString GroupName;
+		const UTextureMergePreset* Preset = Settings->SplitMatchedName(Name, GroupName);
+		TestNotNull(TEXT("Preset of a matched name"), Preset);
+		TestTrue(TEXT("Group of a matched name"), GroupName == TEXT("Rock/T_Rock***") || GroupName == TEXT("Wood/T_Wood***"));
+	}
+	// Groups of the same name stay next to each other
+	if (Names.Num() == 4)
+	{
+		FString GroupA, GroupB;
+		Settings->SplitMatchedName(Names[0], GroupA);
+		Settings->SplitMatchedName(Names[1], GroupB);
+		TestEqual(TEXT("Shared groups are adjacent"), GroupA, GroupB);
+	}
+
+	for (UTextureMergePreset* Preset : Presets)
+		Preset->MarkPendingKill();
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureMergeOutputNameTest, "TextureTool.Merge.OutputNames", TextureToolTestFlags)
+
+bool FTextureMergeOutputNameTest::RunTest(const FString& Parameters)
+{
+	UTextureMergeSettings* Settings = NewObject<UTextureMergeSettings>();
+	UTextureMergePreset* PresetA = NewObject<UTextureMergePreset>(CreatePackage(nullptr, TEXT("/Temp/TextureToolTests/PresetsA/P_Pack")), TEXT("P_Pack"), RF_Transient);
+	UTextureMergePreset* PresetB = NewObject<UTextureMergePreset>(CreatePackage(nullptr, TEXT("/Temp/TextureToolTests/PresetsB/P_Pack")), TEXT("P_Pack"), RF_Transient);
+	Settings->Presets.Add(PresetA);
+	Settings->Presets.Add(PresetB);
+
+	TestEqual(TEXT("Save keyword replaces the matched keyword"), Settings->GetOutputName(nullptr, TEXT("Rock/T_Rock***"), TEXT("_RMA")), FString(TEXT("Rock/T_Rock_RMA")));
+	TestEqual(TEXT("Preset without output keyword"), Settings->GetOutputName(PresetA, TEXT("Rock/T_Rock***"), TEXT("_RMA")), FString(TEXT("Rock/T_Rock_RMA")));
+	PresetA->OutputKeyword = TEXT("_ORM");
+	TestEqual(TEXT("Preset output keyword"), Settings->GetOutputName(PresetA, TEXT("Rock/T_Rock***"), TEXT("_RMA")), FString(TEXT("Rock/T_Rock_ORM")));
+
+	FString GroupName;
+	TestTrue(TEXT("Split finds the preset by path"), Settings->SplitMatchedName(PresetB->GetPathName() + TEXT("|Rock/T_Rock***"), GroupName) == PresetB);
+	TestEqual(TEXT("Split group name"), GroupName, FString(TEXT("Rock/T_Rock***")));
+	TestNull(TEXT("Settings' own channels have no preset"), Settings->SplitMatchedName(TEXT("Rock/T_Rock***"), GroupName));
+
+	const TArray<FString> Names = {
+		PresetA->GetPathName() + TEXT("|Rock/T_Rock***"),
+		PresetB->GetPathName() + TEXT("|Rock/T_Rock***") };
+	FText Reason;
+	TestTrue(TEXT("Distinct output keywords do not collide"), Settings->CheckOutputNames(Names, TEXT("_RMA"), Reason));
+	PresetB->OutputKeyword = TEXT("_ORM");
+	TestFalse(TEXT("Same output keyword collides"), Settings->CheckOutputNames(Names, TEXT("_RMA"), Reason));
+	TestTrue(TEXT("Collision names the output"), Reason.ToString().Contains(TEXT("Rock/T_Rock_ORM")));
+
+	// Collected so the next run can create the presets again
+	PresetA->MarkPendingKill();
+	PresetB->MarkPendingKill();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return true;
+}
@@ -0,0 +1,66 @@
+#include "TextureToolTestUtils.h"
+#include "TextureMipChain.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureMipChainTest, "TextureTool.Merge.MipChain", TextureToolTestFlags)
+
+bool FTextureMipChainTest::RunTest(const FString& Parameters)
+{
+	TestEqual(TEXT("Mips of 8x8"), FTextureMipChain::GetNumMips(8, 8), 4);
+	TestEqual(TEXT("Mips of 8x2"), FTextureMipChain::GetNumMips(8, 2), 4);
+	TestEqual(TEXT("Mips of 1x1"), FTextureMipChain::GetNumMips(1, 1), 1);
+	const EMipFilter Defaults[4] = { EMipFilter::Default, EMipFilter::Default, EMipFilter::Default, EMipFilter::Default };
+	TestFalse(TEXT("Default filters leave the chain to the texture build"), FTextureMipChain::NeedsMipChain(Defaults));
+
+	// One filter per channel: R box, G max, B Kaiser, A coverage
+	const EMipFilter Filters[4] = { EMipFilter::Box, EMipFilter::Max, EMipFilter::Kaiser, EMipFilter::Coverage };
+	const float Thresholds[4] = { 0.5f, 0.5f, 0.5f, 0.5f };
+	TestTrue(TEXT("Filters need a merge built chain"), FTextureMipChain::NeedsMipChain(Filters));
+
+	const int32 Size = 8;
+	const int32 NumMips = FTextureMipChain::GetNumMips(Size, Size);
+	UTexture2D* Texture = NewObject<UTexture2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	Texture->Source.Init(Size, Size, 1, NumMips, TSF_BGRA8);
+	FColor* Mip0 = (FColor*)Texture->Source.LockMip(0);
+	for (int32 Y = 0; Y < Size; ++Y)
+	{
+		for (int32 X = 0; X < Size; ++X)
+		{
+			// A checker for the box, one lit texel per 2x2 block for max and coverage, a constant for Kaiser
+			const uint8 Checker = ((X + Y) & 1) ? 255 : 0;
+			const uint8 Sparse = ((X & 1) == 0 && (Y & 1) == 0) ? 255 : 0;
+			Mip0[Y * Size + X] = FColor(Checker, Sparse, 200, Sparse);
+		}
+	}
+	Texture->Source.UnlockMip(0);
+
+	if (!TestTrue(TEXT("Build"), FTextureMipChain::Build(Texture->Source, Filters, Thresholds)))
+		return false;
+
+	const FColor* Mip1 = (const FColor*)Texture->Source.LockMip(1);
+	int32 NumBox = 0, NumMax = 0, NumKaiser = 0, NumCoverage = 0;
+	const int32 NumPixels1 = (Size / 2) * (Size / 2);
+	for (int32 Pixel = 0; Pixel < NumPixels1; ++Pixel)
+	{
+		NumBox += FMath::Abs(Mip1[Pixel].R - 128) <= 1;
+		NumMax += Mip1[Pixel].G == 255;
+		NumKaiser += FMath::Abs(Mip1[Pixel].B - 200) <= 1;
+		// A box would give 64, every texel would fail the alpha test
+		NumCoverage += Mip1[Pixel].A >= 127;
+	}
+	Texture->Source.UnlockMip(1);
+	TestEqual(TEXT("Box averages the checker"), NumBox, NumPixels1);
+	TestEqual(TEXT("Max keeps the lit texel"), NumMax, NumPixels1);
+	TestEqual(TEXT("Kaiser keeps a constant"), NumKaiser, NumPixels1);
+	TestEqual(TEXT("Coverage keeps texels passing the threshold"), NumCoverage, NumPixels1);
+
+	const FColor* Last = (const FColor*)Texture->Source.LockMip(NumMips - 1);
+	TestEqual(TEXT("Max reaches the last mip"), (int32)Last->G, 255);
+	TestTrue(TEXT("Kaiser reaches the last mip"), FMath::Abs(Last->B - 200) <= 1);
+	Texture->Source.UnlockMip(NumMips - 1);
+
+	// Formats without a filter are refused, not written to
+	UTexture2D* Gray = NewObject<UTexture2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	Gray->Source.Init(Size, Size, 1, NumMips, TSF_G8);
+	TestFalse(TEXT("G8 is not filtered"), FTextureMipChain::Build(Gray->Source, Filters, Thresholds));
+	return true;
+}
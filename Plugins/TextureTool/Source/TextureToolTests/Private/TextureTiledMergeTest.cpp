@@ -0,0 +1,124 @@
+#include "TextureToolTestUtils.h"
+#include "TextureTiledMerge.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "TextureResource.h"
+#include "RenderingThread.h"
+#include "Misc/App.h"
+
+static const int32 MergeTestSize = 64;
+
+/** Four sources of different patterns, a channel is picked from each so every mapping is exercised */
+static void CreateMergeSources(UTexture2D* OutSources[4])
+{
+	OutSources[0] = CreateTestTexture(MergeTestSize, [](int32 X, int32 Y) { return FColor((uint8)(X * 4), (uint8)(Y * 4), (uint8)((X ^ Y) * 4), 255); });
+	OutSources[1] = CreateTestTexture(MergeTestSize, [](int32 X, int32 Y) { return FColor((uint8)(X * Y), (uint8)(X * 2 + Y), 17, 128); });
+	OutSources[2] = CreateTestTexture(MergeTestSize, [](int32 X, int32 Y) { return FColor(0, (uint8)(255 - X), (uint8)(Y * 3), (uint8)(X + Y)); });
+	OutSources[3] = CreateTestTexture(MergeTestSize, [](int32 X, int32 Y) { return FColor((uint8)(((X / 8 + Y / 8) & 1) * 255), 0, 255, (uint8)(255 - Y)); });
+}
+
+static const EChannel MergeTestChannels[4] = { EChannel::G, EChannel::R, EChannel::B, EChannel::A };
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureTiledMergeTest, "TextureTool.Merge.TiledMerge", TextureToolTestFlags)
+
+bool FTextureTiledMergeTest::RunTest(const FString& Parameters)
+{
+	UTexture2D* Sources[4];
+	CreateMergeSources(Sources);
+	FTextureChannelSrc Channels[4];
+	const FTextureChannelSrc* ChannelPtrs[4] = { &Channels[0], &Channels[1], &Channels[2], &Channels[3] };
+	for (int32 i = 0; i < 4; ++i)
+		Channels[i].Channel = MergeTestChannels[i];
+
+	TestEqual(TEXT("8 bit linear sources merge to BGRA8"), (int32)FTextureTiledMerge::GetOutputFormat(Sources, ChannelPtrs), (int32)TSF_BGRA8);
+	FText FailReason;
+	UTexture2D* Merged = FTextureTiledMerge::Merge(GetTransientPackage(), MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass()).ToString(), RF_Transient, Sources, ChannelPtrs, FailReason);
+	if (!TestNotNull(TEXT("Tiled merge"), Merged))
+	{
+		AddError(FailReason.ToString());
+		return false;
+	}
+
+	// Channel i of the output is Channels[i] of source i, source values are copied exactly
+	const FColor* Output = (const FColor*)Merged->Source.LockMip(0);
+	TArray<const FColor*> Inputs;
+	for (UTexture2D* Source : Sources)
+		Inputs.Add((const FColor*)Source->Source.LockMip(0));
+	auto GetChannel = [](const FColor& Color, EChannel Channel)
+	{
+		const uint8 Values[] = { Color.R, Color.G, Color.B, Color.A };
+		return Values[(int32)Channel];
+	};
+	int32 NumMismatches = 0;
+	for (int32 Pixel = 0; Pixel < MergeTestSize * MergeTestSize; ++Pixel)
+	{
+		const uint8 Expected[4] = {
+			GetChannel(Inputs[0][Pixel], MergeTestChannels[0]),
+			GetChannel(Inputs[1][Pixel], MergeTestChannels[1]),
+			GetChannel(Inputs[2][Pixel], MergeTestChannels[2]),
+			GetChannel(Inputs[3][Pixel], MergeTestChannels[3]) };
+		const FColor& Out = Output[Pixel];
+		if (Out.R != Expected[0] || Out.G != Expected[1] || Out.B != Expected[2] || Out.A != Expected[3])
+			++NumMismatches;
+	}
+	for (UTexture2D* Source : Sources)
+		Source->Source.UnlockMip(0);
+	Merged->Source.UnlockMip(0);
+	TestEqual(TEXT("Texels differing from their sources"), NumMismatches, 0);
+
+	// Size mismatch is refused with a reason
+	UTexture2D* Small = CreateTestTexture(MergeTestSize / 2, [](int32 X, int32 Y) { return FColor::White; });
+	UTexture2D* Mismatched[4] = { Sources[0], Small, nullptr, nullptr };
+	FailReason = FText::GetEmpty();
+	TestNull(TEXT("Sources of different sizes"), FTextureTiledMerge::Merge(GetTransientPackage(), MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass()).ToString(), RF_Transient, Mismatched, ChannelPtrs, FailReason));
+	TestFalse(TEXT("Failure has a reason"), FailReason.IsEmpty());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTextureTiledMergeGPUParityTest, "TextureTool.Merge.GPUParity", TextureToolTestFlags)
+
+bool FTextureTiledMergeGPUParityTest::RunTest(const FString& Parameters)
+{
+	if (!FApp::CanEverRender())
+	{
+		AddInfo(TEXT("No renderer, the GPU merge cannot be compared"));
+		return true;
+	}
+	UTexture2D* Sources[4];
+	CreateMergeSources(Sources);
+	FTextureChannelSrc Channels[4];
+	const FTextureChannelSrc* ChannelPtrs[4] = { &Channels[0], &Channels[1], &Channels[2], &Channels[3] };
+	for (int32 i = 0; i < 4; ++i)
+		Channels[i].Channel = MergeTestChannels[i];
+
+	FText FailReason;
+	UTexture2D* Merged = FTextureTiledMerge::Merge(GetTransientPackage(), MakeUniqueObjectName(GetTransientPackage(), UTexture2D::StaticClass()).ToString(), RF_Transient, Sources, ChannelPtrs, FailReason);
+	if (!TestNotNull(TEXT("Tiled merge"), Merged))
+		return false;
+
+	UTextureRenderTarget2D* RT = NewObject<UTextureRenderTarget2D>(GetTransientPackage());
+	RT->RenderTargetFormat = RTF_RGBA16f;
+	if (!TestTrue(TEXT("GPU merge"), MergeTextures(RT, Sources[0], Sources[1], Sources[2], Sources[3], MergeTestChannels, FailReason)))
+	{
+		AddError(FailReason.ToString());
+		return false;
+	}
+	FlushRenderingCommands();
+	TArray<FLinearColor> GPUPixels;
+	RT->GameThread_GetRenderTargetResource()->ReadLinearColorPixels(GPUPixels);
+	if (!TestEqual(TEXT("Render target size"), GPUPixels.Num(), MergeTestSize * MergeTestSize))
+		return false;
+
+	// Half floats hold 8 bit values to well within half a step
+	const float Tolerance = 0.5f / 255.f;
+	const FColor* CPUPixels = (const FColor*)Merged->Source.LockMip(0);
+	float MaxError = 0.f;
+	for (int32 Pixel = 0; Pixel < GPUPixels.Num(); ++Pixel)
+	{
+		const FLinearColor CPU = CPUPixels[Pixel].ReinterpretAsLinear();
+		const FLinearColor& GPU = GPUPixels[Pixel];
+		MaxError = FMath::Max(MaxError, FMath::Max(FMath::Max(FMath::Abs(CPU.R - GPU.R), FMath::Abs(CPU.G - GPU.G)), FMath::Max(FMath::Abs(CPU.B - GPU.B), FMath::Abs(CPU.A - GPU.A))));
+	}
+	Merged->Source.UnlockMip(0);
+	TestTrue(FString::Printf(TEXT("CPU and GPU merges differ by %f"), MaxError), MaxError <= Tolerance);
+	return true;
+}
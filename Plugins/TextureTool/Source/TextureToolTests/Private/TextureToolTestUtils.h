@@ -0,0 +1,61 @@
+#pragma once
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/Texture2D.h"
+#include "AssetRegistryModule.h"
+#include "Misc/Paths.h"
+
+static const uint32 TextureToolTestFlags = EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter;
+
+/** Textures registered under a temporary path so Match finds them, removed again when the scope ends */
+class FTextureToolTestRegistry
+{
+public:
+	explicit FTextureToolTestRegistry(const FString& InRoot) : Root(InRoot) {}
+	~FTextureToolTestRegistry()
+	{
+		for (UTexture2D* Texture : Textures)
+		{
+			FAssetRegistryModule::AssetDeleted(Texture);
+			Texture->ClearFlags(RF_Public | RF_Standalone);
+			Texture->MarkPendingKill();
+		}
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	/** Name is relative to the root, the asset name is its last part */
+	UTexture2D* Add(const FString& Name)
+	{
+		const FString PackageName = Root / Name;
+		const FString AssetName = FPaths::GetBaseFilename(PackageName);
+		UTexture2D* Texture = NewObject<UTexture2D>(CreatePackage(nullptr, *PackageName), *AssetName, RF_Public | RF_Standalone);
+		Texture->Source.Init(4, 4, 1, 1, TSF_G8);
+		FAssetRegistryModule::AssetCreated(Texture);
+		Textures.Add(Texture);
+		return Texture;
+	}
+
+	const FString Root;
+
+private:
+	TArray<UTexture2D*> Textures;
+};
+
+/** Uncompressed linear texture without mips, its platform data holds the source values exactly */
+inline UTexture2D* CreateTestTexture(int32 Size, TFunctionRef<FColor(int32 X, int32 Y)> Pixel)
+{
+	UTexture2D* Texture = NewObject<UTexture2D>(GetTransientPackage(), NAME_None, RF_Transient);
+	Texture->Source.Init(Size, Size, 1, 1, TSF_BGRA8);
+	FColor* Data = (FColor*)Texture->Source.LockMip(0);
+	for (int32 Y = 0; Y < Size; ++Y)
+	{
+		for (int32 X = 0; X < Size; ++X)
+			Data[Y * Size + X] = Pixel(X, Y);
+	}
+	Texture->Source.UnlockMip(0);
+	Texture->CompressionSettings = TC_VectorDisplacementmap;
+	Texture->MipGenSettings = TMGS_NoMipmaps;
+	Texture->SRGB = false;
+	Texture->PostEditChange();
+	return Texture;
+}
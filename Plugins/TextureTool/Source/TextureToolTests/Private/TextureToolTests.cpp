@@ -0,0 +1,7 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+/** Automation tests of TextureTool, run them from Session Frontend or with -ExecCmds="Automation RunTests TextureTool" */
+IMPLEMENT_MODULE(FDefaultModuleImpl, TextureToolTests)